@@ -0,0 +1,982 @@
+#define _POSIX_C_SOURCE 199309L
+#include <raylib.h>
+#include <raymath.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define TREE3D_IMPLEMENTATION
+#define BUSH3D_IMPLEMENTATION
+#define FOREST3D_IMPLEMENTATION
+#include "forest3d.h"
+#define TREE_IMPLEMENTATION
+#include "tree2d.h"
+#define TREEPACK_IMPLEMENTATION
+#include "treepack.h"
+#define TREECACHE_IMPLEMENTATION
+#include "treecache.h"
+#define TREESPECIES_IMPLEMENTATION
+#include "treespecies.h"
+#define TREESTREAM_IMPLEMENTATION
+#include "treestream.h"
+#include "stub_draw.h"
+
+// Headless benchmarks. Every case runs against the stub draw layer, so draw
+// timings are the CPU cost of culling, batching and submitting only. Checks
+// alongside them pin down output the optimizations must not change, and a
+// failed check makes the run exit non-zero.
+//
+// Usage: bench [output.json] [--quick]
+
+#define BENCH_MAX_RESULTS 64
+#define BENCH_MIN_ITERATIONS 5
+#define BENCH_MAX_ITERATIONS 100000
+
+typedef struct {
+    char name[48];
+    const char *param;      // What `value` counts: rows, trees, bushes
+    int value;
+    int iterations;
+    double minUs;           // Per operation
+    double meanUs;
+    long items;             // Branches, trees or bushes handled per operation
+    long drawCalls;         // Submitted per operation, from the stub layer
+    double started;
+    double totalSeconds;
+} BenchResult;
+
+static BenchResult benchResults[BENCH_MAX_RESULTS];
+static int benchResultCount = 0;
+static double benchMinSeconds = 0.25;
+static int benchFailures = 0;
+
+static const int benchRows[] = {6, 9, 12, 15};
+static const int benchForestSizes[] = {50, 200, 800};
+static const int benchBushCounts[] = {1, 100, 1000};
+
+#define BENCH_COUNT(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+static double BenchNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static BenchResult* BenchBegin(const char *name, const char *param, int value) {
+    if (benchResultCount >= BENCH_MAX_RESULTS) {
+        fprintf(stderr, "Too many benchmark results\n");
+        exit(1);
+    }
+
+    BenchResult *r = &benchResults[benchResultCount++];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->param = param;
+    r->value = value;
+    r->minUs = 1e30;
+    r->started = BenchNow();
+    return r;
+}
+
+// Keep sampling until the case has run long enough, setup included
+static bool BenchContinue(const BenchResult *r) {
+    if (r->iterations < BENCH_MIN_ITERATIONS) return true;
+    if (r->iterations >= BENCH_MAX_ITERATIONS) return false;
+    return BenchNow() - r->started < benchMinSeconds;
+}
+
+// Record one timed sample covering `ops` operations
+static void BenchSample(BenchResult *r, double seconds, int ops) {
+    double us = seconds * 1e6 / ops;
+    if (us < r->minUs) r->minUs = us;
+    r->totalSeconds += seconds / ops;
+    r->iterations++;
+    r->meanUs = r->totalSeconds * 1e6 / r->iterations;
+}
+
+// Self-checks
+static void BenchCheck(bool ok, const char *what) {
+    if (ok) return;
+    fprintf(stderr, "Check failed: %s\n", what);
+    benchFailures++;
+}
+
+// FNV-1a
+static uint64_t BenchHash(uint64_t hash, const void *data, size_t bytes) {
+    const unsigned char *p = (const unsigned char*)data;
+    for (size_t i = 0; i < bytes; i++) {
+        hash = (hash ^ p[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+#define BENCH_HASH_SEED 0xCBF29CE484222325ULL
+
+// memcmp that allows the empty, possibly NULL arrays of a tree without them
+static bool BenchSameBytes(const void *a, const void *b, size_t bytes) {
+    return bytes == 0 || memcmp(a, b, bytes) == 0;
+}
+
+// Leaves carry padding, so they are compared field by field
+static bool BenchSameLeaf(const Tree3DLeaf *a, const Tree3DLeaf *b) {
+    return a->Row == b->Row && memcmp(&a->V1, &b->V1, sizeof(Vector3)) == 0 &&
+        memcmp(&a->V2, &b->V2, sizeof(Vector3)) == 0 && memcmp(&a->Radius, &b->Radius, sizeof(float)) == 0 &&
+        memcmp(&a->Color, &b->Color, sizeof(Color)) == 0 && a->isActive == b->isActive;
+}
+
+// Same rows, branches and leaves, wherever each tree keeps them
+static bool BenchSameTree3D(const Tree3D *a, const Tree3D *b) {
+    if (a->CurrentRow != b->CurrentRow || a->memPool.branchPoolIndex != b->memPool.branchPoolIndex ||
+        a->memPool.leafPoolIndex != b->memPool.leafPoolIndex) return false;
+
+    size_t rows = (size_t)(a->CurrentRow + 1);
+    if (memcmp(a->RowOffsets, b->RowOffsets, rows * sizeof(int)) != 0) return false;
+    if (memcmp(a->BranchCount, b->BranchCount, rows * sizeof(int)) != 0) return false;
+
+    const Tree3DBranchStreams *sa = &a->memPool.branches, *sb = &b->memPool.branches;
+    size_t n = a->memPool.branchPoolIndex;
+    const float *fa[7] = {sa->x1, sa->y1, sa->z1, sa->x2, sa->y2, sa->z2, sa->width};
+    const float *fb[7] = {sb->x1, sb->y1, sb->z1, sb->x2, sb->y2, sb->z2, sb->width};
+    for (int i = 0; i < 7; i++) {
+        if (memcmp(fa[i], fb[i], n * sizeof(float)) != 0) return false;
+    }
+    if (memcmp(sa->nodes, sb->nodes, n * sizeof(Tree3DBranchNode)) != 0) return false;
+
+    for (size_t i = 0; i < a->memPool.leafPoolIndex; i++) {
+        if (!BenchSameLeaf(&a->memPool.leafPool[i], &b->memPool.leafPool[i])) return false;
+    }
+    return true;
+}
+
+// BenchSameTree3D plus every field a pack stores, for a tree loaded back
+// with TreePackLoadTree3D. Bounds are compared settled, as the pack saves them.
+static bool BenchSamePackedTree3D(Tree3D *tree, const Tree3D *packed) {
+    if (!BenchSameTree3D(tree, packed)) return false;
+    Tree3DUpdateBounds(tree);
+
+    bool same = tree->Seed == packed->Seed && tree->rngState == packed->rngState &&
+        tree->growKey == packed->growKey && tree->LeafChance == packed->LeafChance &&
+        tree->Scale == packed->Scale && tree->Width == packed->Width && tree->Height == packed->Height &&
+        tree->X == packed->X && tree->Y == packed->Y && tree->Z == packed->Z &&
+        tree->MaxRow == packed->MaxRow && tree->generateRow == packed->generateRow &&
+        tree->SplitChance == packed->SplitChance && tree->SplitAngle[0] == packed->SplitAngle[0] &&
+        tree->SplitAngle[1] == packed->SplitAngle[1] && tree->GrowTimer == packed->GrowTimer &&
+        tree->GrowTime == packed->GrowTime && tree->LeafCount == packed->LeafCount &&
+        BenchSameBytes(tree->CsBranch, packed->CsBranch, sizeof(tree->CsBranch)) &&
+        BenchSameBytes(tree->CsLeaf, packed->CsLeaf, sizeof(tree->CsLeaf)) &&
+        tree->droppedBranches == packed->droppedBranches && tree->droppedLeaves == packed->droppedLeaves &&
+        BenchSameBytes(&tree->bounds, &packed->bounds, sizeof(BoundingBox));
+    if (!same) return false;
+
+    if (tree->depthOrderCount != packed->depthOrderCount || tree->canopyCount != packed->canopyCount ||
+        tree->canopyLeaves != packed->canopyLeaves || tree->bvh.nodeCount != packed->bvh.nodeCount ||
+        tree->bvh.builtRows != packed->bvh.builtRows || tree->baked.vertexCount != packed->baked.vertexCount ||
+        tree->baked.bakedRows != packed->baked.bakedRows || tree->baked.bakedLeaves != packed->baked.bakedLeaves) {
+        return false;
+    }
+    size_t bvhRows = (size_t)tree->bvh.builtRows;
+    size_t vertices = (size_t)tree->baked.vertexCount;
+    return BenchSameBytes(tree->depthOrder, packed->depthOrder, (size_t)tree->depthOrderCount * sizeof(uint32_t)) &&
+        BenchSameBytes(tree->canopy, packed->canopy, (size_t)tree->canopyCount * sizeof(Tree3DCanopyBlob)) &&
+        BenchSameBytes(tree->bvh.nodes, packed->bvh.nodes, (size_t)tree->bvh.nodeCount * sizeof(Tree3DBVHNode)) &&
+        BenchSameBytes(tree->bvh.rowBranchRoot, packed->bvh.rowBranchRoot, bvhRows * sizeof(int)) &&
+        BenchSameBytes(tree->bvh.rowLeafRoot, packed->bvh.rowLeafRoot, bvhRows * sizeof(int)) &&
+        BenchSameBytes(tree->bvh.rowBounds, packed->bvh.rowBounds, bvhRows * sizeof(BoundingBox)) &&
+        BenchSameBytes(tree->baked.vertices, packed->baked.vertices, vertices * 3 * sizeof(float)) &&
+        BenchSameBytes(tree->baked.colors, packed->baked.colors, vertices * 4);
+}
+
+// A Tree loaded back with TreePackLoadTree. Rows and leaves have no padding.
+static bool BenchSamePackedTree(const Tree *tree, const Tree *packed) {
+    if (tree->CurrentRow != packed->CurrentRow || tree->LeafCount != packed->LeafCount) return false;
+    int rows = tree->CurrentRow + 1 < MAX_ROWS ? tree->CurrentRow + 1 : MAX_ROWS;
+    for (int i = 0; i < rows; i++) {
+        if (tree->BranchCount[i] != packed->BranchCount[i]) return false;
+        if (!BenchSameBytes(tree->Branches[i], packed->Branches[i], (size_t)tree->BranchCount[i] * sizeof(TreeBranch))) return false;
+    }
+    return BenchSameBytes(tree->Leaves, packed->Leaves, (size_t)tree->LeafCount * sizeof(TreeLeaf)) &&
+        tree->Seed == packed->Seed && tree->rngState == packed->rngState &&
+        tree->LeafChance == packed->LeafChance && tree->Width == packed->Width &&
+        tree->Height == packed->Height && tree->X == packed->X && tree->Y == packed->Y &&
+        tree->LeftX == packed->LeftX && tree->RightX == packed->RightX && tree->MaxRow == packed->MaxRow &&
+        tree->SplitChance == packed->SplitChance && tree->SplitAngle[0] == packed->SplitAngle[0] &&
+        tree->SplitAngle[1] == packed->SplitAngle[1] && tree->GrowTimer == packed->GrowTimer &&
+        tree->GrowTime == packed->GrowTime && tree->RandomRow == packed->RandomRow &&
+        BenchSameBytes(tree->CsBranch, packed->CsBranch, sizeof(tree->CsBranch)) &&
+        BenchSameBytes(tree->CsLeaf, packed->CsLeaf, sizeof(tree->CsLeaf)) &&
+        tree->droppedBranches == packed->droppedBranches && tree->droppedLeaves == packed->droppedLeaves;
+}
+
+// A bush handed out by TreePackGetBush; the impostor is not stored
+static bool BenchSamePackedBush(const Bush3D *bush, const Bush3D *packed) {
+    return bush->X == packed->X && bush->Y == packed->Y && bush->Z == packed->Z &&
+        bush->Scale == packed->Scale && bush->MaxBranches == packed->MaxBranches &&
+        bush->GrowTime == packed->GrowTime && bush->CurrentGrowTime == packed->CurrentGrowTime &&
+        bush->IsMature == packed->IsMature && bush->LeafCount == packed->LeafCount &&
+        bush->LeafSize == packed->LeafSize && bush->HasBerries == packed->HasBerries &&
+        bush->BerryCount == packed->BerryCount && bush->BerrySize == packed->BerrySize &&
+        bush->BurnLevel == packed->BurnLevel && bush->IsBurned == packed->IsBurned &&
+        bush->branchCount == packed->branchCount && bush->seed == packed->seed &&
+        bush->impostorDistance == packed->impostorDistance && packed->impostor == NULL &&
+        BenchSameBytes(bush->ColorLeafMin, packed->ColorLeafMin, 3) &&
+        BenchSameBytes(bush->ColorLeafMax, packed->ColorLeafMax, 3) &&
+        BenchSameBytes(bush->ColorBranch, packed->ColorBranch, 3) &&
+        BenchSameBytes(bush->ColorBerry, packed->ColorBerry, 3) &&
+        BenchSameBytes(bush->branches, packed->branches, (size_t)bush->branchCount * sizeof(bush->branches[0])) &&
+        BenchSameBytes(bush->leaves, packed->leaves, (size_t)bush->LeafCount * sizeof(BushLeaf)) &&
+        BenchSameBytes(bush->berries, packed->berries, (size_t)bush->BerryCount * sizeof(BushBerry)) &&
+        BenchSameBytes(&bush->bounds, &packed->bounds, sizeof(BoundingBox));
+}
+
+// What BenchSameTree3D compares, for trees that do not outlive the check
+static uint64_t BenchHashTree3D(const Tree3D *tree) {
+    size_t rows = (size_t)(tree->CurrentRow + 1);
+    size_t n = tree->memPool.branchPoolIndex;
+    const Tree3DBranchStreams *streams = &tree->memPool.branches;
+    uint64_t hash = BenchHash(BENCH_HASH_SEED, tree->RowOffsets, rows * sizeof(int));
+    hash = BenchHash(hash, tree->BranchCount, rows * sizeof(int));
+    const float *floats[7] = {streams->x1, streams->y1, streams->z1, streams->x2, streams->y2, streams->z2, streams->width};
+    for (int i = 0; i < 7; i++) hash = BenchHash(hash, floats[i], n * sizeof(float));
+    hash = BenchHash(hash, streams->nodes, n * sizeof(Tree3DBranchNode));
+
+    for (size_t i = 0; i < tree->memPool.leafPoolIndex; i++) {
+        const Tree3DLeaf *leaf = &tree->memPool.leafPool[i];
+        hash = BenchHash(hash, &leaf->Row, sizeof(leaf->Row));
+        hash = BenchHash(hash, &leaf->V1, sizeof(Vector3));
+        hash = BenchHash(hash, &leaf->V2, sizeof(Vector3));
+        hash = BenchHash(hash, &leaf->Radius, sizeof(float));
+        hash = BenchHash(hash, &leaf->Color, sizeof(Color));
+        hash = BenchHash(hash, &leaf->isActive, sizeof(bool));
+    }
+    return hash;
+}
+
+// One hash over every tree of the chunk under (x, z), 0 while it is not resident
+static uint64_t BenchHashStreamChunk(Tree3DStream *stream, float x, float z, int *count) {
+    Tree3D *trees = Tree3DStreamGetTrees(stream, x, z, count);
+    if (!trees) return 0;
+    uint64_t hash = BENCH_HASH_SEED;
+    for (int i = 0; i < *count; i++) {
+        uint64_t treeHash = BenchHashTree3D(&trees[i]);
+        hash = BenchHash(hash, &treeHash, sizeof(treeHash));
+    }
+    return hash;
+}
+
+static long BenchBranchCount(const Tree3D *tree) {
+    long count = 0;
+    for (int i = 0; i <= tree->CurrentRow && i < tree->AllocatedRows; i++) count += tree->BranchCount[i];
+    return count;
+}
+
+static Camera3D BenchCamera(Vector3 position, Vector3 target) {
+    Camera3D camera = {0};
+    camera.position = position;
+    camera.target = target;
+    camera.up = (Vector3){0.0f, 1.0f, 0.0f};
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+    return camera;
+}
+
+static Tree3D BenchNewTree3D(int rows) {
+    Tree3D tree = Tree3DNewTree();
+    tree.MaxRow = rows;
+    tree.Seed = 1234;
+    tree.GrowTime = 0;
+    tree.RandomRow = false;
+    return tree;
+}
+
+static Tree3D BenchGrownTree3D(int rows, Tree3DRenderMode mode, bool baked) {
+    Tree3D tree = BenchNewTree3D(rows);
+    tree.renderMode = mode;
+    tree.useBakedMesh = baked;
+    Tree3DLoad(&tree);
+    while (tree.CurrentRow < tree.MaxRow) Tree3DGrow(&tree);
+    if (baked) Tree3DBakeRows(&tree, tree.CurrentRow + 1);
+    tree.GrowTimer = 0;
+    return tree;
+}
+
+// Tree3D
+static void BenchTree3DNew(void) {
+    BenchResult *r = BenchBegin("tree3d_new_tree", "trees", 1000);
+    volatile float sink = 0.0f;
+    while (BenchContinue(r)) {
+        double start = BenchNow();
+        for (int i = 0; i < 1000; i++) {
+            Tree3D tree = Tree3DNewTree();
+            sink += tree.Scale;
+        }
+        BenchSample(r, BenchNow() - start, 1000);
+    }
+    r->items = 1;
+}
+
+static void BenchTree3DLoadAndGrow(int rows) {
+    BenchResult *load = BenchBegin("tree3d_load", "rows", rows);
+    while (BenchContinue(load)) {
+        Tree3D tree = BenchNewTree3D(rows);
+        double start = BenchNow();
+        Tree3DLoad(&tree);
+        BenchSample(load, BenchNow() - start, 1);
+        Tree3DFree(&tree);
+    }
+    load->items = 1;
+
+    BenchResult *grow = BenchBegin("tree3d_grow", "rows", rows);
+    while (BenchContinue(grow)) {
+        Tree3D tree = BenchNewTree3D(rows);
+        Tree3DLoad(&tree);
+
+        double start = BenchNow();
+        while (tree.CurrentRow < tree.MaxRow) Tree3DGrow(&tree);
+        BenchSample(grow, BenchNow() - start, 1);
+
+        grow->items = BenchBranchCount(&tree);
+        Tree3DFree(&tree);
+    }
+}
+
+// The camera sits `distance` bounding box diagonals away from the tree
+static void BenchTree3DDraw(const char *name, int rows, Tree3DRenderMode mode, bool baked, float distance) {
+    Tree3D tree = BenchGrownTree3D(rows, mode, baked);
+    Tree3DUpdateBounds(&tree);
+
+    Vector3 center = Vector3Scale(Vector3Add(tree.bounds.min, tree.bounds.max), 0.5f);
+    float radius = Vector3Distance(tree.bounds.min, tree.bounds.max) * distance;
+    Camera3D camera = BenchCamera(Vector3Add(center, (Vector3){radius, radius * 0.5f, radius}), center);
+    tree.cullDistance = fmaxf(tree.cullDistance, 2.0f * Vector3Distance(camera.position, center));
+
+    BenchResult *r = BenchBegin(name, "rows", rows);
+    while (BenchContinue(r)) {
+        StubDrawReset();
+        double start = BenchNow();
+        Tree3DBatchDraw(&tree, camera);
+        BenchSample(r, BenchNow() - start, 1);
+        r->drawCalls = StubDrawCallCount();
+    }
+    r->items = BenchBranchCount(&tree);
+    Tree3DFree(&tree);
+}
+
+// The baked mesh of a fixed seed, against the vertex count and hash it was
+// recorded with. Update both when the generator changes on purpose.
+#define BENCH_BAKED_ROWS 12
+#define BENCH_BAKED_VERTICES 112896
+#define BENCH_BAKED_HASH 0xDCB72454F3E64EEAULL
+
+static void BenchCheckBakedMesh(void) {
+    Tree3D tree = BenchGrownTree3D(BENCH_BAKED_ROWS, TREE3D_RENDER_INSTANCED, true);
+    const Tree3DBakedMesh *baked = &tree.baked;
+    uint64_t hash = BenchHash(BENCH_HASH_SEED, baked->vertices, (size_t)baked->vertexCount * 3 * sizeof(float));
+    hash = BenchHash(hash, baked->colors, (size_t)baked->vertexCount * 4);
+
+    printf("baked mesh: %d vertices, hash 0x%016llX\n", baked->vertexCount, (unsigned long long)hash);
+    BenchCheck(baked->vertexCount == BENCH_BAKED_VERTICES, "baked vertex count of the fixed seed");
+    BenchCheck(hash == BENCH_BAKED_HASH, "baked vertex hash of the fixed seed");
+    Tree3DFree(&tree);
+}
+
+static void BenchTree3DCanopy(int rows) {
+    Tree3D tree = BenchGrownTree3D(rows, TREE3D_RENDER_INSTANCED, false);
+
+    BenchResult *r = BenchBegin("tree3d_build_canopy", "rows", rows);
+    while (BenchContinue(r)) {
+        double start = BenchNow();
+        Tree3DBuildCanopy(&tree);
+        BenchSample(r, BenchNow() - start, 1);
+    }
+    r->items = BenchBranchCount(&tree);
+    Tree3DFree(&tree);
+}
+
+// Forest
+// Save trees and bushes to a pack, load every entry back and compare it
+// with what was saved
+static void BenchCheckPack(Tree3D *tree3ds, int tree3dCount, const Tree *trees, int treeCount,
+                           const Bush3D *bushes, int bushCount) {
+    const char *path = "bench_check.pack";
+    TreePack *pack = TreePackSave(path, tree3ds, tree3dCount, trees, treeCount, bushes, bushCount)
+                   ? TreePackOpen(path) : NULL;
+    BenchCheck(pack != NULL, "pack saved and opened");
+    if (!pack) {
+        remove(path);
+        return;
+    }
+    BenchCheck(TreePackTree3DCount(pack) == tree3dCount && TreePackTreeCount(pack) == treeCount &&
+               TreePackBushCount(pack) == bushCount, "pack entry counts");
+
+    bool same = true;
+    for (int i = 0; same && i < tree3dCount && i < TreePackTree3DCount(pack); i++) {
+        Tree3D packed = Tree3DNewTree();
+        same = TreePackLoadTree3D(pack, i, &packed) && BenchSamePackedTree3D(&tree3ds[i], &packed);
+        Tree3DFree(&packed);
+    }
+    BenchCheck(same, "packed Tree3D entries match the saved trees");
+
+    if (treeCount > 0) {
+        Tree *loaded = (Tree*)calloc(1, sizeof(Tree));
+        if (!loaded) {
+            fprintf(stderr, "Failed to allocate pack check\n");
+            exit(1);
+        }
+        for (int i = 0; same && i < treeCount && i < TreePackTreeCount(pack); i++) {
+            same = TreePackLoadTree(pack, i, loaded) && BenchSamePackedTree(&trees[i], loaded);
+        }
+        BenchCheck(same, "packed Tree entries match the saved trees");
+        free(loaded);
+    }
+
+    same = true;
+    for (int i = 0; same && i < bushCount && i < TreePackBushCount(pack); i++) {
+        same = BenchSamePackedBush(&bushes[i], TreePackGetBush(pack, i));
+    }
+    BenchCheck(same, "packed Bush3D entries match the saved bushes");
+
+    TreePackClose(pack);
+    remove(path);
+}
+
+static void BenchForest(int count) {
+    Tree3DForestDesc *descs = (Tree3DForestDesc*)malloc(count * sizeof(Tree3DForestDesc));
+    if (!descs) {
+        fprintf(stderr, "Failed to allocate forest descriptors\n");
+        exit(1);
+    }
+
+    // Fixed layout so every run grows the same forest
+    float half = 10.0f * sqrtf((float)count);
+    uint64_t state = 42;
+    for (int i = 0; i < count; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        float u = (float)(state >> 40) / (float)(1 << 24);
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        float v = (float)(state >> 40) / (float)(1 << 24);
+
+        descs[i].position = (Vector3){(u * 2.0f - 1.0f) * half, 0.0f, (v * 2.0f - 1.0f) * half};
+        descs[i].species = (i % 4 == 0) ? TREE3D_SPECIES_JUNGLE : TREE3D_SPECIES_DEFAULT;
+        descs[i].seed = (uint64_t)(i + 1);
+        descs[i].randomRow = true;
+    }
+
+    Tree3DForest forest;
+    BenchResult *generate = BenchBegin("forest_generate", "trees", count);
+    while (BenchContinue(generate)) {
+        forest = Tree3DForestNew(-half, -half, half, half, 32.0f);
+        double start = BenchNow();
+        Tree3DForestGenerate(&forest, descs, count, 0);
+        BenchSample(generate, BenchNow() - start, 1);
+
+        if (BenchContinue(generate)) Tree3DForestFree(&forest);
+        else break;
+    }
+    generate->items = count;
+
+    // Growth is keyed per branch, so the thread count must not show in the trees
+    Tree3DForest serial = Tree3DForestNew(-half, -half, half, half, 32.0f);
+    Tree3DForest threaded = Tree3DForestNew(-half, -half, half, half, 32.0f);
+    Tree3DForestGenerate(&serial, descs, count, 1);
+    Tree3DForestGenerate(&threaded, descs, count, 4);
+    bool same = serial.treeCount == threaded.treeCount;
+    for (int i = 0; same && i < serial.treeCount; i++) {
+        same = BenchSameTree3D(&serial.trees[i], &threaded.trees[i]);
+    }
+    BenchCheck(same, "forest generated on 1 thread matches 4 threads");
+    Tree3DForestFree(&serial);
+    Tree3DForestFree(&threaded);
+
+    // The same forest saved once, then mapped back in and added to an empty
+    // forest in place of growing it
+    const char *packPath = "bench_forest.pack";
+    if (TreePackSave(packPath, forest.trees, forest.treeCount, NULL, 0, NULL, 0)) {
+        BenchResult *open = BenchBegin("forest_pack_open", "trees", count);
+        while (BenchContinue(open)) {
+            Tree3DForest packed = Tree3DForestNew(-half, -half, half, half, 32.0f);
+            double start = BenchNow();
+            TreePack *pack = TreePackOpen(packPath);
+            TreePackAddToForest(pack, &packed);
+            BenchSample(open, BenchNow() - start, 1);
+            Tree3DForestFree(&packed);
+            TreePackClose(pack);
+        }
+        open->items = count;
+        remove(packPath);
+    }
+
+    Camera3D camera = BenchCamera((Vector3){0.0f, 20.0f, -half}, (Vector3){0.0f, 5.0f, 0.0f});
+    BenchResult *frame = BenchBegin("forest_update_draw", "trees", count);
+    while (BenchContinue(frame)) {
+        StubDrawReset();
+        double start = BenchNow();
+        Tree3DForestUpdate(&forest);
+        Tree3DForestDraw(&forest, camera);
+        BenchSample(frame, BenchNow() - start, 1);
+        frame->drawCalls = StubDrawCallCount();
+    }
+    frame->items = count;
+
+    // Same view with only the nearest cells at full detail and every other
+    // cell drawn as impostors
+    Tree3DForestBakeImpostors(&forest, 8, 64);
+    forest.lodDistances[0] = 20.0f;
+    forest.lodDistances[1] = 40.0f;
+    forest.lodDistances[2] = 60.0f;
+    forest.impostorDistance = 4.0f * half;
+    BenchResult *horizon = BenchBegin("forest_impostor_draw", "trees", count);
+    while (BenchContinue(horizon)) {
+        StubDrawReset();
+        double start = BenchNow();
+        Tree3DForestDraw(&forest, camera);
+        BenchSample(horizon, BenchNow() - start, 1);
+        horizon->drawCalls = StubDrawCallCount();
+    }
+    horizon->items = count;
+
+    // Same view again with a bush beside every tree and every cell merged
+    // into one chunk; the first draw builds the chunks
+    for (int i = 0; i < count; i++) {
+        Vector3 p = descs[i].position;
+        Bush3D bush = Bush3DNewBush(p.x + 2.0f, p.y, p.z + 2.0f);
+        bush.seed = (unsigned int)(i + 1);
+        Tree3DForestAddBush(&forest, bush);
+    }
+    Tree3DForestUpdateBushes(&forest, 10.0f);
+    forest.chunkDistance = 1.0f;
+    BenchResult *chunks = BenchBegin("forest_chunk_draw", "trees", count);
+    while (BenchContinue(chunks)) {
+        StubDrawReset();
+        double start = BenchNow();
+        Tree3DForestDraw(&forest, camera);
+        BenchSample(chunks, BenchNow() - start, 1);
+        chunks->drawCalls = StubDrawCallCount();
+    }
+    chunks->items = count;
+
+    // Everything the forest holds survives a pack round trip
+    BenchCheckPack(forest.trees, forest.treeCount, NULL, 0, forest.bushes, forest.bushCount);
+
+    Tree3DForestFree(&forest);
+    free(descs);
+}
+
+// Shared trees: `count` placements of `unique` distinct seeds, grown once
+// each through the cache, against loading every placement on its own
+static void BenchTreeCache(int count, int unique) {
+    Tree3DCachedTree *placed = (Tree3DCachedTree*)malloc(count * sizeof(Tree3DCachedTree));
+    if (!placed) {
+        fprintf(stderr, "Failed to allocate placements\n");
+        exit(1);
+    }
+    int side = (int)ceilf(sqrtf((float)count));
+
+    Tree3DCache cache;
+    BenchResult *place = BenchBegin("cache_place", "trees", count);
+    while (BenchContinue(place)) {
+        cache = Tree3DCacheNew();
+        double start = BenchNow();
+        for (int i = 0; i < count; i++) {
+            Tree3D tree = Tree3DNewTree();
+            tree.Seed = (uint64_t)(i % unique + 1);
+            placed[i] = Tree3DCachePlace(&cache, &tree,
+                                         (Vector3){(float)(i % side) * 12.0f, 0.0f, (float)(i / side) * 12.0f});
+        }
+        BenchSample(place, BenchNow() - start, 1);
+
+        if (BenchContinue(place)) Tree3DCacheFree(&cache);
+        else break;
+    }
+    place->items = cache.count;
+
+    // A shared tree is the tree its key grows to on its own
+    bool same = true;
+    Tree3D params = Tree3DNewTree();
+    for (int i = 0; i < unique; i++) {
+        uint64_t seed = (uint64_t)(i + 1);
+        Tree3D *shared = Tree3DCacheGetSeeded(&cache, &params, seed);
+        Tree3D direct = params;
+        direct.Seed = seed;
+        direct.X = direct.Y = direct.Z = 0.0f;
+        direct.RandomRow = false;
+        Tree3DLoad(&direct);
+        while (direct.CurrentRow < direct.MaxRow) Tree3DGrow(&direct);
+        same = same && BenchSameTree3D(shared, &direct);
+        Tree3DFree(&direct);
+    }
+    BenchCheck(same, "cached trees match the same keys grown directly");
+
+    BenchResult *load = BenchBegin("cache_uncached_load", "trees", count);
+    while (BenchContinue(load)) {
+        double start = BenchNow();
+        for (int i = 0; i < count; i++) {
+            Tree3D tree = Tree3DNewTree();
+            tree.Seed = (uint64_t)(i % unique + 1);
+            tree.RandomRow = false;
+            Tree3DLoad(&tree);
+            while (tree.CurrentRow < tree.MaxRow) Tree3DGrow(&tree);
+            Tree3DFree(&tree);
+        }
+        BenchSample(load, BenchNow() - start, 1);
+    }
+    load->items = count;
+
+    float half = (float)side * 6.0f;
+    Camera3D camera = BenchCamera((Vector3){half, 20.0f, -half}, (Vector3){half, 5.0f, half});
+    BenchResult *draw = BenchBegin("cache_draw", "trees", count);
+    while (BenchContinue(draw)) {
+        StubDrawReset();
+        double start = BenchNow();
+        for (int i = 0; i < count; i++) Tree3DCacheDraw(&placed[i], camera);
+        BenchSample(draw, BenchNow() - start, 1);
+        draw->drawCalls = StubDrawCallCount();
+    }
+    draw->items = count;
+
+    Tree3DCacheFree(&cache);
+    free(placed);
+}
+
+// Species registry: `count` dormant handles of two species and `unique`
+// seeds each, then every handle woken
+static void BenchRegistry(int count, int unique) {
+    Tree3DHandle *handles = (Tree3DHandle*)malloc(count * sizeof(Tree3DHandle));
+    if (!handles) {
+        fprintf(stderr, "Failed to allocate handles\n");
+        exit(1);
+    }
+
+    Tree3DRegistry registry = Tree3DRegistryNew();
+    Tree3D params = Tree3DNewTree();
+    int oak = Tree3DRegistryAdd(&registry, "default", &params);
+    params = Tree3DNewJungleTree(0.0f, 0.0f, 0.0f);
+    int jungle = Tree3DRegistryAdd(&registry, "jungle", &params);
+    int side = (int)ceilf(sqrtf((float)count));
+
+    BenchResult *place = BenchBegin("registry_place", "trees", count);
+    while (BenchContinue(place)) {
+        double start = BenchNow();
+        for (int i = 0; i < count; i++) {
+            Vector3 position = {(float)(i % side) * 12.0f, 0.0f, (float)(i / side) * 12.0f};
+            handles[i] = Tree3DRegistryPlace(&registry, (i % 4 == 0) ? jungle : oak,
+                                             (uint64_t)(i % unique + 1), position, (float)(i % 360));
+        }
+        BenchSample(place, BenchNow() - start, 1);
+    }
+    place->items = count;
+
+    // The first pass grows every distinct tree; later passes only share them
+    BenchResult *wake = BenchBegin("registry_wake", "trees", count);
+    while (BenchContinue(wake)) {
+        double start = BenchNow();
+        for (int i = 0; i < count; i++) Tree3DRegistryWake(&registry, &handles[i]);
+        BenchSample(wake, BenchNow() - start, 1);
+        for (int i = 0; i < count; i++) Tree3DRegistrySleep(&handles[i]);
+    }
+    wake->items = registry.cache.count;
+
+    Tree3DRegistryFree(&registry);
+    free(handles);
+}
+
+// `count` RandomRow trees started with Tree3DLoadBegin and grown in turns by
+// Tree3DGenerate must match the same seeds grown at once by Tree3DLoad
+static void BenchCheckGenerate(int count) {
+    Tree3D *trees = (Tree3D*)malloc(count * sizeof(Tree3D));
+    if (!trees) {
+        fprintf(stderr, "Failed to allocate trees\n");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        trees[i] = Tree3DNewTree();
+        trees[i].Seed = (uint64_t)(i + 1);
+        trees[i].RandomRow = true;
+        Tree3DLoadBegin(&trees[i]);
+    }
+    int cursor = 0;
+    while (Tree3DGenerate(trees, count, &cursor, 0.0f) > 0) {}
+
+    bool same = true;
+    for (int i = 0; i < count; i++) {
+        Tree3D loaded = Tree3DNewTree();
+        loaded.Seed = trees[i].Seed;
+        loaded.RandomRow = true;
+        Tree3DLoad(&loaded);
+        same = same && !Tree3DIsGenerating(&trees[i]) && BenchSameTree3D(&trees[i], &loaded);
+        Tree3DFree(&loaded);
+        Tree3DFree(&trees[i]);
+    }
+    BenchCheck(same, "trees grown by Tree3DGenerate match Tree3DLoad");
+    free(trees);
+}
+
+// Spawning many RandomRow trees in one frame: grown in full as they are
+// added, then time-sliced, where a sample is the worst frame from the spawn
+// until every tree has reached its row
+static void BenchSpawn(int count, float budgetUs) {
+    int side = (int)ceilf(sqrtf((float)count));
+    for (int sliced = 0; sliced < 2; sliced++) {
+        BenchResult *r = BenchBegin(sliced ? "forest_spawn_sliced" : "forest_spawn_sync", "trees", count);
+        while (BenchContinue(r)) {
+            Tree3DForest forest = Tree3DForestNew(0.0f, 0.0f, side * 8.0f, side * 8.0f, 0.0f);
+            forest.generateBudgetUs = sliced ? budgetUs : 0.0f;
+
+            double start = BenchNow();
+            for (int i = 0; i < count; i++) {
+                Tree3D tree = Tree3DNewTree();
+                tree.X = (float)(i % side) * 8.0f;
+                tree.Z = (float)(i / side) * 8.0f;
+                tree.Seed = (uint64_t)(i + 1);
+                tree.RandomRow = true;
+                Tree3DForestAddTree(&forest, tree);
+            }
+            Tree3DForestUpdate(&forest);
+            double worst = BenchNow() - start;
+
+            int frames = 1;
+            for (bool generating = sliced; generating; frames++) {
+                generating = false;
+                for (int i = 0; i < forest.treeCount && !generating; i++) {
+                    generating = Tree3DIsGenerating(&forest.trees[i]);
+                }
+                if (!generating) break;
+                start = BenchNow();
+                Tree3DForestUpdate(&forest);
+                double frame = BenchNow() - start;
+                if (frame > worst) worst = frame;
+            }
+            BenchSample(r, worst, 1);
+            r->items = frames;
+            Tree3DForestFree(&forest);
+        }
+    }
+}
+
+// Streamed trees: the main thread's cost per frame while the viewer walks
+// and chunks grow on the worker, then a full regrow of the chunks in range
+static void BenchStream(int count, float worldSize) {
+    Tree3DRegistry registry = Tree3DRegistryNew();
+    Tree3D params = Tree3DNewTree();
+    int oak = Tree3DRegistryAdd(&registry, "default", &params);
+    params = Tree3DNewJungleTree(0.0f, 0.0f, 0.0f);
+    int jungle = Tree3DRegistryAdd(&registry, "jungle", &params);
+
+    Tree3DStream stream = Tree3DStreamNew(&registry, 0.0f, 0.0f, worldSize, worldSize, 0.0f);
+    stream.loadRadius = 96.0f;
+    stream.memoryBudget = (size_t)128 * 1024 * 1024;
+    int side = (int)ceilf(sqrtf((float)count));
+    float spacing = worldSize / side;
+    for (int i = 0; i < count; i++) {
+        Vector3 position = {((float)(i % side) + 0.5f) * spacing, 0.0f, ((float)(i / side) + 0.5f) * spacing};
+        Tree3DStreamAdd(&stream, (i % 4 == 0) ? jungle : oak, (uint64_t)(i + 1), position);
+    }
+
+    // Start with the chunks around the first viewer position grown
+    float walked = 0.0f;
+    Tree3DStreamUpdate(&stream, (Vector3){walked, 0.0f, worldSize * 0.5f});
+    Tree3DStreamWait(&stream);
+
+    BenchResult *frame = BenchBegin("stream_frame", "trees", count);
+    while (BenchContinue(frame)) {
+        walked = fmodf(walked + 2.0f, worldSize);
+        Vector3 viewer = {walked, 0.0f, worldSize * 0.5f};
+        Camera3D camera = BenchCamera((Vector3){viewer.x, 10.0f, viewer.z},
+                                      (Vector3){viewer.x + 50.0f, 10.0f, viewer.z});
+        StubDrawReset();
+        double start = BenchNow();
+        Tree3DStreamUpdate(&stream, viewer);
+        Tree3DStreamDraw(&stream, camera);
+        BenchSample(frame, BenchNow() - start, 1);
+        frame->drawCalls = StubDrawCallCount();
+    }
+    frame->items = stream.residentChunks;
+
+    // Evicted chunks are grown again from their placements, and must come
+    // back as the same trees
+    Vector3 viewer = {worldSize * 0.25f, 0.0f, worldSize * 0.25f};
+    Vector3 away = {-stream.loadRadius * 4.0f, 0.0f, -stream.loadRadius * 4.0f};
+    int grownBefore;
+    do {
+        grownBefore = stream.grown;
+        Tree3DStreamUpdate(&stream, viewer);
+        Tree3DStreamWait(&stream);
+    } while (stream.grown > grownBefore);
+    int chunkTrees = 0;
+    uint64_t chunkHash = BenchHashStreamChunk(&stream, viewer.x, viewer.z, &chunkTrees);
+    BenchCheck(chunkHash != 0 && chunkTrees > 0, "stream chunk under the viewer grown");
+
+    BenchResult *regrow = BenchBegin("stream_regrow", "trees", count);
+    while (BenchContinue(regrow)) {
+        stream.memoryBudget = 0;
+        Tree3DStreamWait(&stream);
+        Tree3DStreamUpdate(&stream, away);
+        stream.memoryBudget = (size_t)128 * 1024 * 1024;
+
+        int first = stream.grown, before;
+        double start = BenchNow();
+        do {
+            before = stream.grown;
+            Tree3DStreamUpdate(&stream, viewer);
+            Tree3DStreamWait(&stream);
+        } while (stream.grown > before);
+        BenchSample(regrow, BenchNow() - start, 1);
+        regrow->items = stream.grown - first;
+
+        int regrownTrees = 0;
+        uint64_t regrownHash = BenchHashStreamChunk(&stream, viewer.x, viewer.z, &regrownTrees);
+        BenchCheck(regrownTrees == chunkTrees && regrownHash == chunkHash, "stream chunk regrown after eviction matches");
+    }
+
+    Tree3DStreamFree(&stream);
+    Tree3DRegistryFree(&registry);
+}
+
+// Tree (2D)
+static Tree benchTree2D;
+
+static void BenchTree2DDraw(int rows) {
+    benchTree2D = TreeNewTree();
+    benchTree2D.MaxRow = rows;
+    benchTree2D.Seed = 1234;
+    benchTree2D.GrowTime = 0;
+    benchTree2D.RandomRow = false;
+    TreeLoad(&benchTree2D);
+    while (benchTree2D.CurrentRow < benchTree2D.MaxRow) TreeUpdate(&benchTree2D);
+
+    BenchResult *r = BenchBegin("tree2d_draw", "rows", rows);
+    while (BenchContinue(r)) {
+        StubDrawReset();
+        double start = BenchNow();
+        TreeDraw(&benchTree2D);
+        BenchSample(r, BenchNow() - start, 1);
+        r->drawCalls = StubDrawCallCount();
+    }
+
+    long branches = 0;
+    for (int i = 0; i <= benchTree2D.CurrentRow; i++) branches += benchTree2D.BranchCount[i];
+    r->items = branches;
+
+    BenchCheckPack(NULL, 0, &benchTree2D, 1, NULL, 0);
+}
+
+// Bush3D
+static void BenchBushes(int count) {
+    Bush3D *bushes = (Bush3D*)malloc(count * sizeof(Bush3D));
+    if (!bushes) {
+        fprintf(stderr, "Failed to allocate bushes\n");
+        exit(1);
+    }
+
+    int side = (int)ceilf(sqrtf((float)count));
+    for (int i = 0; i < count; i++) {
+        bushes[i] = Bush3DNewBush((float)(i % side) * 3.0f, 0.0f, (float)(i / side) * 3.0f);
+        bushes[i].seed = (unsigned int)(i + 1);
+        Bush3DLoad(&bushes[i]);
+    }
+
+    BenchResult *update = BenchBegin("bush3d_update", "bushes", count);
+    while (BenchContinue(update)) {
+        double start = BenchNow();
+        for (int i = 0; i < count; i++) Bush3DUpdate(&bushes[i], 1.0f / 60.0f);
+        BenchSample(update, BenchNow() - start, 1);
+    }
+    update->items = count;
+
+    Vector3 player = {(float)side * 1.5f, 0.0f, (float)side * 1.5f};
+    BenchResult *draw = BenchBegin("bush3d_draw", "bushes", count);
+    while (BenchContinue(draw)) {
+        StubDrawReset();
+        double start = BenchNow();
+        for (int i = 0; i < count; i++) Bush3DDraw(&bushes[i], player);
+        BenchSample(draw, BenchNow() - start, 1);
+        draw->drawCalls = StubDrawCallCount();
+    }
+    draw->items = count;
+
+    for (int i = 0; i < count; i++) Bush3DFree(&bushes[i]);
+    free(bushes);
+}
+
+// Output
+static void BenchPrint(void) {
+    printf("%-30s %-8s %8s %12s %12s %10s %10s\n", "case", "param", "value", "min us", "mean us", "items", "draws");
+    for (int i = 0; i < benchResultCount; i++) {
+        const BenchResult *r = &benchResults[i];
+        printf("%-30s %-8s %8d %12.2f %12.2f %10ld %10ld\n",
+               r->name, r->param, r->value, r->minUs, r->meanUs, r->items, r->drawCalls);
+    }
+}
+
+static bool BenchWriteJSON(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"schema\": 1,\n");
+    fprintf(file, "  \"timestamp\": %ld,\n", (long)time(NULL));
+#ifdef __VERSION__
+    fprintf(file, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    fprintf(file, "  \"simdLanes\": %d,\n", TREE3D_LANES);
+    fprintf(file, "  \"results\": [\n");
+    for (int i = 0; i < benchResultCount; i++) {
+        const BenchResult *r = &benchResults[i];
+        fprintf(file, "    {\"name\": \"%s\", \"param\": \"%s\", \"value\": %d, \"iterations\": %d, "
+                      "\"minUs\": %.3f, \"meanUs\": %.3f, \"items\": %ld, \"drawCalls\": %ld}%s\n",
+                r->name, r->param, r->value, r->iterations, r->minUs, r->meanUs,
+                r->items, r->drawCalls, i + 1 < benchResultCount ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *output = "bench_results.json";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) benchMinSeconds = 0.02;
+        else output = argv[i];
+    }
+
+    BenchCheckBakedMesh();
+    BenchTree3DNew();
+    for (int i = 0; i < BENCH_COUNT(benchRows); i++) {
+        int rows = benchRows[i];
+        BenchTree3DLoadAndGrow(rows);
+        BenchTree3DDraw("tree3d_batch_draw_immediate", rows, TREE3D_RENDER_IMMEDIATE, false, 1.0f);
+        BenchTree3DDraw("tree3d_batch_draw_instanced", rows, TREE3D_RENDER_INSTANCED, false, 1.0f);
+        BenchTree3DDraw("tree3d_batch_draw_baked", rows, TREE3D_RENDER_INSTANCED, true, 1.0f);
+        BenchTree3DDraw("tree3d_batch_draw_far", rows, TREE3D_RENDER_INSTANCED, true, 20.0f);
+        BenchTree3DCanopy(rows);
+    }
+    for (int i = 0; i < BENCH_COUNT(benchForestSizes); i++) {
+        BenchForest(benchForestSizes[i]);
+    }
+    BenchTreeCache(800, 16);
+    BenchRegistry(50000, 32);
+    BenchCheckGenerate(16);
+    BenchSpawn(500, 2000.0f);
+    BenchStream(4096, 2048.0f);
+    for (int i = 0; i < 3; i++) {
+        BenchTree2DDraw(benchRows[i]);
+    }
+    for (int i = 0; i < BENCH_COUNT(benchBushCounts); i++) {
+        BenchBushes(benchBushCounts[i]);
+    }
+
+    Tree3DCloseRenderer();
+    BenchPrint();
+
+    if (!BenchWriteJSON(output)) return 1;
+    printf("Wrote %s\n", output);
+    if (benchFailures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", benchFailures);
+        return 1;
+    }
+    return 0;
+}
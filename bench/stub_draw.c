@@ -0,0 +1,172 @@
+#define _POSIX_C_SOURCE 199309L
+#include <raylib.h>
+#include <rlgl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "stub_draw.h"
+
+// Screen size reported to the culling code
+#define STUB_SCREEN_WIDTH 1280
+#define STUB_SCREEN_HEIGHT 720
+
+StubDrawCalls stubDrawCalls;
+
+void StubDrawReset(void) {
+    memset(&stubDrawCalls, 0, sizeof(stubDrawCalls));
+}
+
+long StubDrawCallCount(void) {
+    return stubDrawCalls.cylinders + stubDrawCalls.spheres + stubDrawCalls.lines +
+           stubDrawCalls.circles + stubDrawCalls.meshes + stubDrawCalls.instancedCalls;
+}
+
+// Window and timing
+int GetScreenWidth(void) { return STUB_SCREEN_WIDTH; }
+int GetScreenHeight(void) { return STUB_SCREEN_HEIGHT; }
+
+double GetTime(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Shaders and materials
+static int stubShaderLocs[32];
+static unsigned int stubNextId = 1;
+
+Shader LoadShaderFromMemory(const char *vsCode, const char *fsCode) {
+    (void)vsCode; (void)fsCode;
+    Shader shader = {stubNextId++, stubShaderLocs};
+    return shader;
+}
+
+int GetShaderLocation(Shader shader, const char *uniformName) {
+    (void)shader; (void)uniformName;
+    return 0;
+}
+
+int GetShaderLocationAttrib(Shader shader, const char *attribName) {
+    (void)shader; (void)attribName;
+    return 0;
+}
+
+void UnloadShader(Shader shader) { (void)shader; }
+void BeginShaderMode(Shader shader) { (void)shader; }
+void EndShaderMode(void) {}
+
+Material LoadMaterialDefault(void) {
+    Material material = {0};
+    material.maps = (MaterialMap*)calloc(MAX_MATERIAL_MAPS, sizeof(MaterialMap));
+    if (material.maps) material.maps[MATERIAL_MAP_DIFFUSE].color = WHITE;
+    return material;
+}
+
+void UnloadMaterial(Material material) {
+    free(material.maps);
+}
+
+// Meshes: CPU buffers are owned and freed as raylib does
+void UploadMesh(Mesh *mesh, bool dynamic) {
+    (void)dynamic;
+    mesh->vaoId = stubNextId++;
+    if (!mesh->vboId) mesh->vboId = (unsigned int*)calloc(16, sizeof(unsigned int));
+    stubDrawCalls.uploads++;
+}
+
+void UnloadMesh(Mesh mesh) {
+    free(mesh.vertices);
+    free(mesh.texcoords);
+    free(mesh.texcoords2);
+    free(mesh.normals);
+    free(mesh.tangents);
+    free(mesh.colors);
+    free(mesh.indices);
+    free(mesh.animVertices);
+    free(mesh.animNormals);
+    free(mesh.boneIds);
+    free(mesh.boneWeights);
+    free(mesh.vboId);
+}
+
+// Render textures: nothing is rendered into them, so read-backs are empty
+RenderTexture2D LoadRenderTexture(int width, int height) {
+    RenderTexture2D target = {0};
+    target.id = stubNextId++;
+    target.texture = (Texture2D){stubNextId++, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    return target;
+}
+
+void UnloadRenderTexture(RenderTexture2D target) { (void)target; }
+void BeginTextureMode(RenderTexture2D target) { (void)target; }
+void EndTextureMode(void) {}
+void BeginMode3D(Camera3D camera) { (void)camera; }
+void EndMode3D(void) {}
+void ClearBackground(Color color) { (void)color; }
+void rlPushMatrix(void) {}
+void rlPopMatrix(void) {}
+void rlTranslatef(float x, float y, float z) { (void)x; (void)y; (void)z; }
+void rlRotatef(float angle, float x, float y, float z) { (void)angle; (void)x; (void)y; (void)z; }
+// Ids handed out by the stub start at 1, so no loaded shader is the default
+unsigned int rlGetShaderIdDefault(void) { return 0; }
+
+Image LoadImageFromTexture(Texture2D texture) {
+    (void)texture;
+    return (Image){0};
+}
+
+void UnloadImage(Image image) { free(image.data); }
+
+Color GetImageColor(Image image, int x, int y) {
+    (void)image; (void)x; (void)y;
+    return BLANK;
+}
+
+// Drawing
+void DrawMesh(Mesh mesh, Material material, Matrix transform) {
+    (void)mesh; (void)material; (void)transform;
+    stubDrawCalls.meshes++;
+}
+
+void DrawMeshInstanced(Mesh mesh, Material material, const Matrix *transforms, int instances) {
+    (void)mesh; (void)material; (void)transforms;
+    stubDrawCalls.instancedCalls++;
+    stubDrawCalls.instances += instances;
+}
+
+void DrawCylinderEx(Vector3 startPos, Vector3 endPos, float startRadius, float endRadius, int sides, Color color) {
+    (void)startPos; (void)endPos; (void)startRadius; (void)endRadius; (void)sides; (void)color;
+    stubDrawCalls.cylinders++;
+}
+
+void DrawSphere(Vector3 centerPos, float radius, Color color) {
+    (void)centerPos; (void)radius; (void)color;
+    stubDrawCalls.spheres++;
+}
+
+void DrawLine3D(Vector3 startPos, Vector3 endPos, Color color) {
+    (void)startPos; (void)endPos; (void)color;
+    stubDrawCalls.lines++;
+}
+
+void DrawLineEx(Vector2 startPos, Vector2 endPos, float thick, Color color) {
+    (void)startPos; (void)endPos; (void)thick; (void)color;
+    stubDrawCalls.lines++;
+}
+
+void DrawCircleV(Vector2 center, float radius, Color color) {
+    (void)center; (void)radius; (void)color;
+    stubDrawCalls.circles++;
+}
+
+void DrawTextureRec(Texture2D texture, Rectangle source, Vector2 position, Color tint) {
+    (void)texture; (void)source; (void)position; (void)tint;
+    stubDrawCalls.textureDraws++;
+}
+
+void DrawBillboardPro(Camera camera, Texture2D texture, Rectangle source, Vector3 position, Vector3 up,
+                      Vector2 size, Vector2 origin, float rotation, Color tint) {
+    (void)camera; (void)texture; (void)source; (void)position; (void)up;
+    (void)size; (void)origin; (void)rotation; (void)tint;
+    stubDrawCalls.billboards++;
+}
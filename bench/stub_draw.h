@@ -0,0 +1,29 @@
+#ifndef STUB_DRAW_H
+#define STUB_DRAW_H
+
+// Headless stand-in for the raylib calls the libraries make. Nothing is
+// rendered; every draw and upload is counted so benchmarks can report how
+// much work a frame would have submitted.
+
+typedef struct {
+    long cylinders;         // DrawCylinderEx
+    long spheres;           // DrawSphere
+    long lines;             // DrawLine3D and DrawLineEx
+    long circles;           // DrawCircleV
+    long meshes;            // DrawMesh
+    long instancedCalls;    // DrawMeshInstanced
+    long instances;         // Transforms passed to DrawMeshInstanced
+    long uploads;           // UploadMesh
+    long billboards;        // DrawBillboardPro, batched per texture by rlgl
+    long textureDraws;      // DrawTextureRec, batched per texture by rlgl
+} StubDrawCalls;
+
+extern StubDrawCalls stubDrawCalls;
+
+void StubDrawReset(void);
+
+// Draw calls a real renderer would have issued since the last reset. Quads
+// are left out: rlgl batches them by texture.
+long StubDrawCallCount(void);
+
+#endif // STUB_DRAW_H
@@ -6,6 +6,9 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include "treestats.h"
+#include "treeimpostor.h"
+#include "treechunk.h"
 
 // Bush configuration
 #ifndef BUSH_MAX_BRANCHES
@@ -85,8 +88,25 @@ struct Bush3D {
 
     // Random seed for this bush
     unsigned int seed;
+
+    // Far drawing: shared views of a mature bush, see Bush3DBakeImpostor
+    const TreeImpostor* impostor;
+    float impostorDistance;    // Drawn as the impostor beyond this distance from playerPos
 };
 
+// Structure and memory report of one bush, see Bush3DGetStats. Bushes
+// have no rows, and storage is fixed-size, so bytesReserved is the whole struct.
+typedef struct {
+    int branchCount;        // Against BUSH_MAX_BRANCHES
+    int leafCount;          // Against BUSH_MAX_LEAVES
+    int berryCount;         // Against BUSH_MAX_LEAVES
+    int droppedBranches;    // Asked for by MaxBranches/LeafCount/BerryCount past the limits
+    int droppedLeaves;
+    int droppedBerries;
+    size_t bytesReserved;
+    size_t bytesUsed;       // Branch, leaf and berry entries in use
+} Bush3DStats;
+
 // Function Declarations
 Bush3D Bush3DNewBush(float x, float y, float z);
 void Bush3DLoad(Bush3D* bush);
@@ -95,6 +115,9 @@ void Bush3DDraw(Bush3D* bush, Vector3 playerPos);
 bool Bush3DIsMature(const Bush3D* bush);
 void Bush3DBurn(Bush3D* bush, float amount);
 BoundingBox Bush3DGetBounds(Bush3D* bush);
+bool Bush3DBakeImpostor(Bush3D* bush, TreeImpostor* impostor, int views, int cellSize);
+void Bush3DAppendToChunk(const Bush3D* bush, TreeChunkMesh* chunk);
+Bush3DStats Bush3DGetStats(const Bush3D* bush);
 void Bush3DFree(Bush3D* bush);
 
 // Helper: Get current scale based on growth
@@ -103,8 +126,23 @@ float Bush3DGetScale(const Bush3D* bush);
 // Helper: Random float 0-1
 float Bush3DRandom(Bush3D* bush);
 
+// Instrumentation (see treestats.h)
+void Bush3DSetFrameStats(TreeFrameStats* stats);
+void Bush3DSetProfileZones(TreeProfileZones zones);
+
 #ifdef BUSH3D_IMPLEMENTATION
 
+static TreeFrameStats* bush3dFrameStats = NULL;
+static TreeProfileZones bush3dZones = {0};
+
+void Bush3DSetFrameStats(TreeFrameStats* stats) {
+    bush3dFrameStats = stats;
+}
+
+void Bush3DSetProfileZones(TreeProfileZones zones) {
+    bush3dZones = zones;
+}
+
 float Bush3DRandom(Bush3D* bush) {
     bush->seed = bush->seed * 1103515245 + 12345;
     return (float)(bush->seed & 0x7FFF) / (float)0x7FFF;
@@ -166,6 +204,7 @@ Bush3D Bush3DNewBush(float x, float y, float z) {
     bush.isActivelyBurning = false;
 
     bush.branchCount = 0;
+    bush.impostorDistance = 40.0f;
 
     // Initialize bounds
     bush.bounds = (BoundingBox){
@@ -180,7 +219,7 @@ void Bush3DLoad(Bush3D* bush) {
     if (!bush) return;
 
     // Generate branches radiating from center
-    bush->branchCount = bush->MaxBranches;
+    bush->branchCount = bush->MaxBranches < BUSH_MAX_BRANCHES ? bush->MaxBranches : BUSH_MAX_BRANCHES;
 
     for (int i = 0; i < bush->MaxBranches && i < BUSH_MAX_BRANCHES; i++) {
         // Random angle
@@ -274,9 +313,7 @@ void Bush3DUpdate(Bush3D* bush, float deltaTime) {
     bush->bounds.max = (Vector3){bush->X + 0.5f * scale, bush->Y + 1.0f * scale, bush->Z + 0.5f * scale};
 }
 
-void Bush3DDraw(Bush3D* bush, Vector3 playerPos) {
-    if (!bush || bush->IsBurned) return;
-
+static void Bush3DDrawGeometry(Bush3D* bush, Vector3 playerPos) {
     float scale = Bush3DGetScale(bush);
     bool isActiveBurn = bush->isActivelyBurning;
     float burnLevel = bush->BurnLevel;
@@ -421,6 +458,55 @@ void Bush3DDraw(Bush3D* bush, Vector3 playerPos) {
     }
 }
 
+// Far bushes that are not on fire are drawn as their impostor, darkened by
+// any burn they are cooling from
+static bool Bush3DUsesImpostor(const Bush3D* bush, Vector3 playerPos) {
+    if (!bush->impostor || bush->impostor->views == 0 || bush->isActivelyBurning) return false;
+    return Vector3Distance(playerPos, (Vector3){bush->X, bush->Y, bush->Z}) > bush->impostorDistance;
+}
+
+static void Bush3DDrawImpostor(const Bush3D* bush, Vector3 playerPos) {
+    unsigned char shade = (unsigned char)(255 * (1.0f - 0.9f * bush->BurnLevel));
+    TreeImpostorBegin();
+    TreeImpostorDraw(bush->impostor, playerPos, (Vector3){bush->X, bush->Y, bush->Z},
+                     Bush3DGetScale(bush), (Color){shade, shade, shade, 255});
+    TreeImpostorEnd();
+}
+
+void Bush3DDraw(Bush3D* bush, Vector3 playerPos) {
+    if (!bush || bush->IsBurned) return;
+
+    TREE_ZONE_BEGIN(bush3dZones, "Bush3DDraw");
+    TREE_STATS_TIMER(timer);
+    TREE_STATS_START(bush3dFrameStats, timer);
+
+    if (Bush3DUsesImpostor(bush, playerPos)) {
+        Bush3DDrawImpostor(bush, playerPos);
+        // One quad in place of every branch, counted with tree impostors
+        TREE_STATS_ADD(bush3dFrameStats, branchesConsidered, bush->branchCount);
+        TREE_STATS_ADD(bush3dFrameStats, branchesCulled, bush->branchCount);
+        TREE_STATS_ADD(bush3dFrameStats, drawCalls, 1);
+        TREE_STATS_ADD(bush3dFrameStats, lodHistogram[TREE_STATS_LOD_IMPOSTOR], 1);
+        TREE_STATS_LAP(bush3dFrameStats, timer, submitUs);
+        TREE_ZONE_END(bush3dZones, "Bush3DDraw");
+        return;
+    }
+
+    Bush3DDrawGeometry(bush, playerPos);
+
+#ifdef TREE_STATS
+    // Bushes are not culled; everything counts as submission
+    int spheres = bush->LeafCount + ((bush->HasBerries && bush->IsMature) ? bush->BerryCount : 0);
+    TREE_STATS_ADD(bush3dFrameStats, branchesConsidered, bush->branchCount);
+    TREE_STATS_ADD(bush3dFrameStats, branchesDrawn, bush->branchCount);
+    TREE_STATS_ADD(bush3dFrameStats, leavesDrawn, spheres);
+    TREE_STATS_ADD(bush3dFrameStats, drawCalls, bush->branchCount + spheres);
+    TREE_STATS_ADD(bush3dFrameStats, lodHistogram[0], 1);
+    TREE_STATS_LAP(bush3dFrameStats, timer, submitUs);
+#endif
+    TREE_ZONE_END(bush3dZones, "Bush3DDraw");
+}
+
 bool Bush3DIsMature(const Bush3D* bush) {
     return bush ? bush->IsMature : false;
 }
@@ -450,6 +536,111 @@ BoundingBox Bush3DGetBounds(Bush3D* bush) {
     return bush->bounds;
 }
 
+static void Bush3DDrawImpostorView(Camera3D camera, void* user) {
+    // Seen from far away, out of reach of the flame illumination
+    Vector3 viewer = {camera.position.x, camera.position.y + 1.0e6f, camera.position.z};
+    Bush3DDrawGeometry((Bush3D*)user, viewer);
+}
+
+// Render views of a bush into impostor, to be shared through Bush3D.impostor
+// by bushes of its kind. Bake a mature, unburned bush with Scale 1: copies
+// draw it at their own Bush3DGetScale. Needs a GL context; see
+// TreeImpostorBake.
+bool Bush3DBakeImpostor(Bush3D* bush, TreeImpostor* impostor, int views, int cellSize) {
+    if (!bush) return false;
+
+    // Bounds of what Bush3DDraw puts on screen at the current scale
+    float scale = Bush3DGetScale(bush);
+    Vector3 base = {bush->X, bush->Y, bush->Z};
+    BoundingBox bounds = {base, base};
+    for (int i = 0; i < bush->branchCount; i++) {
+        Vector3 end = Vector3Add(base, Vector3Scale(Vector3Subtract(bush->branches[i].end, base), scale));
+        bounds.min = Vector3Min(bounds.min, end);
+        bounds.max = Vector3Max(bounds.max, end);
+    }
+    for (int i = 0; i < bush->LeafCount && i < BUSH_MAX_LEAVES; i++) {
+        Vector3 pos = Vector3Add(base, Vector3Scale(Vector3Subtract(bush->leaves[i].position, base), scale));
+        Vector3 pad = Vector3Scale(Vector3One(), bush->leaves[i].radius * scale);
+        bounds.min = Vector3Min(bounds.min, Vector3Subtract(pos, pad));
+        bounds.max = Vector3Max(bounds.max, Vector3Add(pos, pad));
+    }
+    int berries = (bush->HasBerries && bush->IsMature) ? bush->BerryCount : 0;
+    for (int i = 0; i < berries && i < BUSH_MAX_LEAVES; i++) {
+        Vector3 pos = Vector3Add(base, Vector3Scale(Vector3Subtract(bush->berries[i].position, base), scale));
+        Vector3 pad = Vector3Scale(Vector3One(), bush->berries[i].radius * scale);
+        bounds.min = Vector3Min(bounds.min, Vector3Subtract(pos, pad));
+        bounds.max = Vector3Max(bounds.max, Vector3Add(pos, pad));
+    }
+
+    return TreeImpostorBake(impostor, bounds, base, views, cellSize, Bush3DDrawImpostorView, bush);
+}
+
+static Color Bush3DShade(Color color, float shade) {
+    return (Color){
+        (unsigned char)(color.r * shade),
+        (unsigned char)(color.g * shade),
+        (unsigned char)(color.b * shade),
+        color.a
+    };
+}
+
+// Append the bush in world space at its current scale for a merged far
+// chunk, darkened by its burn like the impostor. Burned bushes add nothing.
+void Bush3DAppendToChunk(const Bush3D* bush, TreeChunkMesh* chunk) {
+    if (!bush || bush->IsBurned) return;
+
+    float scale = Bush3DGetScale(bush);
+    float shade = 1.0f - 0.9f * bush->BurnLevel;
+    Vector3 base = {bush->X, bush->Y, bush->Z};
+
+    Color branchColor = {bush->ColorBranch[0], bush->ColorBranch[1], bush->ColorBranch[2], 255};
+    branchColor = Bush3DShade(branchColor, shade);
+    for (int i = 0; i < bush->branchCount; i++) {
+        Vector3 end = Vector3Add(base, Vector3Scale(Vector3Subtract(bush->branches[i].end, base), scale));
+        float width = bush->branches[i].width * scale;
+        TreeChunkAddTube(chunk, bush->branches[i].start, end, width, width, branchColor);
+    }
+
+    for (int i = 0; i < bush->LeafCount && i < BUSH_MAX_LEAVES; i++) {
+        Vector3 pos = Vector3Add(base, Vector3Scale(Vector3Subtract(bush->leaves[i].position, base), scale));
+        Vector3 radii = Vector3Scale(Vector3One(), bush->leaves[i].radius * scale);
+        TreeChunkAddBlob(chunk, pos, radii, Bush3DShade(bush->leaves[i].color, shade));
+    }
+
+    int berries = (bush->HasBerries && bush->IsMature) ? bush->BerryCount : 0;
+    for (int i = 0; i < berries && i < BUSH_MAX_LEAVES; i++) {
+        Vector3 pos = Vector3Add(base, Vector3Scale(Vector3Subtract(bush->berries[i].position, base), scale));
+        Vector3 radii = Vector3Scale(Vector3One(), bush->berries[i].radius * scale);
+        TreeChunkAddBlob(chunk, pos, radii, Bush3DShade(bush->berries[i].color, shade));
+    }
+
+    chunk->objects++;
+    chunk->dirty = true;
+}
+
+static int Bush3DClampCount(int count, int limit, int* dropped) {
+    if (count < 0) count = 0;
+    *dropped = count > limit ? count - limit : 0;
+    return count > limit ? limit : count;
+}
+
+Bush3DStats Bush3DGetStats(const Bush3D* bush) {
+    Bush3DStats stats = {0};
+    if (!bush) return stats;
+
+    // Bush3DLoad already clamps branchCount
+    stats.branchCount = bush->branchCount;
+    Bush3DClampCount(bush->MaxBranches, BUSH_MAX_BRANCHES, &stats.droppedBranches);
+    stats.leafCount = Bush3DClampCount(bush->LeafCount, BUSH_MAX_LEAVES, &stats.droppedLeaves);
+    stats.berryCount = Bush3DClampCount(bush->BerryCount, BUSH_MAX_LEAVES, &stats.droppedBerries);
+
+    stats.bytesReserved = sizeof(Bush3D);
+    stats.bytesUsed = (size_t)stats.branchCount * sizeof(bush->branches[0]) +
+                      (size_t)stats.leafCount * sizeof(BushLeaf) +
+                      (size_t)stats.berryCount * sizeof(BushBerry);
+    return stats;
+}
+
 void Bush3DFree(Bush3D* bush) {
     if (!bush) return;
     // Bush is stack-allocated, just reset state
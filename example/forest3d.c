@@ -0,0 +1,81 @@
+#include "raylib.h"
+#include "raymath.h"
+#define TREE3D_IMPLEMENTATION
+#define BUSH3D_IMPLEMENTATION
+#define FOREST3D_IMPLEMENTATION
+#include "forest3d.h"
+
+int main(void) {
+    // Initialization
+    const int screenWidth = 800;
+    const int screenHeight = 600;
+    InitWindow(screenWidth, screenHeight, "3D Forest Example");
+
+    Camera3D camera = {0};
+    camera.position = (Vector3){0.0f, 20.0f, -60.0f};
+    camera.target = (Vector3){0.0f, 5.0f, 0.0f};
+    camera.up = (Vector3){0.0f, 1.0f, 0.0f};
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    // A 400x400 world bucketed into 32-unit cells
+    Tree3DForest forest = Tree3DForestNew(-200.0f, -200.0f, 200.0f, 200.0f, 32.0f);
+
+    // Grow 400 trees in parallel; each seed always produces the same tree
+    Tree3DForestDesc descs[400];
+    for (int i = 0; i < 400; i++) {
+        descs[i].position = (Vector3){
+            (float)GetRandomValue(-190, 190), 0.0f, (float)GetRandomValue(-190, 190)
+        };
+        descs[i].species = (i % 4 == 0) ? TREE3D_SPECIES_JUNGLE : TREE3D_SPECIES_DEFAULT;
+        descs[i].seed = (uint64_t)(i + 1);
+        descs[i].randomRow = true;
+    }
+    Tree3DForestGenerate(&forest, descs, 400, 0);
+
+    // Undergrowth, and past 150 units every cell drawn as one merged chunk
+    for (int i = 0; i < 600; i++) {
+        Tree3DForestAddBush(&forest, Bush3DNewBush(
+            (float)GetRandomValue(-195, 195), 0.0f, (float)GetRandomValue(-195, 195)));
+    }
+    forest.chunkDistance = 150.0f;
+
+    SetTargetFPS(60);
+
+    // Main game loop
+    while (!WindowShouldClose()) {
+        // Grow the trees
+        Tree3DForestUpdate(&forest);
+        Tree3DForestUpdateBushes(&forest, GetFrameTime());
+
+        // Fly forward/backward
+        if (IsKeyDown(KEY_W)) camera.position.z += 1.0f;
+        if (IsKeyDown(KEY_S)) camera.position.z -= 1.0f;
+        camera.target = (Vector3){camera.position.x, 5.0f, camera.position.z + 60.0f};
+
+        // Draw
+        BeginDrawing();
+        ClearBackground(SKYBLUE);
+
+        BeginMode3D(camera);
+        DrawGrid(40, 10.0f);
+        Tree3DForestDraw(&forest, camera);
+        EndMode3D();
+
+        DrawFPS(10, 10);
+        DrawText("W/S to move through the forest", 10, 30, 20, DARKGRAY);
+
+        char debugInfo[100];
+        sprintf(debugInfo, "Trees: %d (growing: %d), bushes: %d", forest.treeCount, forest.growingCount,
+                forest.bushCount);
+        DrawText(debugInfo, 10, 50, 20, DARKGRAY);
+
+        EndDrawing();
+    }
+
+    // Cleanup
+    Tree3DForestFree(&forest);
+    Tree3DCloseRenderer();
+    CloseWindow();
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "raylib.h"
+#include "raymath.h"
+#include <stdio.h>
+#include <string.h>
+#define TREE3D_IMPLEMENTATION
+#include "tree3d.h"
+#define BUSH3D_IMPLEMENTATION
+#include "bush3d.h"
+
+#define VIEWS 8
+#define CELL_SIZE 128
+
+// Bake the impostor atlases and report how much of each view was covered.
+// With --check the window stays hidden and the program exits with 1 if any
+// view came out empty, so it can run headless, e.g. with
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./bin/impostor --check
+static bool CheckImpostor(const char *name, const TreeImpostor *impostor, bool baked) {
+    bool ok = baked;
+    printf("%s: %s", name, baked ? "baked" : "failed");
+    for (int i = 0; baked && i < impostor->views; i++) {
+        float coverage = TreeImpostorViewCoverage(impostor, i);
+        printf(" %.2f", coverage);
+        if (coverage <= 0.0f) ok = false;
+    }
+    printf("\n");
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    bool check = argc > 1 && strcmp(argv[1], "--check") == 0;
+
+    // Initialization
+    const int screenWidth = 800;
+    const int screenHeight = 600;
+    if (check) SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(screenWidth, screenHeight, "3D Impostor Example");
+
+    // One grown tree, jungle tree and bush to take the views from
+    Tree3D tree = Tree3DNewTree();
+    tree.Seed = 1;
+    tree.GrowTime = 0;
+    Tree3DLoad(&tree);
+    while (tree.CurrentRow < tree.MaxRow) Tree3DGrow(&tree);
+
+    Tree3D jungle = Tree3DNewJungleTree(0.0f, 0.0f, 0.0f);
+    jungle.Seed = 1;
+    jungle.GrowTime = 0;
+    Tree3DLoad(&jungle);
+    while (jungle.CurrentRow < jungle.MaxRow) Tree3DGrow(&jungle);
+
+    Bush3D bush = Bush3DNewBush(0.0f, 0.0f, 0.0f);
+    bush.seed = 1;
+    Bush3DLoad(&bush);
+    while (!Bush3DIsMature(&bush)) Bush3DUpdate(&bush, 1.0f);
+
+    TreeImpostor treeImpostor = {0};
+    TreeImpostor jungleImpostor = {0};
+    TreeImpostor bushImpostor = {0};
+    bool ok = CheckImpostor("tree", &treeImpostor, Tree3DBakeImpostor(&tree, &treeImpostor, VIEWS, CELL_SIZE));
+    ok = CheckImpostor("jungle", &jungleImpostor, Tree3DBakeImpostor(&jungle, &jungleImpostor, VIEWS, CELL_SIZE)) && ok;
+    ok = CheckImpostor("bush", &bushImpostor, Bush3DBakeImpostor(&bush, &bushImpostor, VIEWS, CELL_SIZE)) && ok;
+
+    if (!check) {
+        // The geometry in front, a row of impostors behind it
+        jungle.X = 12.0f;
+        bush.X = -12.0f;
+
+        Camera3D camera = {0};
+        camera.position = (Vector3){0.0f, 10.0f, 40.0f};
+        camera.target = (Vector3){0.0f, 5.0f, 0.0f};
+        camera.up = (Vector3){0.0f, 1.0f, 0.0f};
+        camera.fovy = 45.0f;
+        camera.projection = CAMERA_PERSPECTIVE;
+
+        SetTargetFPS(60);
+
+        // Main game loop
+        while (!WindowShouldClose()) {
+            UpdateCamera(&camera, CAMERA_ORBITAL);
+
+            // Draw
+            BeginDrawing();
+            ClearBackground(SKYBLUE);
+
+            BeginMode3D(camera);
+            DrawGrid(20, 4.0f);
+            Tree3DDraw(&tree, camera);
+            Tree3DDraw(&jungle, camera);
+            Bush3DDraw(&bush, camera.position);
+
+            TreeImpostorBegin();
+            TreeImpostorDraw(&treeImpostor, camera.position, (Vector3){0.0f, 0.0f, 20.0f}, 1.0f, WHITE);
+            TreeImpostorDraw(&jungleImpostor, camera.position, (Vector3){12.0f, 0.0f, 20.0f}, 1.0f, WHITE);
+            TreeImpostorDraw(&bushImpostor, camera.position, (Vector3){-12.0f, 0.0f, 20.0f}, 1.0f, WHITE);
+            TreeImpostorEnd();
+            EndMode3D();
+
+            // The atlases themselves
+            DrawTextureEx(treeImpostor.atlas.texture, (Vector2){0.0f, 0.0f}, 0.0f, 0.25f, WHITE);
+            DrawTextureEx(jungleImpostor.atlas.texture, (Vector2){0.0f, 32.0f}, 0.0f, 0.25f, WHITE);
+            DrawTextureEx(bushImpostor.atlas.texture, (Vector2){0.0f, 64.0f}, 0.0f, 0.25f, WHITE);
+
+            DrawFPS(10, screenHeight - 30);
+            DrawText("Front row: geometry, back row: impostors", 10, screenHeight - 50, 20, DARKGRAY);
+            EndDrawing();
+        }
+    }
+
+    // Cleanup
+    TreeImpostorUnload(&treeImpostor);
+    TreeImpostorUnload(&jungleImpostor);
+    TreeImpostorUnload(&bushImpostor);
+    Tree3DFree(&tree);
+    Tree3DFree(&jungle);
+    Bush3DFree(&bush);
+    Tree3DCloseRenderer();
+    CloseWindow();
+    return ok ? 0 : 1;
+}
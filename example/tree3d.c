@@ -27,6 +27,7 @@ int main(void) {
     tree.Width = 0.5f;
     tree.Height = 2.0f;
     tree.Scale = 1.0f;
+    tree.Seed = (uint64_t)time(NULL);   // A fixed seed regrows the same tree
     
     // Growth settings
     tree.MaxRow = 12;
@@ -36,10 +37,10 @@ int main(void) {
     tree.SplitAngle[1] = 30;
     tree.GrowTime = 10;
     
-    // LOD settings
-    tree.lodDistances[0] = 10.0f;
-    tree.lodDistances[1] = 20.0f;
-    tree.lodDistances[2] = 30.0f;
+    // LOD settings: tiers by the tree's height on screen in pixels
+    tree.lodScreenSizes[0] = 160.0f;
+    tree.lodScreenSizes[1] = 60.0f;
+    tree.lodScreenSizes[2] = 0.0f;
     tree.lodLevels[0] = 8;  // High detail
     tree.lodLevels[1] = 6;  // Medium detail
     tree.lodLevels[2] = 4;  // Low detail
@@ -68,6 +69,12 @@ int main(void) {
         // Update the tree
         Tree3DUpdate(&tree);
 
+        // Toggle between instanced and per-call rendering
+        if (IsKeyPressed(KEY_SPACE)) {
+            tree.renderMode = (tree.renderMode == TREE3D_RENDER_INSTANCED)
+                ? TREE3D_RENDER_IMMEDIATE : TREE3D_RENDER_INSTANCED;
+        }
+
         // Camera rotation control
         Vector2 mousePosition = GetMousePosition();
         if (IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
@@ -112,17 +119,20 @@ int main(void) {
         DrawFPS(10, 10);
         DrawText("Left click and drag to rotate camera", 10, 30, 20, DARKGRAY);
         DrawText("Mouse wheel to zoom in/out", 10, 50, 20, DARKGRAY);
-        DrawText("Press ESC to exit", 10, 70, 20, DARKGRAY);
+        DrawText("Space to toggle instanced rendering", 10, 70, 20, DARKGRAY);
+        DrawText("Press ESC to exit", 10, 90, 20, DARKGRAY);
         
         char debugInfo[100];
-        sprintf(debugInfo, "Current Row: %d/%d", tree.CurrentRow, tree.MaxRow);
-        DrawText(debugInfo, 10, 90, 20, DARKGRAY);
+        sprintf(debugInfo, "Current Row: %d/%d (%s)", tree.CurrentRow, tree.MaxRow,
+                tree.renderMode == TREE3D_RENDER_INSTANCED ? "instanced" : "immediate");
+        DrawText(debugInfo, 10, 110, 20, DARKGRAY);
 
         EndDrawing();
     }
     
     // Cleanup
     Tree3DFree(&tree);
+    Tree3DCloseRenderer();
     CloseWindow();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,884 @@
+#ifndef FOREST3D_H
+#define FOREST3D_H
+
+#include "tree3d.h"
+#include "bush3d.h"
+
+// Define FOREST3D_IMPLEMENTATION (together with TREE3D_IMPLEMENTATION and
+// BUSH3D_IMPLEMENTATION) in ONE source file to include the implementation
+
+// Configuration Macros
+#ifndef FOREST3D_CELL_SIZE
+#define FOREST3D_CELL_SIZE 32.0f
+#endif
+
+// Tree3DForestGenerate grows trees on pthreads; define FOREST3D_NO_THREADS
+// to grow them on the calling thread instead
+#if !defined(FOREST3D_NO_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define FOREST3D_THREADS
+#endif
+
+#ifndef FOREST3D_MAX_THREADS
+#define FOREST3D_MAX_THREADS 64
+#endif
+
+// Bush growth and burn are quantized to this many steps per unit before a
+// change rebuilds the bush's chunk
+#ifndef FOREST3D_CHUNK_STEPS
+#define FOREST3D_CHUNK_STEPS 8
+#endif
+
+// Cell tier past chunkDistance: the whole cell is drawn as its merged chunk
+#define TREE3D_LOD_CHUNK (TREE3D_LOD_IMPOSTOR + 1)
+#if TREE3D_LOD_CHUNK >= TREE_STATS_LOD_BUCKETS
+#error "TREE_STATS_LOD_BUCKETS must cover the chunk tier"
+#endif
+
+// Pre-declare structures
+typedef struct Tree3DForestCell Tree3DForestCell;
+typedef struct Tree3DForest Tree3DForest;
+typedef struct Tree3DForestDesc Tree3DForestDesc;
+
+typedef enum {
+    TREE3D_SPECIES_DEFAULT = 0,     // Tree3DNewTree
+    TREE3D_SPECIES_JUNGLE,          // Tree3DNewJungleTree
+    TREE3D_SPECIES_COUNT
+} Tree3DSpecies;
+
+// Tree to generate: species defaults at a position, grown from seed
+struct Tree3DForestDesc {
+    Vector3 position;
+    Tree3DSpecies species;
+    uint64_t seed;
+    bool randomRow;             // Fast-forward to a random row like Tree3D.RandomRow
+};
+
+// Grid cell: trees and bushes bucketed by trunk position
+struct Tree3DForestCell {
+    int *trees;
+    int count;
+    int capacity;
+    int *bushes;
+    int bushCount;
+    int bushCapacity;
+    BoundingBox bounds;         // Union of the trees' and bushes' bounds
+    bool needsBoundsUpdate;
+    int lodLevel;               // Tier picked this frame, -1 when culled
+    TreeChunkMesh chunk;        // Every tree and bush merged, built on first far draw
+    bool chunkDirty;            // A tree or bush changed since the chunk was built
+};
+
+// Forest Structure
+struct Tree3DForest {
+    // Owned trees
+    Tree3D *trees;
+    int treeCount;
+    int treeCapacity;
+
+    // Trees still growing; fully grown trees are never updated again
+    int *growing;
+    int growingCount;
+    int growingCapacity;
+
+    // Microseconds each Tree3DForestUpdate may spend fast-forwarding trees
+    // added with RandomRow, a row at a time across all of them. 0 grows
+    // them in full as they are added.
+    float generateBudgetUs;
+    int generateCursor;         // Next entry of `growing` to advance
+
+    // Uniform grid over the XZ plane
+    Tree3DForestCell *cells;
+    int cellsX, cellsZ;
+    float cellSize;
+    float originX, originZ;
+
+    // Per-cell LOD: distance to the cell picks the finest tier its trees may
+    // use (each tree can still go coarser by screen size), beyond the last a
+    // cell is culled
+    float lodDistances[LOD_LEVELS];
+
+    // Cells past the last LOD distance and within this one draw their fully
+    // grown trees as impostors, 0 for none
+    float impostorDistance;
+
+    // Cells farther than this draw their merged chunk in place of their
+    // trees and bushes, 0 for none. Cells are still culled past the last LOD
+    // or impostor distance.
+    float chunkDistance;
+
+    // Owned bushes, updated with Tree3DForestUpdateBushes. bushStates holds
+    // each bush's quantized growth and burn as of its cell's last chunk.
+    Bush3D *bushes;
+    int *bushStates;
+    int bushCount;
+    int bushCapacity;
+
+    // One impostor per species, shared by the trees generated from it. Empty
+    // until Tree3DForestBakeImpostors.
+    TreeImpostor *impostors;
+
+    // Shared instance buffer so the whole forest draws in two instanced calls
+    Tree3DInstanceData instanceData;
+
+    // Storage of fully grown trees added without their own allocator,
+    // released in one go. Such trees grow on the heap and move here once
+    // they settle, since the arena cannot take back what they outgrow.
+    Tree3DArena *arena;
+};
+
+// Function Declarations
+Tree3DForest Tree3DForestNew(float minX, float minZ, float maxX, float maxZ, float cellSize);
+int Tree3DForestAddTree(Tree3DForest *forest, Tree3D tree);
+int Tree3DForestAddLoadedTree(Tree3DForest *forest, Tree3D tree);
+int Tree3DForestAddJungleTree(Tree3DForest *forest, float x, float y, float z);
+int Tree3DForestGenerate(Tree3DForest *forest, const Tree3DForestDesc *descs, int count, int threadCount);
+Tree3D* Tree3DForestGetTree(Tree3DForest *forest, int index);
+int Tree3DForestAddBush(Tree3DForest *forest, Bush3D bush);
+Bush3D* Tree3DForestGetBush(Tree3DForest *forest, int index);
+void Tree3DForestBurnBush(Tree3DForest *forest, int index, float amount);
+void Tree3DForestMarkChanged(Tree3DForest *forest, float x, float z);
+void Tree3DForestUpdate(Tree3DForest *forest);
+void Tree3DForestUpdateBushes(Tree3DForest *forest, float deltaTime);
+void Tree3DForestDraw(Tree3DForest *forest, Camera3D camera);
+bool Tree3DForestBakeImpostors(Tree3DForest *forest, int views, int cellSize);
+void Tree3DForestFree(Tree3DForest *forest);
+
+#ifdef FOREST3D_IMPLEMENTATION
+
+#ifdef FOREST3D_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Grow an int array so it can hold at least `needed` entries
+static int* Tree3DForestReserveInts(int *data, int *capacity, int needed) {
+    if (needed <= *capacity) return data;
+
+    int newCapacity = *capacity > 0 ? *capacity * 2 : 16;
+    while (newCapacity < needed) newCapacity *= 2;
+
+    int *grown = (int*)TREE3D_REALLOC(data, newCapacity * sizeof(int));
+    if (!grown) {
+        fprintf(stderr, "Failed to allocate forest data\n");
+        exit(1);
+    }
+
+    *capacity = newCapacity;
+    return grown;
+}
+
+static int Tree3DForestCellCoord(float value, float origin, float cellSize, int cells) {
+    int c = (int)floorf((value - origin) / cellSize);
+    if (c < 0) c = 0;
+    if (c >= cells) c = cells - 1;
+    return c;
+}
+
+static Tree3DForestCell* Tree3DForestCellAt(Tree3DForest *forest, float x, float z) {
+    int cx = Tree3DForestCellCoord(x, forest->originX, forest->cellSize, forest->cellsX);
+    int cz = Tree3DForestCellCoord(z, forest->originZ, forest->cellSize, forest->cellsZ);
+    return &forest->cells[cz * forest->cellsX + cx];
+}
+
+// With a generation budget the RandomRow fast-forward is left to
+// Tree3DForestUpdate
+static void Tree3DForestLoad(const Tree3DForest *forest, Tree3D *tree) {
+    if (forest->generateBudgetUs > 0.0f) Tree3DLoadBegin(tree);
+    else Tree3DLoad(tree);
+}
+
+// A tree settles once its last row has finished animating and been baked
+static bool Tree3DForestIsGrowing(const Tree3D *tree) {
+    if (tree->CurrentRow < tree->MaxRow || tree->GrowTimer > 0) return true;
+    return tree->useBakedMesh && tree->baked.bakedRows < tree->CurrentRow + 1;
+}
+
+// Heap storage of trees the forest moves into its arena once they settle
+static void* Tree3DForestHeapAllocate(void *user, size_t size) {
+    (void)user;
+    return TREE3D_MALLOC(size);
+}
+
+static void* Tree3DForestHeapReallocate(void *user, void *ptr, size_t oldSize, size_t newSize) {
+    (void)user; (void)oldSize;
+    return TREE3D_REALLOC(ptr, newSize);
+}
+
+static void Tree3DForestHeapDeallocate(void *user, void *ptr) {
+    (void)user;
+    TREE3D_FREE(ptr);
+}
+
+static const Tree3DAllocator forest3dGrowAllocator = {
+    Tree3DForestHeapAllocate, Tree3DForestHeapReallocate, Tree3DForestHeapDeallocate, NULL
+};
+
+static void Tree3DForestSettle(Tree3DForest *forest, Tree3D *tree) {
+    if (tree->allocator == &forest3dGrowAllocator) Tree3DMoveStorage(tree, &forest->arena->allocator);
+}
+
+Tree3DForest Tree3DForestNew(float minX, float minZ, float maxX, float maxZ, float cellSize) {
+    Tree3DForest forest = {0};
+
+    if (cellSize <= 0.0f) cellSize = FOREST3D_CELL_SIZE;
+    forest.cellSize = cellSize;
+    forest.originX = minX;
+    forest.originZ = minZ;
+    forest.cellsX = (int)ceilf((maxX - minX) / cellSize);
+    forest.cellsZ = (int)ceilf((maxZ - minZ) / cellSize);
+    if (forest.cellsX < 1) forest.cellsX = 1;
+    if (forest.cellsZ < 1) forest.cellsZ = 1;
+
+    forest.cells = (Tree3DForestCell*)TREE3D_MALLOC(forest.cellsX * forest.cellsZ * sizeof(Tree3DForestCell));
+    if (!forest.cells) {
+        fprintf(stderr, "Failed to allocate forest grid\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < forest.cellsX * forest.cellsZ; i++) {
+        forest.cells[i] = (Tree3DForestCell){0};
+        forest.cells[i].lodLevel = -1;
+    }
+
+    forest.lodDistances[0] = 100.0f;
+    forest.lodDistances[1] = 250.0f;
+    forest.lodDistances[2] = 500.0f;
+
+    forest.impostors = (TreeImpostor*)TREE3D_MALLOC(TREE3D_SPECIES_COUNT * sizeof(TreeImpostor));
+    if (!forest.impostors) {
+        fprintf(stderr, "Failed to allocate forest impostors\n");
+        exit(1);
+    }
+    for (int i = 0; i < TREE3D_SPECIES_COUNT; i++) {
+        forest.impostors[i] = (TreeImpostor){0};
+    }
+
+    Tree3DInitInstanceData(&forest.instanceData);
+    forest.arena = Tree3DArenaCreate(TREE3D_ARENA_BLOCK_SIZE);
+    return forest;
+}
+
+static void Tree3DForestReserveTrees(Tree3DForest *forest, int needed) {
+    if (needed <= forest->treeCapacity) return;
+
+    int newCapacity = forest->treeCapacity > 0 ? forest->treeCapacity * 2 : 16;
+    while (newCapacity < needed) newCapacity *= 2;
+
+    Tree3D *trees = (Tree3D*)TREE3D_REALLOC(forest->trees, newCapacity * sizeof(Tree3D));
+    if (!trees) {
+        fprintf(stderr, "Failed to allocate forest trees\n");
+        exit(1);
+    }
+    forest->trees = trees;
+    forest->treeCapacity = newCapacity;
+}
+
+// Bucket a loaded tree into its cell and the growing list
+static void Tree3DForestPlaceTree(Tree3DForest *forest, int index) {
+    Tree3D *tree = &forest->trees[index];
+
+    Tree3DForestCell *cell = Tree3DForestCellAt(forest, tree->X, tree->Z);
+    cell->trees = Tree3DForestReserveInts(cell->trees, &cell->capacity, cell->count + 1);
+    cell->trees[cell->count++] = index;
+    cell->needsBoundsUpdate = true;
+    cell->chunkDirty = true;
+
+    if (Tree3DForestIsGrowing(tree)) {
+        forest->growing = Tree3DForestReserveInts(forest->growing, &forest->growingCapacity,
+                                                  forest->growingCount + 1);
+        forest->growing[forest->growingCount++] = index;
+    } else {
+        Tree3DForestSettle(forest, tree);
+    }
+}
+
+// Takes ownership of a configured, not yet loaded tree, loads it and buckets
+// it by position. Trees without an allocator are stored in the forest arena
+// once fully grown. Returns the tree's index in the forest.
+int Tree3DForestAddTree(Tree3DForest *forest, Tree3D tree) {
+    Tree3DForestReserveTrees(forest, forest->treeCount + 1);
+
+    if (!tree.allocator) tree.allocator = &forest3dGrowAllocator;
+
+    int index = forest->treeCount++;
+    forest->trees[index] = tree;
+    Tree3DForestLoad(forest, &forest->trees[index]);
+    Tree3DForestPlaceTree(forest, index);
+
+    return index;
+}
+
+// Takes ownership of a tree that is already loaded, e.g. from a tree pack,
+// and buckets it by position. Its allocator is left as it is.
+int Tree3DForestAddLoadedTree(Tree3DForest *forest, Tree3D tree) {
+    Tree3DForestReserveTrees(forest, forest->treeCount + 1);
+
+    int index = forest->treeCount++;
+    forest->trees[index] = tree;
+    Tree3DForestPlaceTree(forest, index);
+
+    return index;
+}
+
+int Tree3DForestAddJungleTree(Tree3DForest *forest, float x, float y, float z) {
+    Tree3D tree = Tree3DNewJungleTree(x, y, z);
+    tree.impostor = &forest->impostors[TREE3D_SPECIES_JUNGLE];
+    return Tree3DForestAddTree(forest, tree);
+}
+
+// Parallel Generation
+// Each worker owns a range of trees. It loads trees from the front of its
+// range; an idle worker steals the back half of the fullest range. A tree
+// only reads its own seed and writes its own storage, so the result does
+// not depend on which worker loads it or on how many there are.
+typedef struct {
+    int begin;
+    int end;
+#ifdef FOREST3D_THREADS
+    pthread_mutex_t lock;
+#endif
+} Tree3DForestJobRange;
+
+typedef struct {
+    Tree3DForest *forest;
+    Tree3DForestJobRange *ranges;
+    int workerCount;
+    int first;                  // Forest index of job 0
+} Tree3DForestJobs;
+
+typedef struct {
+    Tree3DForestJobs *jobs;
+    int worker;
+} Tree3DForestWorker;
+
+static void Tree3DForestLockRange(Tree3DForestJobRange *range) {
+#ifdef FOREST3D_THREADS
+    pthread_mutex_lock(&range->lock);
+#else
+    (void)range;
+#endif
+}
+
+static void Tree3DForestUnlockRange(Tree3DForestJobRange *range) {
+#ifdef FOREST3D_THREADS
+    pthread_mutex_unlock(&range->lock);
+#else
+    (void)range;
+#endif
+}
+
+// Next job for a worker, or -1 when every range is empty
+static int Tree3DForestNextJob(Tree3DForestJobs *jobs, int worker) {
+    Tree3DForestJobRange *own = &jobs->ranges[worker];
+
+    Tree3DForestLockRange(own);
+    if (own->begin < own->end) {
+        int job = own->begin++;
+        Tree3DForestUnlockRange(own);
+        return job;
+    }
+    Tree3DForestUnlockRange(own);
+
+    for (;;) {
+        // Pick the victim with the most work left
+        int victim = -1, most = 0;
+        for (int i = 0; i < jobs->workerCount; i++) {
+            if (i == worker) continue;
+            Tree3DForestLockRange(&jobs->ranges[i]);
+            int left = jobs->ranges[i].end - jobs->ranges[i].begin;
+            Tree3DForestUnlockRange(&jobs->ranges[i]);
+            if (left > most) {
+                most = left;
+                victim = i;
+            }
+        }
+        if (victim < 0) return -1;
+
+        Tree3DForestJobRange *range = &jobs->ranges[victim];
+        int begin = 0, end = 0;
+        Tree3DForestLockRange(range);
+        if (range->begin < range->end) {
+            int half = (range->end - range->begin + 1) / 2;
+            begin = range->end - half;
+            end = range->end;
+            range->end = begin;
+        }
+        Tree3DForestUnlockRange(range);
+        if (begin == end) continue;
+
+        // Keep the first stolen job, publish the rest as our own range
+        Tree3DForestLockRange(own);
+        own->begin = begin + 1;
+        own->end = end;
+        Tree3DForestUnlockRange(own);
+        return begin;
+    }
+}
+
+static void* Tree3DForestWorkerRun(void *arg) {
+    Tree3DForestWorker *worker = (Tree3DForestWorker*)arg;
+    Tree3DForestJobs *jobs = worker->jobs;
+    Tree3DForest *forest = jobs->forest;
+
+    int job;
+    while ((job = Tree3DForestNextJob(jobs, worker->worker)) >= 0) {
+        Tree3D *tree = &forest->trees[jobs->first + job];
+        if (!tree->allocator) tree->allocator = &forest3dGrowAllocator;
+        Tree3DForestLoad(forest, tree);
+    }
+    return NULL;
+}
+
+static int Tree3DForestDefaultThreads(void) {
+#ifdef FOREST3D_THREADS
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+#else
+    return 1;
+#endif
+}
+
+static Tree3D Tree3DForestNewSpecies(const Tree3DForest *forest, const Tree3DForestDesc *desc) {
+    Tree3D tree;
+    if (desc->species == TREE3D_SPECIES_JUNGLE) {
+        tree = Tree3DNewJungleTree(desc->position.x, desc->position.y, desc->position.z);
+    } else {
+        tree = Tree3DNewTree();
+        tree.X = desc->position.x;
+        tree.Y = desc->position.y;
+        tree.Z = desc->position.z;
+    }
+    tree.Seed = desc->seed;
+    tree.RandomRow = desc->randomRow;
+    tree.impostor = &forest->impostors[desc->species];
+    return tree;
+}
+
+// Create and load `count` trees from descriptors on up to threadCount
+// threads (0 for one per core). The trees land at consecutive indices in
+// descriptor order; returns the index of the first.
+int Tree3DForestGenerate(Tree3DForest *forest, const Tree3DForestDesc *descs, int count, int threadCount) {
+    int first = forest->treeCount;
+    if (count <= 0) return first;
+
+    Tree3DForestReserveTrees(forest, first + count);
+    for (int i = 0; i < count; i++) {
+        forest->trees[first + i] = Tree3DForestNewSpecies(forest, &descs[i]);
+    }
+    forest->treeCount += count;
+
+    if (threadCount <= 0) threadCount = Tree3DForestDefaultThreads();
+    if (threadCount > FOREST3D_MAX_THREADS) threadCount = FOREST3D_MAX_THREADS;
+    if (threadCount > count) threadCount = count;
+#ifndef FOREST3D_THREADS
+    threadCount = 1;
+#endif
+
+    // Shared lazily built state must exist before workers start
+    Tree3DInitTrigTables();
+
+    Tree3DForestJobRange ranges[FOREST3D_MAX_THREADS];
+    Tree3DForestWorker workers[FOREST3D_MAX_THREADS];
+    Tree3DForestJobs jobs = {forest, ranges, threadCount, first};
+
+    for (int i = 0; i < threadCount; i++) {
+        ranges[i].begin = (int)((long long)count * i / threadCount);
+        ranges[i].end = (int)((long long)count * (i + 1) / threadCount);
+        workers[i].jobs = &jobs;
+        workers[i].worker = i;
+#ifdef FOREST3D_THREADS
+        pthread_mutex_init(&ranges[i].lock, NULL);
+#endif
+    }
+
+#ifdef FOREST3D_THREADS
+    pthread_t threads[FOREST3D_MAX_THREADS];
+    int started = 1;
+    for (int i = 1; i < threadCount; i++) {
+        if (pthread_create(&threads[i], NULL, Tree3DForestWorkerRun, &workers[i]) != 0) break;
+        started++;
+    }
+    // The calling thread is worker 0; unstarted workers' ranges get stolen
+    Tree3DForestWorkerRun(&workers[0]);
+    for (int i = 1; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < threadCount; i++) {
+        pthread_mutex_destroy(&ranges[i].lock);
+    }
+#else
+    Tree3DForestWorkerRun(&workers[0]);
+#endif
+
+    for (int i = 0; i < count; i++) {
+        Tree3DForestPlaceTree(forest, first + i);
+    }
+    return first;
+}
+
+Tree3D* Tree3DForestGetTree(Tree3DForest *forest, int index) {
+    if (index < 0 || index >= forest->treeCount) return NULL;
+    return &forest->trees[index];
+}
+
+// Bushes
+// Growth and burn quantized to FOREST3D_CHUNK_STEPS, -1 once burned away. A
+// change of this value is what rebuilds the bush's chunk.
+static int Tree3DForestBushState(const Bush3D *bush) {
+    if (bush->IsBurned) return -1;
+    int scale = (int)(Bush3DGetScale(bush) * FOREST3D_CHUNK_STEPS);
+    int burn = (int)(bush->BurnLevel * FOREST3D_CHUNK_STEPS);
+    int berries = bush->HasBerries && bush->IsMature;
+    return (scale << 16) | (burn << 1) | berries;
+}
+
+// Takes ownership of a configured, not yet loaded bush, loads it and buckets
+// it by position. Returns the bush's index in the forest.
+int Tree3DForestAddBush(Tree3DForest *forest, Bush3D bush) {
+    if (forest->bushCount >= forest->bushCapacity) {
+        int newCapacity = forest->bushCapacity > 0 ? forest->bushCapacity * 2 : 16;
+        Bush3D *bushes = (Bush3D*)TREE3D_REALLOC(forest->bushes, newCapacity * sizeof(Bush3D));
+        if (bushes) forest->bushes = bushes;
+        int *states = (int*)TREE3D_REALLOC(forest->bushStates, newCapacity * sizeof(int));
+        if (states) forest->bushStates = states;
+        if (!bushes || !states) {
+            fprintf(stderr, "Failed to allocate forest bushes\n");
+            exit(1);
+        }
+        forest->bushCapacity = newCapacity;
+    }
+
+    int index = forest->bushCount++;
+    forest->bushes[index] = bush;
+    Bush3DLoad(&forest->bushes[index]);
+    forest->bushStates[index] = Tree3DForestBushState(&forest->bushes[index]);
+
+    Tree3DForestCell *cell = Tree3DForestCellAt(forest, bush.X, bush.Z);
+    cell->bushes = Tree3DForestReserveInts(cell->bushes, &cell->bushCapacity, cell->bushCount + 1);
+    cell->bushes[cell->bushCount++] = index;
+    cell->needsBoundsUpdate = true;
+    cell->chunkDirty = true;
+
+    return index;
+}
+
+Bush3D* Tree3DForestGetBush(Tree3DForest *forest, int index) {
+    if (index < 0 || index >= forest->bushCount) return NULL;
+    return &forest->bushes[index];
+}
+
+// Mark the bush's cell for a chunk rebuild if its quantized state moved
+static void Tree3DForestCheckBush(Tree3DForest *forest, int index) {
+    Bush3D *bush = &forest->bushes[index];
+    int state = Tree3DForestBushState(bush);
+    if (state == forest->bushStates[index]) return;
+
+    forest->bushStates[index] = state;
+    Tree3DForestCell *cell = Tree3DForestCellAt(forest, bush->X, bush->Z);
+    cell->needsBoundsUpdate = true;
+    cell->chunkDirty = true;
+}
+
+void Tree3DForestBurnBush(Tree3DForest *forest, int index, float amount) {
+    if (index < 0 || index >= forest->bushCount) return;
+    Bush3DBurn(&forest->bushes[index], amount);
+    Tree3DForestCheckBush(forest, index);
+}
+
+// Advance every bush's growth and burn cooldown
+void Tree3DForestUpdateBushes(Tree3DForest *forest, float deltaTime) {
+    for (int i = 0; i < forest->bushCount; i++) {
+        Bush3DUpdate(&forest->bushes[i], deltaTime);
+        Tree3DForestCheckBush(forest, i);
+    }
+}
+
+// Rebuild the bounds and chunk of the cell at (x, z) after changing one of
+// its trees or bushes other than through the forest
+void Tree3DForestMarkChanged(Tree3DForest *forest, float x, float z) {
+    Tree3DForestCell *cell = Tree3DForestCellAt(forest, x, z);
+    cell->needsBoundsUpdate = true;
+    cell->chunkDirty = true;
+}
+
+static void Tree3DForestGeneratedRow(void *user, Tree3D *tree) {
+    Tree3DForestCell *cell = Tree3DForestCellAt((Tree3DForest*)user, tree->X, tree->Z);
+    cell->needsBoundsUpdate = true;
+    cell->chunkDirty = true;
+}
+
+// Grow one row of each tree still generating in turn until the budget is
+// spent, resuming where the last update stopped
+static void Tree3DForestGenerateRows(Tree3DForest *forest) {
+    if (forest->growingCount == 0) return;
+
+    Tree3DGenerateTurns(forest->trees, forest->growing, forest->growingCount, &forest->generateCursor,
+                        GetTime() + forest->generateBudgetUs * 1e-6, Tree3DForestGeneratedRow, forest);
+}
+
+// Advance growth. Only trees still growing are visited, so the cost does not
+// depend on how many fully grown trees the forest holds.
+void Tree3DForestUpdate(Tree3DForest *forest) {
+    Tree3DForestGenerateRows(forest);
+
+    for (int i = 0; i < forest->growingCount; ) {
+        Tree3D *tree = &forest->trees[forest->growing[i]];
+        int row = tree->CurrentRow;
+        Tree3DUpdate(tree);
+
+        if (tree->needsBoundsUpdate) {
+            Tree3DForestCellAt(forest, tree->X, tree->Z)->needsBoundsUpdate = true;
+        }
+        if (tree->CurrentRow != row) {
+            Tree3DForestCellAt(forest, tree->X, tree->Z)->chunkDirty = true;
+        }
+
+        if (!Tree3DForestIsGrowing(tree)) {
+            Tree3DForestSettle(forest, tree);
+            forest->growing[i] = forest->growing[--forest->growingCount];
+            continue;
+        }
+        i++;
+    }
+}
+
+static void Tree3DForestUpdateCellBounds(Tree3DForest *forest, Tree3DForestCell *cell) {
+    if (!cell->needsBoundsUpdate) return;
+
+    BoundingBox bounds = {{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+    for (int i = 0; i < cell->count; i++) {
+        Tree3D *tree = &forest->trees[cell->trees[i]];
+        Tree3DUpdateBounds(tree);
+        bounds.min = Vector3Min(bounds.min, tree->bounds.min);
+        bounds.max = Vector3Max(bounds.max, tree->bounds.max);
+    }
+    for (int i = 0; i < cell->bushCount; i++) {
+        BoundingBox box = Bush3DGetBounds(&forest->bushes[cell->bushes[i]]);
+        bounds.min = Vector3Min(bounds.min, box.min);
+        bounds.max = Vector3Max(bounds.max, box.max);
+    }
+
+    cell->bounds = bounds;
+    cell->needsBoundsUpdate = false;
+}
+
+static float Tree3DForestBoxDistance(BoundingBox box, Vector3 p) {
+    Vector3 q = {
+        Clamp(p.x, box.min.x, box.max.x),
+        Clamp(p.y, box.min.y, box.max.y),
+        Clamp(p.z, box.min.z, box.max.z)
+    };
+    return Vector3Distance(p, q);
+}
+
+// Trees rejected together with their cell still count as considered and culled
+static void Tree3DForestCountTreeCulled(const Tree3D *tree) {
+    long branches = (long)tree->memPool.branchPoolIndex;
+    TREE_STATS_ADD(tree3dFrameStats, branchesConsidered, branches);
+    TREE_STATS_ADD(tree3dFrameStats, branchesCulled, branches);
+    (void)branches;
+}
+
+static void Tree3DForestCountCulled(const Tree3DForest *forest, const Tree3DForestCell *cell) {
+#ifdef TREE_STATS
+    for (int i = 0; i < cell->count; i++) {
+        Tree3DForestCountTreeCulled(&forest->trees[cell->trees[i]]);
+    }
+#else
+    (void)forest;
+    (void)cell;
+#endif
+}
+
+// Merge the cell's trees and bushes into its chunk if any changed, then draw
+// it in one call
+static void Tree3DForestDrawChunk(Tree3DForest *forest, Tree3DForestCell *cell) {
+    if (cell->chunkDirty) {
+        TreeChunkClear(&cell->chunk);
+        for (int i = 0; i < cell->count; i++) {
+            Tree3DAppendToChunk(&forest->trees[cell->trees[i]], &cell->chunk);
+        }
+        for (int i = 0; i < cell->bushCount; i++) {
+            Bush3DAppendToChunk(&forest->bushes[cell->bushes[i]], &cell->chunk);
+        }
+        cell->chunkDirty = false;
+    }
+
+    TREE_STATS_TIMER(timer);
+    TREE_STATS_START(tree3dFrameStats, timer);
+    if (Tree3DInitRenderer() && TreeChunkDraw(&cell->chunk, tree3dRenderer.bakedMaterial)) {
+        TREE_STATS_ADD(tree3dFrameStats, drawCalls, 1);
+    }
+    TREE_STATS_LAP(tree3dFrameStats, timer, submitUs);
+
+#ifdef TREE_STATS
+    // The chunk holds every branch of the coarsest tier
+    for (int i = 0; i < cell->count; i++) {
+        const Tree3D *tree = &forest->trees[cell->trees[i]];
+        long considered = (long)tree->memPool.branchPoolIndex;
+        int lastRow = Tree3DLastLODRow(tree, LOD_LEVELS - 1);
+        long drawn = lastRow < tree->CurrentRow ? (long)tree->RowOffsets[lastRow + 1] : considered;
+        TREE_STATS_ADD(tree3dFrameStats, branchesConsidered, considered);
+        TREE_STATS_ADD(tree3dFrameStats, branchesDrawn, drawn);
+        TREE_STATS_ADD(tree3dFrameStats, branchesCulled, considered - drawn);
+    }
+    TREE_STATS_ADD(tree3dFrameStats, lodHistogram[TREE3D_LOD_CHUNK], cell->count);
+#endif
+}
+
+// Cull and pick LOD per cell, then draw the trees and bushes of visible
+// cells. Only the cells within the last LOD or the impostor distance of the
+// camera are visited; those past chunkDistance draw their chunk instead.
+void Tree3DForestDraw(Tree3DForest *forest, Camera3D camera) {
+    float farDistance = fmaxf(forest->lodDistances[LOD_LEVELS - 1], forest->impostorDistance);
+    Tree3DFrustum frustum = Tree3DGetCameraFrustum(camera, Tree3DGetScreenAspect(), farDistance);
+
+    // Trees may overhang their cell, so widen the scan by one cell
+    int x0 = Tree3DForestCellCoord(camera.position.x - farDistance, forest->originX, forest->cellSize, forest->cellsX);
+    int x1 = Tree3DForestCellCoord(camera.position.x + farDistance, forest->originX, forest->cellSize, forest->cellsX);
+    int z0 = Tree3DForestCellCoord(camera.position.z - farDistance, forest->originZ, forest->cellSize, forest->cellsZ);
+    int z1 = Tree3DForestCellCoord(camera.position.z + farDistance, forest->originZ, forest->cellSize, forest->cellsZ);
+    if (x0 > 0) x0--;
+    if (z0 > 0) z0--;
+    if (x1 < forest->cellsX - 1) x1++;
+    if (z1 < forest->cellsZ - 1) z1++;
+
+    Tree3DClearInstanceData(&forest->instanceData);
+    TREE_STATS_TIMER(timer);
+
+    for (int cz = z0; cz <= z1; cz++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            Tree3DForestCell *cell = &forest->cells[cz * forest->cellsX + cx];
+            cell->lodLevel = -1;
+            if (cell->count == 0 && cell->bushCount == 0) continue;
+
+            Tree3DForestUpdateCellBounds(forest, cell);
+            TREE_STATS_START(tree3dFrameStats, timer);
+            bool visible = Tree3DFrustumContainsBox(&frustum, cell->bounds);
+            TREE_STATS_LAP(tree3dFrameStats, timer, cullUs);
+            if (!visible) {
+                Tree3DForestCountCulled(forest, cell);
+                continue;
+            }
+
+            float distance = Tree3DForestBoxDistance(cell->bounds, camera.position);
+            for (int i = 0; i < LOD_LEVELS; i++) {
+                if (distance <= forest->lodDistances[i]) {
+                    cell->lodLevel = i;
+                    break;
+                }
+            }
+            if (cell->lodLevel < 0 && distance <= forest->impostorDistance) {
+                cell->lodLevel = TREE3D_LOD_IMPOSTOR;
+            }
+            if (cell->lodLevel < 0) {
+                Tree3DForestCountCulled(forest, cell);
+                continue;
+            }
+
+            if (forest->chunkDistance > 0.0f && distance > forest->chunkDistance && Tree3DInitRenderer()) {
+                cell->lodLevel = TREE3D_LOD_CHUNK;
+                Tree3DForestDrawChunk(forest, cell);
+                continue;
+            }
+
+            for (int i = 0; i < cell->bushCount; i++) {
+                Bush3DDraw(&forest->bushes[cell->bushes[i]], camera.position);
+            }
+
+            for (int i = 0; i < cell->count; i++) {
+                Tree3D *tree = &forest->trees[cell->trees[i]];
+                int tier = Tree3DSelectLOD(tree, camera);
+                if (tier < cell->lodLevel) tier = cell->lodLevel;
+
+                // Past the LOD distances only impostors are drawn
+                if (cell->lodLevel == TREE3D_LOD_IMPOSTOR && !Tree3DHasImpostor(tree)) {
+                    Tree3DForestCountTreeCulled(tree);
+                    continue;
+                }
+                Tree3DDrawFrustum(tree, camera, &frustum, tier, &forest->instanceData);
+            }
+        }
+    }
+
+    Tree3DDrawInstances(&forest->instanceData);
+}
+
+// Grow one tree of every species and bake its views for the impostor tier;
+// trees generated before or after share them. Needs a GL context, see
+// TreeImpostorBake. Returns false if any species failed to bake.
+bool Tree3DForestBakeImpostors(Tree3DForest *forest, int views, int cellSize) {
+    bool baked = true;
+    for (int i = 0; i < TREE3D_SPECIES_COUNT; i++) {
+        Tree3DForestDesc desc = {{0.0f, 0.0f, 0.0f}, (Tree3DSpecies)i, 1, false};
+        Tree3D tree = Tree3DForestNewSpecies(forest, &desc);
+        tree.GrowTime = 0;
+        Tree3DLoad(&tree);
+        while (tree.CurrentRow < tree.MaxRow) Tree3DGrow(&tree);
+
+        baked = Tree3DBakeImpostor(&tree, &forest->impostors[i], views, cellSize) && baked;
+        Tree3DFree(&tree);
+    }
+    return baked;
+}
+
+void Tree3DForestFree(Tree3DForest *forest) {
+    if (!forest) return;
+
+    // Frees GPU meshes and any storage from a tree's own allocator; arena
+    // storage goes with the arena below
+    for (int i = 0; i < forest->treeCount; i++) {
+        Tree3DFree(&forest->trees[i]);
+    }
+
+    Tree3DArenaDestroy(forest->arena);
+    forest->arena = NULL;
+
+    if (forest->trees) {
+        TREE3D_FREE(forest->trees);
+        forest->trees = NULL;
+    }
+    forest->treeCount = forest->treeCapacity = 0;
+
+    if (forest->growing) {
+        TREE3D_FREE(forest->growing);
+        forest->growing = NULL;
+    }
+    forest->growingCount = forest->growingCapacity = 0;
+
+    for (int i = 0; i < forest->bushCount; i++) {
+        Bush3DFree(&forest->bushes[i]);
+    }
+    if (forest->bushes) {
+        TREE3D_FREE(forest->bushes);
+        forest->bushes = NULL;
+    }
+    if (forest->bushStates) {
+        TREE3D_FREE(forest->bushStates);
+        forest->bushStates = NULL;
+    }
+    forest->bushCount = forest->bushCapacity = 0;
+
+    if (forest->cells) {
+        for (int i = 0; i < forest->cellsX * forest->cellsZ; i++) {
+            TREE3D_FREE(forest->cells[i].trees);
+            TREE3D_FREE(forest->cells[i].bushes);
+            TreeChunkFree(&forest->cells[i].chunk);
+        }
+        TREE3D_FREE(forest->cells);
+        forest->cells = NULL;
+    }
+
+    Tree3DFreeInstanceData(&forest->instanceData);
+
+    if (forest->impostors) {
+        for (int i = 0; i < TREE3D_SPECIES_COUNT; i++) {
+            TreeImpostorUnload(&forest->impostors[i]);
+        }
+        TREE3D_FREE(forest->impostors);
+        forest->impostors = NULL;
+    }
+}
+
+#endif // FOREST3D_IMPLEMENTATION
+#endif // FOREST3D_H
@@ -6,6 +6,9 @@
 #include <math.h>
 #include <stdio.h>
 #include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include "treestats.h"
 
 // Configuration Macros
 #ifndef MAX_ROWS
@@ -64,13 +67,37 @@ typedef struct {
     int GrowTime;
     float Width;
     float Height;
+    uint64_t Seed;      // Same seed, same tree; 0 derives one from the position
+    uint64_t rngState;
+    int droppedBranches;    // Not grown because the row was full
+    int droppedLeaves;      // Not grown because Leaves was full
 } Tree;
 
+// Structure and memory report of one tree, see TreeGetStats. Storage is
+// fixed-size, so bytesReserved is the whole struct.
+typedef struct {
+    int rows;                       // Rows grown, against MAX_ROWS
+    int branchesPerRow[MAX_ROWS];
+    int leavesPerRow[MAX_ROWS];     // Leaves sitting on each row's branches
+    int branchCount;
+    int leafCount;                  // Against MAX_LEAVES
+    int widestRow;                  // Most branches in a row, against MAX_BRANCHES_PER_ROW
+    int droppedBranches;
+    int droppedLeaves;
+    size_t bytesReserved;
+    size_t bytesUsed;               // Branch and leaf entries in use
+} TreeStats;
+
 // Function Declarations
 Tree TreeNewTree();
 void TreeLoad(Tree *tree);
 void TreeUpdate(Tree *tree);
 void TreeDraw(Tree *tree);
+void TreeSeedRandom(Tree *tree);
+float TreeRandom(Tree *tree);
+int TreeRandomInt(Tree *tree, int n);
+void TreeSetFrameStats(TreeFrameStats *stats);   // See treestats.h
+TreeStats TreeGetStats(const Tree *tree);
 
 #ifdef TREE_IMPL
 
@@ -79,11 +106,57 @@ void TreeDraw(Tree *tree);
 #endif
 #define DEG_TO_RAD (M_PI / 180.0)
 
+// Instrumentation
+static TreeFrameStats *treeFrameStats = NULL;
+
+void TreeSetFrameStats(TreeFrameStats *stats) {
+    treeFrameStats = stats;
+}
+
+// Random Generation (PCG32 on a per-tree state)
+static uint32_t TreeNextRandom(Tree *tree) {
+    uint64_t old = tree->rngState;
+    tree->rngState = old * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+}
+
+void TreeSeedRandom(Tree *tree) {
+    uint64_t seed = tree->Seed;
+    if (seed == 0) {
+        float position[2] = {tree->X, tree->Y};
+        uint32_t bits[2];
+        memcpy(bits, position, sizeof(bits));
+        seed = 0x9E3779B97F4A7C15ULL;
+        for (int i = 0; i < 2; i++) {
+            seed = (seed ^ bits[i]) * 0xBF58476D1CE4E5B9ULL;
+            seed ^= seed >> 31;
+        }
+    }
+    
+    tree->rngState = 0;
+    TreeNextRandom(tree);
+    tree->rngState += seed;
+    TreeNextRandom(tree);
+}
+
+// Random float 0-1
+float TreeRandom(Tree *tree) {
+    return (TreeNextRandom(tree) >> 8) * (1.0f / 16777215.0f);
+}
+
+// Random int in [0, n)
+int TreeRandomInt(Tree *tree, int n) {
+    if (n <= 0) return 0;
+    return (int)(((uint64_t)TreeNextRandom(tree) * (uint32_t)n) >> 32);
+}
+
 // Helper Functions
-Color TreeGetColor(unsigned char cs[6]) {
-    unsigned char r = rand() % (cs[1] - cs[0] + 1) + cs[0];
-    unsigned char g = rand() % (cs[3] - cs[2] + 1) + cs[2];
-    unsigned char b = rand() % (cs[5] - cs[4] + 1) + cs[4];
+Color TreeGetColor(Tree *tree, unsigned char cs[6]) {
+    unsigned char r = TreeRandomInt(tree, cs[1] - cs[0] + 1) + cs[0];
+    unsigned char g = TreeRandomInt(tree, cs[3] - cs[2] + 1) + cs[2];
+    unsigned char b = TreeRandomInt(tree, cs[5] - cs[4] + 1) + cs[4];
     return (Color){r, g, b, 255};
 }
 
@@ -95,7 +168,7 @@ void TreeAppendBranch(Tree *tree, int row, TreeBranch branch) {
     if (tree->BranchCount[row] < MAX_BRANCHES_PER_ROW) {
         tree->Branches[row][tree->BranchCount[row]++] = branch;
     } else {
-        fprintf(stderr, "Error: Maximum branches per row exceeded.\n");
+        tree->droppedBranches++;
     }
 }
 
@@ -103,12 +176,12 @@ void TreeAppendLeaf(Tree *tree, TreeLeaf leaf) {
     if (tree->LeafCount < MAX_LEAVES) {
         tree->Leaves[tree->LeafCount++] = leaf;
     } else {
-        fprintf(stderr, "Error: Maximum leaves exceeded.\n");
+        tree->droppedLeaves++;
     }
 }
 
 int TreeGetAngle(Tree *tree) {
-    return rand() % (tree->SplitAngle[1] - tree->SplitAngle[0] + 1) + tree->SplitAngle[0];
+    return TreeRandomInt(tree, tree->SplitAngle[1] - tree->SplitAngle[0] + 1) + tree->SplitAngle[0];
 }
 
 float TreeGetRotX(int deg) {
@@ -126,7 +199,7 @@ void TreeAddBranch(Tree *tree, int deg, TreeBranch *branch) {
     float py = branch->V2.y;
     float nx = px + TreeGetRotX(deg) * h;
     float ny = py + TreeGetRotY(deg) * h;
-    Color c = TreeGetColor(tree->CsBranch);
+    Color c = TreeGetColor(tree, tree->CsBranch);
     TreeBranch newBranch = {
         .Deg = deg,
         .V1 = (Vector2){px, py},
@@ -137,7 +210,7 @@ void TreeAddBranch(Tree *tree, int deg, TreeBranch *branch) {
     };
     TreeAppendBranch(tree, tree->CurrentRow + 1, newBranch);
 
-    float leafChance = ((float)rand() / RAND_MAX) * tree->CurrentRow / tree->MaxRow;
+    float leafChance = TreeRandom(tree) * tree->CurrentRow / tree->MaxRow;
     if (leafChance > tree->LeafChance) {
         float divX = TreeGetRotX(deg * 2) * w;
         float divY = TreeGetRotY(deg * 2) * w;
@@ -146,7 +219,7 @@ void TreeAddBranch(Tree *tree, int deg, TreeBranch *branch) {
             .Radius = w,
             .V1 = (Vector2){nx + divX, ny + divY},
             .V2 = (Vector2){nx - divX, ny - divY},
-            .Color = TreeGetColor(tree->CsLeaf)
+            .Color = TreeGetColor(tree, tree->CsLeaf)
         };
         TreeAppendLeaf(tree, newLeaf);
     }
@@ -164,7 +237,7 @@ void TreeGrow(Tree *tree) {
     int prevRow = tree->CurrentRow;
     for (int i = 0; i < tree->BranchCount[prevRow]; i++) {
         TreeBranch *b = &tree->Branches[prevRow][i];
-        int split = rand() % 100;
+        int split = TreeRandomInt(tree, 100);
         if (tree->SplitChance > split) {
             TreeAddBranch(tree, b->Deg - TreeGetAngle(tree), b);
             TreeAddBranch(tree, b->Deg + TreeGetAngle(tree), b);
@@ -177,6 +250,7 @@ void TreeGrow(Tree *tree) {
 
 void TreeLoad(Tree *tree) {
     int angle = -90;
+    TreeSeedRandom(tree);
     TreeAppendRow(tree);
     TreeBranch initialBranch = {
         .Deg = angle,
@@ -187,9 +261,9 @@ void TreeLoad(Tree *tree) {
         .Color = WHITE
     };
     TreeAppendBranch(tree, 0, initialBranch);
-    tree->GrowTimer = rand() % tree->GrowTime;
+    tree->GrowTimer = TreeRandomInt(tree, tree->GrowTime);
     if (tree->RandomRow) {
-        int growToRow = rand() % tree->MaxRow;
+        int growToRow = TreeRandomInt(tree, tree->MaxRow);
         while (tree->CurrentRow < growToRow) {
             TreeGrow(tree);
         }
@@ -205,6 +279,9 @@ void TreeUpdate(Tree *tree) {
 }
 
 void TreeDraw(Tree *tree) {
+    TREE_STATS_TIMER(timer);
+    TREE_STATS_START(treeFrameStats, timer);
+
     for (int i = 0; i <= tree->CurrentRow; i++) {
         for (int j = 0; j < tree->BranchCount[i]; j++) {
             TreeBranch *b = &tree->Branches[i][j];
@@ -217,14 +294,48 @@ void TreeDraw(Tree *tree) {
             }
             DrawLineEx(b->V1, v2, b->Width, b->Color);
         }
+        TREE_STATS_ADD(treeFrameStats, branchesConsidered, tree->BranchCount[i]);
+        TREE_STATS_ADD(treeFrameStats, branchesDrawn, tree->BranchCount[i]);
+        TREE_STATS_ADD(treeFrameStats, drawCalls, tree->BranchCount[i]);
         for (int j = 0; j < tree->LeafCount; j++) {
             TreeLeaf *l = &tree->Leaves[j];
             if ((int)l->Row < i && !(i == tree->CurrentRow && tree->GrowTimer > 0)) {
                 DrawCircleV(l->V1, l->Radius, l->Color);
                 DrawCircleV(l->V2, l->Radius, l->Color);
+                TREE_STATS_ADD(treeFrameStats, leavesDrawn, 2);
+                TREE_STATS_ADD(treeFrameStats, drawCalls, 2);
             }
         }
     }
+
+    // 2D trees are not culled; everything counts as submission
+    TREE_STATS_ADD(treeFrameStats, lodHistogram[0], 1);
+    TREE_STATS_LAP(treeFrameStats, timer, submitUs);
+}
+
+TreeStats TreeGetStats(const Tree *tree) {
+    TreeStats stats = {0};
+    if (!tree) return stats;
+
+    stats.rows = tree->CurrentRow + 1 < MAX_ROWS ? tree->CurrentRow + 1 : MAX_ROWS;
+    for (int i = 0; i < stats.rows; i++) {
+        stats.branchesPerRow[i] = tree->BranchCount[i];
+        stats.branchCount += tree->BranchCount[i];
+        if (tree->BranchCount[i] > stats.widestRow) stats.widestRow = tree->BranchCount[i];
+    }
+
+    // A leaf records the row its parent branch is on
+    for (int i = 0; i < tree->LeafCount; i++) {
+        size_t row = tree->Leaves[i].Row + 1;
+        if (row < MAX_ROWS) stats.leavesPerRow[row]++;
+    }
+
+    stats.leafCount = tree->LeafCount;
+    stats.droppedBranches = tree->droppedBranches;
+    stats.droppedLeaves = tree->droppedLeaves;
+    stats.bytesReserved = sizeof(Tree);
+    stats.bytesUsed = (size_t)stats.branchCount * sizeof(TreeBranch) + (size_t)stats.leafCount * sizeof(TreeLeaf);
+    return stats;
 }
 
 Tree TreeNewTree() {
@@ -7,7 +7,13 @@
 #include <stdio.h>
 #include <time.h>
 #include "raymath.h"
+#include "rlgl.h"
 #include <string.h>
+#include <float.h>
+#include <stdint.h>
+#include "treestats.h"
+#include "treeimpostor.h"
+#include "treechunk.h"
 
 // Configuration Macros
 #ifndef MAX_ROWS
@@ -22,10 +28,122 @@
 #define MAX_LEAVES 10000
 #endif
 
-#define TRIG_TABLE_SIZE 360
+// Rotation lookup entries per degree. Branch angles (DegX/DegZ) are kept in
+// these steps, so raising it gives finer branch directions.
+#ifndef TREE3D_TRIG_RESOLUTION
+#define TREE3D_TRIG_RESOLUTION 1
+#endif
+
+#define TRIG_TABLE_SIZE (360 * TREE3D_TRIG_RESOLUTION)
+
+// Branch angles are stored wrapped in 16 bits
+#if TRIG_TABLE_SIZE > 65535
+#error "TREE3D_TRIG_RESOLUTION is too fine for 16-bit branch angles"
+#endif
 #define LOD_LEVELS 3
+
+// Tier past the last detail level: the tree is drawn as its impostor. It is
+// also the frame statistics bucket bush impostors are counted in.
+#define TREE3D_LOD_IMPOSTOR LOD_LEVELS
+#if TREE3D_LOD_IMPOSTOR != TREE_STATS_LOD_IMPOSTOR
+#error "The impostor tier must be TREE_STATS_LOD_IMPOSTOR"
+#endif
 #define BATCH_SIZE 1000
 
+// Instanced rendering geometry detail
+#ifndef TREE3D_INSTANCE_SLICES
+#define TREE3D_INSTANCE_SLICES 8
+#endif
+
+#ifndef TREE3D_LEAF_RINGS
+#define TREE3D_LEAF_RINGS 6
+#endif
+
+#ifndef TREE3D_LEAF_SLICES
+#define TREE3D_LEAF_SLICES 8
+#endif
+
+// Baked mesh geometry detail
+#ifndef TREE3D_BAKE_SLICES
+#define TREE3D_BAKE_SLICES 8
+#endif
+
+#ifndef TREE3D_BAKE_LEAF_RINGS
+#define TREE3D_BAKE_LEAF_RINGS 4
+#endif
+
+#ifndef TREE3D_BAKE_LEAF_SLICES
+#define TREE3D_BAKE_LEAF_SLICES 6
+#endif
+
+// Near plane used for culling (raylib's default projection near plane)
+#ifndef TREE3D_CULL_NEAR
+#define TREE3D_CULL_NEAR 0.01f
+#endif
+
+// Default far culling distance (raylib's default projection far plane)
+#ifndef TREE3D_CULL_FAR
+#define TREE3D_CULL_FAR 1000.0f
+#endif
+
+// Maximum branches or leaves stored in one BVH leaf node
+#ifndef TREE3D_BVH_LEAF_SIZE
+#define TREE3D_BVH_LEAF_SIZE 4
+#endif
+
+// Canopy blobs per axis along the longest side of the leaves' bounds
+#ifndef TREE3D_CANOPY_GRID
+#define TREE3D_CANOPY_GRID 4
+#endif
+
+// Allocation hooks used when a tree has no allocator (default: C runtime)
+#ifndef TREE3D_MALLOC
+#define TREE3D_MALLOC(size) malloc(size)
+#endif
+
+#ifndef TREE3D_REALLOC
+#define TREE3D_REALLOC(ptr, size) realloc(ptr, size)
+#endif
+
+#ifndef TREE3D_FREE
+#define TREE3D_FREE(ptr) free(ptr)
+#endif
+
+// Default block size of a Tree3DArena
+#ifndef TREE3D_ARENA_BLOCK_SIZE
+#define TREE3D_ARENA_BLOCK_SIZE (1024 * 1024)
+#endif
+
+// TREE3D_GROW_PARALLEL splits rows across pthreads; define TREE3D_NO_THREADS
+// to always grow on the calling thread
+#if !defined(TREE3D_NO_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define TREE3D_THREADS
+#endif
+
+#ifndef TREE3D_MAX_GROW_THREADS
+#define TREE3D_MAX_GROW_THREADS 16
+#endif
+
+// Fewest parent branches per thread before a row is worth splitting
+#ifndef TREE3D_GROW_GRAIN
+#define TREE3D_GROW_GRAIN 256
+#endif
+
+// Culling and instancing kernels use AVX, SSE2 or AArch64 NEON when the
+// compiler targets them; define TREE3D_NO_SIMD for the scalar path
+#if !defined(TREE3D_NO_SIMD)
+#if defined(__AVX__)
+#define TREE3D_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TREE3D_SIMD_SSE
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define TREE3D_SIMD_NEON
+#endif
+#endif
+
+// Top radius of the shared branch mesh relative to its base (matches the immediate path)
+#define TREE3D_BRANCH_TAPER 0.8f
+
 
 #ifdef TREE3D_IMPLEMENTATION
 #define TREE3D_IMPL
@@ -33,30 +151,112 @@
 
 // Pre-declare structures
 typedef struct Tree3DBranch Tree3DBranch;
+typedef struct Tree3DBranchNode Tree3DBranchNode;
+typedef struct Tree3DBranchStreams Tree3DBranchStreams;
 typedef struct Tree3DLeaf Tree3DLeaf;
+typedef struct Tree3DCanopyBlob Tree3DCanopyBlob;
+typedef struct Tree3DAllocator Tree3DAllocator;
+typedef struct Tree3DArenaBlock Tree3DArenaBlock;
+typedef struct Tree3DArena Tree3DArena;
 typedef struct Tree3DMemoryPool Tree3DMemoryPool;
 typedef struct Tree3DBatchData Tree3DBatchData;
+typedef struct Tree3DInstanceData Tree3DInstanceData;
+typedef struct Tree3DImpostorInstance Tree3DImpostorInstance;
+typedef struct Tree3DBakedMesh Tree3DBakedMesh;
+typedef struct Tree3DFrustum Tree3DFrustum;
+typedef struct Tree3DBVHNode Tree3DBVHNode;
+typedef struct Tree3DBVH Tree3DBVH;
+typedef struct Tree3DQueryHit Tree3DQueryHit;
+typedef struct Tree3DRayHit Tree3DRayHit;
 typedef struct Tree3DGrowthState Tree3DGrowthState;
+typedef struct Tree3DMemoryUsage Tree3DMemoryUsage;
+typedef struct Tree3DStats Tree3DStats;
 typedef struct Tree3D Tree3D;
 
+// Allocator
+// Per-tree storage goes through tree->allocator when set, otherwise through
+// TREE3D_MALLOC/TREE3D_REALLOC/TREE3D_FREE. reallocate gets the old size so
+// allocators that do not track sizes can copy.
+struct Tree3DAllocator {
+    void* (*allocate)(void *user, size_t size);
+    void* (*reallocate)(void *user, void *ptr, size_t oldSize, size_t newSize);
+    void (*deallocate)(void *user, void *ptr);
+    void *user;
+};
+
+// Bump Arena
+// Carves allocations out of large blocks. Freeing only reclaims the most
+// recent allocation; everything else is released at once by
+// Tree3DArenaReset or Tree3DArenaDestroy, so a forest or world chunk of
+// trees costs a handful of mallocs.
+struct Tree3DArenaBlock {
+    Tree3DArenaBlock *next;
+    size_t size;
+    size_t used;
+    size_t last;            // Offset of the most recent allocation
+};
+
+struct Tree3DArena {
+    Tree3DAllocator allocator;  // Hand &arena->allocator to trees
+    Tree3DArenaBlock *blocks;   // Current block first
+    size_t blockSize;
+    size_t bytesReserved;
+    size_t bytesUsed;
+};
+
 // Memory Pool
+// Parent of a branch that starts a tree
+#define TREE3D_NO_PARENT UINT32_MAX
+
+// Branch Node
+// Compact per-branch record: its place in the tree plus the fields only
+// growth and per-branch drawing read. A branch's children are contiguous
+// in the next row.
+struct Tree3DBranchNode {
+    uint32_t parent;        // Pool index or TREE3D_NO_PARENT
+    uint32_t firstChild;    // Pool index of the first child
+    uint32_t order;         // Position in depthOrder once built
+    uint32_t subtreeSize;   // Branches in the subtree, this one included, once built
+    float height;
+    Color color;
+    uint16_t degX;          // Angles in 1/TREE3D_TRIG_RESOLUTION degree steps, wrapped
+    uint16_t degZ;
+    uint16_t childCount;
+    uint16_t row;
+};
+
+// Branch Streams
+// Branch geometry is stored structure-of-arrays: one array per field, all
+// indexed by pool index, so culling and instancing only stream the floats
+// they read. Everything else sits in the matching node.
+struct Tree3DBranchStreams {
+    float *x1, *y1, *z1;    // Base
+    float *x2, *y2, *z2;    // Tip when fully grown
+    float *width;
+    Tree3DBranchNode *nodes;
+};
+
+// Grown on demand. Rows are appended one after another, so each row is a
+// contiguous range of the branch streams starting at RowOffsets[row].
 struct Tree3DMemoryPool {
     size_t branchPoolIndex;
     size_t leafPoolIndex;
-    Tree3DBranch *branchPool;
+    size_t branchCapacity;
+    size_t leafCapacity;
+    Tree3DBranchStreams branches;
     Tree3DLeaf *leafPool;
 };
 
-// Optimized Branch Structure
+// One branch as passed to Tree3DAppendBranch and returned by
+// Tree3DGetBranch; the pool keeps its fields in Tree3DBranchStreams
 struct Tree3DBranch {
     Vector3 V1;
     Vector3 V2;
     float Width;
     float Height;
     Color Color;
-    int DegX;
+    int DegX;       // Angles in 1/TREE3D_TRIG_RESOLUTION degree steps
     int DegZ;
-    bool isActive;  // For pool management
 };
 
 // Leaf Structure
@@ -69,6 +269,16 @@ struct Tree3DLeaf {
     bool isActive;  // For pool management
 };
 
+// Canopy Blob
+// Neighbouring leaves merged into one ellipsoid for the far detail tiers,
+// see Tree3DBuildCanopy
+struct Tree3DCanopyBlob {
+    Vector3 center;
+    Vector3 radii;      // Axis-aligned half extents
+    Color color;        // Average of the merged leaves
+    int spheres;        // Leaf spheres merged into it
+};
+
 // Batch Rendering Data
 struct Tree3DBatchData {
     Vector3 *positions;
@@ -78,6 +288,96 @@ struct Tree3DBatchData {
     int capacity;
 };
 
+// Instance Rendering Data
+// Per-instance transforms for the shared branch and leaf meshes. The unused
+// bottom row of each matrix (m3, m7, m11) carries the instance color.
+// Trees at the impostor tier are queued as one quad each.
+struct Tree3DImpostorInstance {
+    const TreeImpostor *impostor;
+    Vector3 origin;
+    Vector3 viewer;
+    float scale;
+};
+
+struct Tree3DInstanceData {
+    Matrix *branchTransforms;
+    Matrix *leafTransforms;
+    Tree3DImpostorInstance *impostors;
+    int branchCount;
+    int branchCapacity;
+    int leafCount;
+    int leafCapacity;
+    int impostorCount;
+    int impostorCapacity;
+};
+
+// Baked Geometry
+// CPU-side triangles of the finished rows in tree-local space, appended one
+// row at a time and uploaded to `mesh` when dirty.
+struct Tree3DBakedMesh {
+    float *vertices;
+    unsigned char *colors;
+    int vertexCount;
+    int capacity;
+    int bakedRows;      // Rows [0, bakedRows) are in the mesh
+    int bakedLeaves;    // Leaf pool entries [0, bakedLeaves) are in the mesh
+    bool dirty;
+    Mesh mesh;
+};
+
+typedef enum {
+    TREE3D_GROW_SERIAL = 0,         // Rows grow on the calling thread
+    TREE3D_GROW_PARALLEL            // Large rows are split across threads
+} Tree3DGrowMode;
+
+typedef enum {
+    TREE3D_RENDER_IMMEDIATE = 0,    // One DrawCylinderEx/DrawSphere per branch/leaf
+    TREE3D_RENDER_INSTANCED         // One DrawMeshInstanced per mesh type
+} Tree3DRenderMode;
+
+// View Frustum
+// Planes as (normal, distance), normals pointing inward. Order: left, right,
+// bottom, top, near, far.
+struct Tree3DFrustum {
+    Vector4 planes[6];
+};
+
+// Bounding Volume Hierarchy
+// Each row gets its own hierarchy over its branches and over the leaves that
+// sit on it. Items are split by index range rather than reordered: a row is
+// appended in parent order, so a contiguous range is a set of neighbouring
+// subtrees and stays spatially coherent.
+struct Tree3DBVHNode {
+    BoundingBox bounds;
+    int first;          // First item covered (row index for branches, pool index for leaves)
+    int count;          // Items covered by this node
+    int left;           // Child nodes, -1 for a leaf node
+    int right;
+};
+
+struct Tree3DBVH {
+    Tree3DBVHNode *nodes;
+    int nodeCount;
+    int nodeCapacity;
+    int builtRows;
+    int rowBranchRoot[MAX_ROWS];    // -1 when empty
+    int rowLeafRoot[MAX_ROWS];      // Leaves sitting on the row, -1 when none
+    BoundingBox rowBounds[MAX_ROWS];
+};
+
+// Query result: a branch (Tree3DGetBranch(tree, row, index)) or a leaf (leafPool[index], sitting on row)
+struct Tree3DQueryHit {
+    int row;
+    int index;
+    bool isLeaf;
+};
+
+struct Tree3DRayHit {
+    Tree3DQueryHit item;
+    float distance;
+    Vector3 point;
+};
+
 // Growth State Tracking
 struct Tree3DGrowthState {
     bool needsUpdate;
@@ -86,26 +386,82 @@ struct Tree3DGrowthState {
     int lastUpdateTime;
 };
 
+// Heap bytes held by a tree versus the bytes its current contents need
+struct Tree3DMemoryUsage {
+    size_t bytesReserved;
+    size_t bytesUsed;
+};
+
+// Structure and memory report of one tree, see Tree3DGetStats. Counts and
+// high-water marks cover growth since the last Tree3DLoad.
+struct Tree3DStats {
+    int rows;                       // Rows grown, against MAX_ROWS
+    int branchesPerRow[MAX_ROWS];
+    int leavesPerRow[MAX_ROWS];     // Leaves sitting on each row's branches
+    int branchCount;                // Against MAX_ROWS * MAX_BRANCHES_PER_ROW
+    int leafCount;                  // Against MAX_LEAVES
+    int widestRow;                  // Most branches in a row, against MAX_BRANCHES_PER_ROW
+    int droppedBranches;            // Not grown because a row or the pool was full
+    int droppedLeaves;
+    Tree3DMemoryUsage memory;       // All CPU-side storage, as Tree3DGetMemoryUsage
+    Tree3DMemoryUsage branchPool;
+    Tree3DMemoryUsage leafPool;
+    int bakedVertices;
+    size_t bakedBytes;              // CPU copy of the baked mesh
+    size_t bakedGPUBytes;           // Uploaded baked mesh, 0 when not on the GPU
+    int canopyBlobs;
+    int instanceCapacity;           // Branch and leaf transforms in instanceData
+    size_t instanceBytes;
+};
+
 // Main Tree Structure
 struct Tree3D {
     // Memory management
+    const Tree3DAllocator *allocator;   // NULL for the TREE3D_MALLOC hooks; set before Tree3DLoad
     Tree3DMemoryPool memPool;
     Tree3DBatchData batchData;
+    Tree3DInstanceData instanceData;
+    Tree3DBakedMesh baked;
+    Tree3DBVH bvh;
     
     // Core data structures
-    Tree3DBranch ***Branches;
+    int *RowOffsets;        // First branch pool index of each row
     int *BranchCount;
+    uint32_t *depthOrder;   // Pool indices in depth-first order; each subtree is a slice
+    int depthOrderCount;    // Branches covered by depthOrder, 0 until built
+    int depthOrderCapacity;
+    bool buildDepthOrder;   // Build depthOrder as soon as growth finishes
     Tree3DLeaf *Leaves;
     int LeafCount;
+    Tree3DCanopyBlob *canopy;   // Leaf clusters drawn by canopy tiers
+    int canopyCount;
+    int canopyCapacity;
+    int canopyLeaves;       // LeafCount the canopy was built from
     
     // Optimization data
-    float *sinTable;
-    float *cosTable;
     BoundingBox bounds;
     bool needsBoundsUpdate;
-    float lodDistances[LOD_LEVELS];
-    int lodLevels[LOD_LEVELS];
+    float cullDistance;
+    
+    // Detail tiers, picked once per tree from its height on screen
+    float lodScreenSizes[LOD_LEVELS];   // Tier i while the tree is at least this many pixels tall
+    int lodLevels[LOD_LEVELS];          // Cylinder slices when drawing immediately
+    int lodSkipRows[LOD_LEVELS];        // Outermost (thinnest) rows left out
+    int lodLeafMerge[LOD_LEVELS];       // Leaf spheres per drawn sphere: 1, 2 (one per leaf), 2n (n leaves)
+    bool lodCanopy[LOD_LEVELS];         // Canopy blobs instead of leaves
+    const TreeImpostor *impostor;       // Shared views of the species, NULL for none
+    float impostorScreenSize;           // Fully grown trees shorter than this many pixels draw the impostor
     Tree3DGrowthState growthState;
+    Tree3DRenderMode renderMode;
+    bool useBakedMesh;                  // Finished rows in one mesh, drawn by tiers that leave nothing out
+    Tree3DGrowMode growMode;
+    int growThreads;                // 0 for one per core (TREE3D_GROW_PARALLEL)
+    
+    // Random generation: the same Seed and properties always grow the same
+    // tree. A Seed of 0 is derived from the position at Tree3DLoad.
+    uint64_t Seed;
+    uint64_t rngState;
+    uint64_t growKey;               // Keys the per-branch growth numbers
     
     // Tree properties
     float LeafChance;
@@ -114,6 +470,7 @@ struct Tree3D {
     float X, Y, Z;
     int CurrentRow;
     bool RandomRow;
+    int generateRow;                // Row RandomRow fast-forwards to, see Tree3DLoadBegin
     int SplitChance;
     int SplitAngle[2];
     unsigned char CsBranch[6];
@@ -124,455 +481,3091 @@ struct Tree3D {
     float Width;
     float Height;
     
-    // Allocation tracking
+    // Allocation tracking (entries reserved, see Tree3DGetMemoryUsage for bytes)
     int AllocatedRows;
-    int AllocatedBranchesPerRow;
+    int AllocatedBranches;
     int AllocatedLeaves;
+    int droppedBranches;            // Growth past a full row or pool since Tree3DLoad
+    int droppedLeaves;
 };
 
 // Function Declarations
 Tree3D Tree3DNewTree(void);
 Tree3D Tree3DNewJungleTree(float x, float y, float z);
 void Tree3DLoad(Tree3D *tree);
+void Tree3DLoadBegin(Tree3D *tree);
+bool Tree3DGenerateStep(Tree3D *tree);
+bool Tree3DIsGenerating(const Tree3D *tree);
+int Tree3DGenerate(Tree3D *trees, int count, int *cursor, float budgetUs);
 void Tree3DUpdate(Tree3D *tree);
 void Tree3DDraw(Tree3D *tree, Camera3D camera);
 void Tree3DFree(Tree3D *tree);
+void Tree3DSeedRandom(Tree3D *tree);
+float Tree3DRandom(Tree3D *tree);
+int Tree3DRandomInt(Tree3D *tree, int n);
 
 // Optimization Function Declarations
 void Tree3DInitMemoryPool(Tree3D *tree);
-void Tree3DInitTrigTables(Tree3D *tree);
+void Tree3DReserveStorage(Tree3D *tree);
+void Tree3DShrinkStorage(Tree3D *tree);
+void Tree3DMoveStorage(Tree3D *tree, const Tree3DAllocator *allocator);
+Tree3DMemoryUsage Tree3DGetMemoryUsage(const Tree3D *tree);
+Tree3DStats Tree3DGetStats(const Tree3D *tree);
+Tree3DBranch Tree3DGetBranch(const Tree3D *tree, int row, int index);
+bool Tree3DGetBranchParent(const Tree3D *tree, int row, int index, int *parentRow, int *parentIndex);
+int Tree3DGetBranchChildren(const Tree3D *tree, int row, int index, int *firstChild);
+void Tree3DBuildDepthOrder(Tree3D *tree);
+const uint32_t* Tree3DGetSubtree(Tree3D *tree, int row, int index, int *count);
+void Tree3DBuildCanopy(Tree3D *tree);
+void Tree3DInitTrigTables(void);
 void Tree3DInitBatchData(Tree3D *tree);
 void Tree3DUpdateBounds(Tree3D *tree);
-Vector3 Tree3DGetRotation(Tree3D *tree, int degX, int degZ);
-bool Tree3DIsVisible(const Tree3D *tree, Vector3 point, Camera3D camera);
-int Tree3DGetLODLevel(const Tree3D *tree, Vector3 position, Camera3D camera);
+Vector3 Tree3DGetRotation(int degX, int degZ);
+bool Tree3DIsVisible(const Tree3D *tree, Camera3D camera);
+bool Tree3DHasImpostor(const Tree3D *tree);
+bool Tree3DBakeImpostor(Tree3D *tree, TreeImpostor *impostor, int views, int cellSize);
+void Tree3DAppendToChunk(Tree3D *tree, TreeChunkMesh *chunk);
+int Tree3DSelectLOD(Tree3D *tree, Camera3D camera);
 void Tree3DBatchDraw(Tree3D *tree,  Camera3D camera);
+void Tree3DDrawFrustum(Tree3D *tree, Camera3D camera, const Tree3DFrustum *frustum,
+                       int lodLevel, Tree3DInstanceData *shared);
+
+// Instanced Rendering Declarations
+bool Tree3DInitRenderer(void);
+void Tree3DCloseRenderer(void);
+void Tree3DInitInstanceData(Tree3DInstanceData *data);
+void Tree3DClearInstanceData(Tree3DInstanceData *data);
+void Tree3DFreeInstanceData(Tree3DInstanceData *data);
+void Tree3DCollectInstances(Tree3D *tree, const Tree3DFrustum *frustum, Tree3DInstanceData *data);
+void Tree3DDrawInstances(Tree3DInstanceData *data);
+
+// Frustum Culling Declarations
+Tree3DFrustum Tree3DGetCameraFrustum(Camera3D camera, float aspect, float farDistance);
+bool Tree3DFrustumContainsBox(const Tree3DFrustum *frustum, BoundingBox box);
+bool Tree3DFrustumContainsSphere(const Tree3DFrustum *frustum, Vector3 center, float radius);
+float Tree3DGetScreenAspect(void);
+
+// Spatial Query Declarations
+void Tree3DResetBVH(Tree3D *tree);
+void Tree3DBuildRowBVH(Tree3D *tree, int row, int firstLeaf, int leafCount);
+void Tree3DFreeBVH(Tree3D *tree);
+int Tree3DQueryBox(const Tree3D *tree, BoundingBox box, Tree3DQueryHit *hits, int maxHits);
+int Tree3DQuerySphere(const Tree3D *tree, Vector3 center, float radius, Tree3DQueryHit *hits, int maxHits);
+bool Tree3DRaycast(const Tree3D *tree, Ray ray, float maxDistance, Tree3DRayHit *hit);
+
+// Baked Mesh Declarations
+void Tree3DBakeRows(Tree3D *tree, int rowCount);
+void Tree3DResetBakedMesh(Tree3D *tree);
+void Tree3DDrawBakedMesh(Tree3D *tree);
+void Tree3DFreeBakedMesh(Tree3D *tree);
+
+// Allocator Declarations
+Tree3DArena* Tree3DArenaCreate(size_t blockSize);
+void Tree3DArenaReset(Tree3DArena *arena);
+void Tree3DArenaDestroy(Tree3DArena *arena);
+
+// Instrumentation Declarations (see treestats.h)
+void Tree3DSetFrameStats(TreeFrameStats *stats);
+void Tree3DSetProfileZones(TreeProfileZones zones);
 
 #ifdef TREE3D_IMPL
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-#define DEG_TO_RAD (M_PI / 180.0)
+#ifdef TREE3D_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(TREE3D_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(TREE3D_SIMD_SSE)
+#include <emmintrin.h>
+#elif defined(TREE3D_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+#define DEG_TO_RAD (M_PI / 180.0)
+
+// Instrumentation
+static TreeFrameStats *tree3dFrameStats = NULL;
+static TreeProfileZones tree3dZones = {0};
+
+void Tree3DSetFrameStats(TreeFrameStats *stats) {
+    tree3dFrameStats = stats;
+}
+
+void Tree3DSetProfileZones(TreeProfileZones zones) {
+    tree3dZones = zones;
+}
+
+// Allocation
+static void* Tree3DAlloc(const Tree3D *tree, size_t size) {
+    if (tree->allocator) return tree->allocator->allocate(tree->allocator->user, size);
+    return TREE3D_MALLOC(size);
+}
+
+static void* Tree3DRealloc(const Tree3D *tree, void *ptr, size_t oldSize, size_t newSize) {
+    if (tree->allocator) return tree->allocator->reallocate(tree->allocator->user, ptr, oldSize, newSize);
+    return TREE3D_REALLOC(ptr, newSize);
+}
+
+static void Tree3DDealloc(const Tree3D *tree, void *ptr) {
+    if (!ptr) return;
+    if (tree->allocator) tree->allocator->deallocate(tree->allocator->user, ptr);
+    else TREE3D_FREE(ptr);
+}
+
+#define TREE3D_ARENA_ALIGN 16
+
+static size_t Tree3DArenaAlign(size_t size) {
+    return (size + TREE3D_ARENA_ALIGN - 1) & ~(size_t)(TREE3D_ARENA_ALIGN - 1);
+}
+
+static unsigned char* Tree3DArenaData(Tree3DArenaBlock *block) {
+    return (unsigned char*)block + Tree3DArenaAlign(sizeof(Tree3DArenaBlock));
+}
+
+static void* Tree3DArenaAllocate(void *user, size_t size) {
+    Tree3DArena *arena = (Tree3DArena*)user;
+    size = Tree3DArenaAlign(size > 0 ? size : 1);
+    
+    Tree3DArenaBlock *block = arena->blocks;
+    if (!block || block->used + size > block->size) {
+        size_t blockSize = size > arena->blockSize ? size : arena->blockSize;
+        Tree3DArenaBlock *fresh = (Tree3DArenaBlock*)TREE3D_MALLOC(Tree3DArenaAlign(sizeof(Tree3DArenaBlock)) + blockSize);
+        if (!fresh) return NULL;
+        
+        fresh->size = blockSize;
+        fresh->used = fresh->last = 0;
+        arena->bytesReserved += blockSize;
+        
+        if (block && size > arena->blockSize) {
+            // Oversized allocations get a block of their own behind the current one
+            fresh->next = block->next;
+            block->next = fresh;
+        } else {
+            fresh->next = block;
+            arena->blocks = fresh;
+        }
+        block = fresh;
+    }
+    
+    block->last = block->used;
+    block->used += size;
+    arena->bytesUsed += size;
+    return Tree3DArenaData(block) + block->last;
+}
+
+static void* Tree3DArenaReallocate(void *user, void *ptr, size_t oldSize, size_t newSize) {
+    Tree3DArena *arena = (Tree3DArena*)user;
+    if (!ptr) return Tree3DArenaAllocate(user, newSize);
+    
+    // The most recent allocation of the current block resizes in place
+    Tree3DArenaBlock *block = arena->blocks;
+    if (block && (unsigned char*)ptr == Tree3DArenaData(block) + block->last) {
+        size_t end = block->last + Tree3DArenaAlign(newSize > 0 ? newSize : 1);
+        if (end <= block->size) {
+            arena->bytesUsed = arena->bytesUsed - block->used + end;
+            block->used = end;
+            return ptr;
+        }
+    }
+    
+    if (newSize <= oldSize) return ptr;
+    
+    void *grown = Tree3DArenaAllocate(user, newSize);
+    if (grown) memcpy(grown, ptr, oldSize);
+    return grown;
+}
+
+static void Tree3DArenaDeallocate(void *user, void *ptr) {
+    Tree3DArena *arena = (Tree3DArena*)user;
+    Tree3DArenaBlock *block = arena->blocks;
+    
+    if (block && (unsigned char*)ptr == Tree3DArenaData(block) + block->last && block->last < block->used) {
+        arena->bytesUsed -= block->used - block->last;
+        block->used = block->last;
+    }
+}
+
+Tree3DArena* Tree3DArenaCreate(size_t blockSize) {
+    Tree3DArena *arena = (Tree3DArena*)TREE3D_MALLOC(sizeof(Tree3DArena));
+    if (!arena) {
+        fprintf(stderr, "Failed to allocate arena\n");
+        exit(1);
+    }
+    
+    *arena = (Tree3DArena){0};
+    arena->blockSize = blockSize > 0 ? blockSize : TREE3D_ARENA_BLOCK_SIZE;
+    arena->allocator = (Tree3DAllocator){
+        Tree3DArenaAllocate, Tree3DArenaReallocate, Tree3DArenaDeallocate, arena
+    };
+    return arena;
+}
+
+// Drop every allocation, keeping the current block for reuse
+void Tree3DArenaReset(Tree3DArena *arena) {
+    if (!arena || !arena->blocks) return;
+    
+    Tree3DArenaBlock *block = arena->blocks->next;
+    while (block) {
+        Tree3DArenaBlock *next = block->next;
+        arena->bytesReserved -= block->size;
+        TREE3D_FREE(block);
+        block = next;
+    }
+    
+    arena->blocks->next = NULL;
+    arena->blocks->used = arena->blocks->last = 0;
+    arena->bytesUsed = 0;
+}
+
+void Tree3DArenaDestroy(Tree3DArena *arena) {
+    if (!arena) return;
+    
+    Tree3DArenaBlock *block = arena->blocks;
+    while (block) {
+        Tree3DArenaBlock *next = block->next;
+        TREE3D_FREE(block);
+        block = next;
+    }
+    TREE3D_FREE(arena);
+}
+
+// Trig lookup tables, shared by every tree
+static float tree3dSinTable[TRIG_TABLE_SIZE];
+static float tree3dCosTable[TRIG_TABLE_SIZE];
+
+static void Tree3DFillTrigTables(void) {
+    for (int i = 0; i < TRIG_TABLE_SIZE; i++) {
+        float rad = i * DEG_TO_RAD / TREE3D_TRIG_RESOLUTION;
+        tree3dSinTable[i] = sinf(rad);
+        tree3dCosTable[i] = cosf(rad);
+    }
+}
+
+// Fill the shared tables once. Tree3DLoad calls this, from any number of
+// threads; without TREE3D_THREADS there is only the calling thread.
+#ifdef TREE3D_THREADS
+static pthread_once_t tree3dTrigOnce = PTHREAD_ONCE_INIT;
+
+void Tree3DInitTrigTables(void) {
+    pthread_once(&tree3dTrigOnce, Tree3DFillTrigTables);
+}
+#else
+static bool tree3dTrigReady = false;
+
+void Tree3DInitTrigTables(void) {
+    if (tree3dTrigReady) return;
+    Tree3DFillTrigTables();
+    tree3dTrigReady = true;
+}
+#endif
+
+// Pools start empty; Tree3DLoad reserves them once MaxRow and SplitChance are known
+void Tree3DInitMemoryPool(Tree3D *tree) {
+    tree->memPool = (Tree3DMemoryPool){0};
+}
+
+// Bytes per branch across all streams
+#define TREE3D_BRANCH_BYTES (7 * sizeof(float) + sizeof(Tree3DBranchNode))
+
+static void* Tree3DResizeStream(Tree3D *tree, void *stream, size_t oldCount, size_t newCount, size_t elementSize) {
+    void *resized = Tree3DRealloc(tree, stream, oldCount * elementSize, newCount * elementSize);
+    if (!resized) {
+        fprintf(stderr, "Failed to allocate branch pool\n");
+        exit(1);
+    }
+    return resized;
+}
+
+// Resize every branch stream to exactly `capacity` entries
+static void Tree3DResizeBranchPool(Tree3D *tree, size_t capacity) {
+    Tree3DBranchStreams *s = &tree->memPool.branches;
+    size_t old = tree->memPool.branchCapacity;
+    
+#define TREE3D_RESIZE_STREAM(field) \
+    s->field = Tree3DResizeStream(tree, s->field, old, capacity, sizeof(*s->field))
+    TREE3D_RESIZE_STREAM(x1); TREE3D_RESIZE_STREAM(y1); TREE3D_RESIZE_STREAM(z1);
+    TREE3D_RESIZE_STREAM(x2); TREE3D_RESIZE_STREAM(y2); TREE3D_RESIZE_STREAM(z2);
+    TREE3D_RESIZE_STREAM(width);
+    TREE3D_RESIZE_STREAM(nodes);
+#undef TREE3D_RESIZE_STREAM
+    
+    tree->memPool.branchCapacity = capacity;
+    tree->AllocatedBranches = (int)capacity;
+}
+
+static void Tree3DFreeBranchPool(Tree3D *tree) {
+    Tree3DBranchStreams *s = &tree->memPool.branches;
+    if (!s->x1) return;
+    
+#define TREE3D_FREE_STREAM(field) Tree3DDealloc(tree, s->field)
+    TREE3D_FREE_STREAM(x1); TREE3D_FREE_STREAM(y1); TREE3D_FREE_STREAM(z1);
+    TREE3D_FREE_STREAM(x2); TREE3D_FREE_STREAM(y2); TREE3D_FREE_STREAM(z2);
+    TREE3D_FREE_STREAM(width);
+    TREE3D_FREE_STREAM(nodes);
+#undef TREE3D_FREE_STREAM
+    
+    *s = (Tree3DBranchStreams){0};
+}
+
+static void Tree3DResizeLeafPool(Tree3D *tree, size_t capacity) {
+    Tree3DLeaf *pool = (Tree3DLeaf*)Tree3DRealloc(tree, tree->memPool.leafPool,
+                                                 tree->memPool.leafCapacity * sizeof(Tree3DLeaf),
+                                                 capacity * sizeof(Tree3DLeaf));
+    if (!pool) {
+        fprintf(stderr, "Failed to allocate leaf pool\n");
+        exit(1);
+    }
+    
+    tree->memPool.leafPool = pool;
+    tree->memPool.leafCapacity = capacity;
+    tree->AllocatedLeaves = (int)capacity;
+}
+
+// Make room for at least `needed` branches, growing by half again when short
+static void Tree3DReserveBranches(Tree3D *tree, size_t needed) {
+    size_t limit = (size_t)MAX_ROWS * MAX_BRANCHES_PER_ROW;
+    if (needed > limit) needed = limit;
+    if (needed <= tree->memPool.branchCapacity) return;
+    
+    size_t capacity = tree->memPool.branchCapacity + tree->memPool.branchCapacity / 2;
+    if (capacity < needed) capacity = needed;
+    if (capacity > limit) capacity = limit;
+    Tree3DResizeBranchPool(tree, capacity);
+}
+
+static void Tree3DReserveLeaves(Tree3D *tree, size_t needed) {
+    if (needed > MAX_LEAVES) needed = MAX_LEAVES;
+    if (needed <= tree->memPool.leafCapacity) return;
+    
+    size_t capacity = tree->memPool.leafCapacity + tree->memPool.leafCapacity / 2;
+    if (capacity < needed) capacity = needed;
+    if (capacity > MAX_LEAVES) capacity = MAX_LEAVES;
+    Tree3DResizeLeafPool(tree, capacity);
+}
+
+// Expected branch and leaf totals of a fully grown tree. Each branch carries
+// on as one branch, or two with SplitChance percent; a branch added while
+// growing row r gets a leaf when rand * r / MaxRow exceeds LeafChance.
+static void Tree3DEstimateStorage(const Tree3D *tree, size_t *branches, size_t *leaves) {
+    float growth = 1.0f + Clamp((float)tree->SplitChance, 0.0f, 100.0f) / 100.0f;
+    float rowBranches = 1.0f;
+    float totalBranches = 1.0f;
+    float totalLeaves = 0.0f;
+    
+    for (int r = 0; r < tree->MaxRow && r + 1 < MAX_ROWS; r++) {
+        rowBranches = fminf(rowBranches * growth, (float)MAX_BRANCHES_PER_ROW);
+        totalBranches += rowBranches;
+        
+        if (r > 0 && tree->LeafChance < 1.0f) {
+            float leafProbability = 1.0f - tree->LeafChance * tree->MaxRow / (float)r;
+            if (leafProbability > 0.0f) totalLeaves += rowBranches * leafProbability;
+        }
+    }
+    
+    *branches = (size_t)ceilf(totalBranches);
+    *leaves = (size_t)ceilf(totalLeaves);
+}
+
+static void Tree3DReserveRowTables(Tree3D *tree) {
+    int rows = tree->MaxRow + 1;
+    if (rows > MAX_ROWS) rows = MAX_ROWS;
+    if (rows < 1) rows = 1;
+    
+    if (rows > tree->AllocatedRows) {
+        size_t oldSize = tree->AllocatedRows * sizeof(int);
+        int *offsets = (int*)Tree3DRealloc(tree, tree->RowOffsets, oldSize, rows * sizeof(int));
+        if (offsets) tree->RowOffsets = offsets;
+        int *counts = (int*)Tree3DRealloc(tree, tree->BranchCount, oldSize, rows * sizeof(int));
+        if (counts) tree->BranchCount = counts;
+        
+        if (!offsets || !counts) {
+            fprintf(stderr, "Failed to allocate row tables\n");
+            exit(1);
+        }
+        tree->AllocatedRows = rows;
+    }
+}
+
+// Size the row tables for MaxRow and the pools for the expected tree
+void Tree3DReserveStorage(Tree3D *tree) {
+    Tree3DReserveRowTables(tree);
+    
+    size_t branches, leaves;
+    Tree3DEstimateStorage(tree, &branches, &leaves);
+    Tree3DReserveBranches(tree, branches);
+    Tree3DReserveLeaves(tree, leaves);
+}
+
+// Release the slack left by growth once no more branches will be added
+void Tree3DShrinkStorage(Tree3D *tree) {
+    if (tree->memPool.branchPoolIndex > 0 && tree->memPool.branchPoolIndex < tree->memPool.branchCapacity) {
+        Tree3DResizeBranchPool(tree, tree->memPool.branchPoolIndex);
+    }
+    if (tree->memPool.leafPoolIndex > 0 && tree->memPool.leafPoolIndex < tree->memPool.leafCapacity) {
+        Tree3DResizeLeafPool(tree, tree->memPool.leafPoolIndex);
+    }
+}
+
+static void* Tree3DMoveBuffer(const Tree3D *tree, const Tree3DAllocator *allocator, void *ptr, size_t size) {
+    if (!ptr) return NULL;
+    
+    if (size == 0) size = 1;
+    void *moved = allocator ? allocator->allocate(allocator->user, size) : TREE3D_MALLOC(size);
+    if (!moved) {
+        fprintf(stderr, "Failed to move tree storage\n");
+        exit(1);
+    }
+    
+    memcpy(moved, ptr, size);
+    Tree3DDealloc(tree, ptr);
+    return moved;
+}
+
+// Copy the tree's storage to another allocator (NULL for the TREE3D_MALLOC
+// hooks) and free it from the old one, e.g. to pack a tree into an arena
+// once it has finished growing and Tree3DShrinkStorage has trimmed it
+void Tree3DMoveStorage(Tree3D *tree, const Tree3DAllocator *allocator) {
+    if (!tree || tree->allocator == allocator) return;
+    
+#define TREE3D_MOVE(field, count) \
+    tree->field = Tree3DMoveBuffer(tree, allocator, tree->field, (size_t)(count) * sizeof(*tree->field))
+    TREE3D_MOVE(RowOffsets, tree->AllocatedRows);
+    TREE3D_MOVE(BranchCount, tree->AllocatedRows);
+    TREE3D_MOVE(memPool.branches.x1, tree->memPool.branchCapacity);
+    TREE3D_MOVE(memPool.branches.y1, tree->memPool.branchCapacity);
+    TREE3D_MOVE(memPool.branches.z1, tree->memPool.branchCapacity);
+    TREE3D_MOVE(memPool.branches.x2, tree->memPool.branchCapacity);
+    TREE3D_MOVE(memPool.branches.y2, tree->memPool.branchCapacity);
+    TREE3D_MOVE(memPool.branches.z2, tree->memPool.branchCapacity);
+    TREE3D_MOVE(memPool.branches.width, tree->memPool.branchCapacity);
+    TREE3D_MOVE(memPool.branches.nodes, tree->memPool.branchCapacity);
+    TREE3D_MOVE(memPool.leafPool, tree->memPool.leafCapacity);
+    TREE3D_MOVE(depthOrder, tree->depthOrderCapacity);
+    TREE3D_MOVE(canopy, tree->canopyCapacity);
+    TREE3D_MOVE(batchData.positions, tree->batchData.capacity * 2);
+    TREE3D_MOVE(batchData.widths, tree->batchData.capacity * 2);
+    TREE3D_MOVE(batchData.colors, tree->batchData.capacity);
+    TREE3D_MOVE(baked.vertices, tree->baked.capacity * 3);
+    TREE3D_MOVE(baked.colors, tree->baked.capacity * 4);
+    TREE3D_MOVE(bvh.nodes, tree->bvh.nodeCapacity);
+#undef TREE3D_MOVE
+    
+    tree->allocator = allocator;
+}
+
+// CPU-side heap held by the tree (pools, row tables, scratch and baked
+// buffers) against what its current contents occupy. GPU buffers are not counted.
+Tree3DMemoryUsage Tree3DGetMemoryUsage(const Tree3D *tree) {
+    Tree3DMemoryUsage usage = {0};
+    if (!tree) return usage;
+    
+    int usedRows = tree->CurrentRow + 1 < tree->AllocatedRows ? tree->CurrentRow + 1 : tree->AllocatedRows;
+    size_t batchBytes = 2 * sizeof(Vector3) + 2 * sizeof(float) + sizeof(Color);
+    size_t bakedBytes = 3 * sizeof(float) + 4 * sizeof(unsigned char);
+    
+    usage.bytesReserved += tree->memPool.branchCapacity * TREE3D_BRANCH_BYTES;
+    usage.bytesUsed += tree->memPool.branchPoolIndex * TREE3D_BRANCH_BYTES;
+    usage.bytesReserved += (size_t)tree->depthOrderCapacity * sizeof(uint32_t);
+    usage.bytesUsed += (size_t)tree->depthOrderCount * sizeof(uint32_t);
+    usage.bytesReserved += tree->memPool.leafCapacity * sizeof(Tree3DLeaf);
+    usage.bytesUsed += tree->memPool.leafPoolIndex * sizeof(Tree3DLeaf);
+    usage.bytesReserved += (size_t)tree->canopyCapacity * sizeof(Tree3DCanopyBlob);
+    usage.bytesUsed += (size_t)tree->canopyCount * sizeof(Tree3DCanopyBlob);
+    
+    usage.bytesReserved += (size_t)tree->AllocatedRows * 2 * sizeof(int);
+    usage.bytesUsed += (size_t)usedRows * 2 * sizeof(int);
+    
+    usage.bytesReserved += (size_t)tree->batchData.capacity * batchBytes;
+    usage.bytesUsed += (size_t)tree->batchData.count * batchBytes;
+    
+    usage.bytesReserved += (size_t)(tree->instanceData.branchCapacity + tree->instanceData.leafCapacity) * sizeof(Matrix);
+    usage.bytesUsed += (size_t)(tree->instanceData.branchCount + tree->instanceData.leafCount) * sizeof(Matrix);
+    usage.bytesReserved += (size_t)tree->instanceData.impostorCapacity * sizeof(Tree3DImpostorInstance);
+    usage.bytesUsed += (size_t)tree->instanceData.impostorCount * sizeof(Tree3DImpostorInstance);
+    
+    usage.bytesReserved += (size_t)tree->baked.capacity * bakedBytes;
+    usage.bytesUsed += (size_t)tree->baked.vertexCount * bakedBytes;
+    
+    usage.bytesReserved += (size_t)tree->bvh.nodeCapacity * sizeof(Tree3DBVHNode);
+    usage.bytesUsed += (size_t)tree->bvh.nodeCount * sizeof(Tree3DBVHNode);
+    
+    return usage;
+}
+
+// Per-row counts, pool high-water marks and buffer sizes of a tree
+Tree3DStats Tree3DGetStats(const Tree3D *tree) {
+    Tree3DStats stats = {0};
+    if (!tree || !tree->BranchCount) return stats;
+    
+    stats.rows = tree->CurrentRow + 1 < tree->AllocatedRows ? tree->CurrentRow + 1 : tree->AllocatedRows;
+    for (int i = 0; i < stats.rows; i++) {
+        stats.branchesPerRow[i] = tree->BranchCount[i];
+        if (tree->BranchCount[i] > stats.widestRow) stats.widestRow = tree->BranchCount[i];
+    }
+    
+    // A leaf records the row its parent branch is on
+    for (size_t i = 0; i < tree->memPool.leafPoolIndex; i++) {
+        size_t row = tree->memPool.leafPool[i].Row + 1;
+        if (row < MAX_ROWS) stats.leavesPerRow[row]++;
+    }
+    
+    stats.branchCount = (int)tree->memPool.branchPoolIndex;
+    stats.leafCount = (int)tree->memPool.leafPoolIndex;
+    stats.droppedBranches = tree->droppedBranches;
+    stats.droppedLeaves = tree->droppedLeaves;
+    
+    stats.memory = Tree3DGetMemoryUsage(tree);
+    stats.branchPool.bytesReserved = tree->memPool.branchCapacity * TREE3D_BRANCH_BYTES;
+    stats.branchPool.bytesUsed = tree->memPool.branchPoolIndex * TREE3D_BRANCH_BYTES;
+    stats.leafPool.bytesReserved = tree->memPool.leafCapacity * sizeof(Tree3DLeaf);
+    stats.leafPool.bytesUsed = tree->memPool.leafPoolIndex * sizeof(Tree3DLeaf);
+    
+    size_t bakedVertexBytes = 3 * sizeof(float) + 4 * sizeof(unsigned char);
+    stats.bakedVertices = tree->baked.vertexCount;
+    stats.bakedBytes = (size_t)tree->baked.capacity * bakedVertexBytes;
+    if (tree->baked.mesh.vaoId != 0) {
+        stats.bakedGPUBytes = (size_t)tree->baked.mesh.vertexCount * bakedVertexBytes;
+    }
+    
+    stats.canopyBlobs = tree->canopyCount;
+    stats.instanceCapacity = tree->instanceData.branchCapacity + tree->instanceData.leafCapacity;
+    stats.instanceBytes = (size_t)stats.instanceCapacity * sizeof(Matrix);
+    return stats;
+}
+
+static size_t Tree3DBranchIndex(const Tree3D *tree, int row, int index) {
+    return (size_t)tree->RowOffsets[row] + index;
+}
+
+static Vector3 Tree3DBranchStart(const Tree3DBranchStreams *s, size_t i) {
+    return (Vector3){s->x1[i], s->y1[i], s->z1[i]};
+}
+
+static Vector3 Tree3DBranchTip(const Tree3DBranchStreams *s, size_t i) {
+    return (Vector3){s->x2[i], s->y2[i], s->z2[i]};
+}
+
+static int Tree3DWrapAngle(int deg) {
+    deg %= TRIG_TABLE_SIZE;
+    return deg < 0 ? deg + TRIG_TABLE_SIZE : deg;
+}
+
+static void Tree3DStoreBranch(Tree3DBranchStreams *s, size_t i, const Tree3DBranch *b, uint32_t parent, int row) {
+    s->x1[i] = b->V1.x; s->y1[i] = b->V1.y; s->z1[i] = b->V1.z;
+    s->x2[i] = b->V2.x; s->y2[i] = b->V2.y; s->z2[i] = b->V2.z;
+    s->width[i] = b->Width;
+    s->nodes[i] = (Tree3DBranchNode){
+        .parent = parent,
+        .height = b->Height,
+        .color = b->Color,
+        .degX = (uint16_t)Tree3DWrapAngle(b->DegX),
+        .degZ = (uint16_t)Tree3DWrapAngle(b->DegZ),
+        .row = (uint16_t)row
+    };
+}
+
+// Copy of a branch gathered from the streams
+Tree3DBranch Tree3DGetBranch(const Tree3D *tree, int row, int index) {
+    const Tree3DBranchStreams *s = &tree->memPool.branches;
+    size_t i = Tree3DBranchIndex(tree, row, index);
+    return (Tree3DBranch){
+        .V1 = Tree3DBranchStart(s, i),
+        .V2 = Tree3DBranchTip(s, i),
+        .Width = s->width[i],
+        .Height = s->nodes[i].height,
+        .Color = s->nodes[i].color,
+        .DegX = s->nodes[i].degX,
+        .DegZ = s->nodes[i].degZ
+    };
+}
+
+// Row and index of a branch's parent; false for the trunk or a branch
+// appended without one
+bool Tree3DGetBranchParent(const Tree3D *tree, int row, int index, int *parentRow, int *parentIndex) {
+    const Tree3DBranchNode *node = &tree->memPool.branches.nodes[Tree3DBranchIndex(tree, row, index)];
+    if (node->parent == TREE3D_NO_PARENT) return false;
+    
+    const Tree3DBranchNode *parent = &tree->memPool.branches.nodes[node->parent];
+    if (parentRow) *parentRow = parent->row;
+    if (parentIndex) *parentIndex = (int)node->parent - tree->RowOffsets[parent->row];
+    return true;
+}
+
+// Number of children of a branch; they are indices [firstChild,
+// firstChild + count) of row + 1
+int Tree3DGetBranchChildren(const Tree3D *tree, int row, int index, int *firstChild) {
+    const Tree3DBranchNode *node = &tree->memPool.branches.nodes[Tree3DBranchIndex(tree, row, index)];
+    if (firstChild) *firstChild = node->childCount > 0 ? (int)node->firstChild - tree->RowOffsets[row + 1] : 0;
+    return node->childCount;
+}
+
+// Lay every subtree out as a contiguous slice of depthOrder. Sizes are
+// summed from the last row up, then each child's slice starts after its
+// parent and earlier siblings; rows keep their storage order.
+void Tree3DBuildDepthOrder(Tree3D *tree) {
+    Tree3DBranchNode *nodes = tree->memPool.branches.nodes;
+    int count = (int)tree->memPool.branchPoolIndex;
+    
+    if (count > tree->depthOrderCapacity) {
+        uint32_t *order = (uint32_t*)Tree3DRealloc(tree, tree->depthOrder,
+                                                   tree->depthOrderCapacity * sizeof(uint32_t),
+                                                   count * sizeof(uint32_t));
+        if (!order) {
+            fprintf(stderr, "Failed to allocate depth order\n");
+            exit(1);
+        }
+        tree->depthOrder = order;
+        tree->depthOrderCapacity = count;
+    }
+    tree->depthOrderCount = count;
+    
+    for (int i = count - 1; i >= 0; i--) {
+        nodes[i].subtreeSize = 1;
+        for (uint32_t c = 0; c < nodes[i].childCount; c++) {
+            nodes[i].subtreeSize += nodes[nodes[i].firstChild + c].subtreeSize;
+        }
+    }
+    
+    uint32_t next = 0;
+    for (int i = 0; i < count; i++) {
+        Tree3DBranchNode *node = &nodes[i];
+        if (node->parent == TREE3D_NO_PARENT) {
+            node->order = next;
+            next += node->subtreeSize;
+        }
+        
+        uint32_t childOrder = node->order + 1;
+        for (uint32_t c = 0; c < node->childCount; c++) {
+            nodes[node->firstChild + c].order = childOrder;
+            childOrder += nodes[node->firstChild + c].subtreeSize;
+        }
+        tree->depthOrder[node->order] = (uint32_t)i;
+    }
+}
+
+// Pool indices of a branch and all its descendants, depth first. Builds
+// depthOrder first if branches were added since.
+const uint32_t* Tree3DGetSubtree(Tree3D *tree, int row, int index, int *count) {
+    if (tree->depthOrderCount != (int)tree->memPool.branchPoolIndex) {
+        Tree3DBuildDepthOrder(tree);
+    }
+    
+    const Tree3DBranchNode *node = &tree->memPool.branches.nodes[Tree3DBranchIndex(tree, row, index)];
+    if (count) *count = (int)node->subtreeSize;
+    return tree->depthOrder + node->order;
+}
+
+// Immediate-mode scratch; allocated on the first immediate draw
+void Tree3DInitBatchData(Tree3D *tree) {
+    if (tree->batchData.positions) return;
+    
+    tree->batchData.capacity = BATCH_SIZE;
+    tree->batchData.positions = (Vector3*)Tree3DAlloc(tree, BATCH_SIZE * 2 * sizeof(Vector3));
+    tree->batchData.widths = (float*)Tree3DAlloc(tree, BATCH_SIZE * 2 * sizeof(float));
+    tree->batchData.colors = (Color*)Tree3DAlloc(tree, BATCH_SIZE * sizeof(Color));
+    
+    if (!tree->batchData.positions || !tree->batchData.widths || !tree->batchData.colors) {
+        fprintf(stderr, "Failed to allocate batch data\n");
+        exit(1);
+    }
+    
+    tree->batchData.count = 0;
+}
+
+void Tree3DInitInstanceData(Tree3DInstanceData *data) {
+    *data = (Tree3DInstanceData){0};
+}
+
+void Tree3DClearInstanceData(Tree3DInstanceData *data) {
+    data->branchCount = 0;
+    data->leafCount = 0;
+    data->impostorCount = 0;
+}
+
+void Tree3DFreeInstanceData(Tree3DInstanceData *data) {
+    if (data->branchTransforms) {
+        TREE3D_FREE(data->branchTransforms);
+        data->branchTransforms = NULL;
+    }
+    
+    if (data->leafTransforms) {
+        TREE3D_FREE(data->leafTransforms);
+        data->leafTransforms = NULL;
+    }
+    
+    if (data->impostors) {
+        TREE3D_FREE(data->impostors);
+        data->impostors = NULL;
+    }
+    
+    data->branchCount = data->branchCapacity = 0;
+    data->leafCount = data->leafCapacity = 0;
+    data->impostorCount = data->impostorCapacity = 0;
+}
+
+// Grow an instance array so it can hold at least `needed` transforms
+static Matrix* Tree3DReserveInstances(Matrix *transforms, int *capacity, int needed) {
+    if (needed <= *capacity) return transforms;
+    
+    int newCapacity = *capacity > 0 ? *capacity : 256;
+    while (newCapacity < needed) newCapacity *= 2;
+    
+    Matrix *grown = (Matrix*)TREE3D_REALLOC(transforms, newCapacity * sizeof(Matrix));
+    if (!grown) {
+        fprintf(stderr, "Failed to allocate instance data\n");
+        exit(1);
+    }
+    
+    *capacity = newCapacity;
+    return grown;
+}
+
+// Random Generation
+// PCG32 (XSH RR) on a per-tree state, so trees generate independently of
+// each other and of the C library rand().
+static uint32_t Tree3DNextRandom(Tree3D *tree) {
+    uint64_t old = tree->rngState;
+    tree->rngState = old * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+}
+
+static uint64_t Tree3DPositionSeed(float x, float y, float z) {
+    float position[3] = {x, y, z};
+    uint32_t bits[3];
+    memcpy(bits, position, sizeof(bits));
+    
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 3; i++) {
+        h = (h ^ bits[i]) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+// Restart the generator from Seed (or the position when Seed is 0)
+void Tree3DSeedRandom(Tree3D *tree) {
+    uint64_t seed = tree->Seed != 0 ? tree->Seed : Tree3DPositionSeed(tree->X, tree->Y, tree->Z);
+    tree->rngState = 0;
+    Tree3DNextRandom(tree);
+    tree->rngState += seed;
+    Tree3DNextRandom(tree);
+    tree->growKey = Tree3DNextRandom(tree) | (uint64_t)Tree3DNextRandom(tree) << 32;
+}
+
+// Random float 0-1
+float Tree3DRandom(Tree3D *tree) {
+    return (Tree3DNextRandom(tree) >> 8) * (1.0f / 16777215.0f);
+}
+
+// Random int in [0, n)
+int Tree3DRandomInt(Tree3D *tree, int n) {
+    if (n <= 0) return 0;
+    return (int)(((uint64_t)Tree3DNextRandom(tree) * (uint32_t)n) >> 32);
+}
+
+// Optimized color generation
+Color Tree3DGetColor(Tree3D *tree, unsigned char cs[6]) {
+    Color color;
+    color.r = cs[0] + Tree3DRandomInt(tree, cs[1] - cs[0] + 1);
+    color.g = cs[2] + Tree3DRandomInt(tree, cs[3] - cs[2] + 1);
+    color.b = cs[4] + Tree3DRandomInt(tree, cs[5] - cs[4] + 1);
+    color.a = 255;
+    return color;
+}
+
+// Optimized rotation calculation using lookup tables (angles in table steps)
+Vector3 Tree3DGetRotation(int degX, int degZ) {
+    int indexX = Tree3DWrapAngle(degX);
+    int indexZ = Tree3DWrapAngle(degZ);
+    
+    return (Vector3){
+        tree3dCosTable[indexZ] * tree3dSinTable[indexX],  // X component
+        tree3dCosTable[indexX],                           // Y component
+        tree3dSinTable[indexZ]                            // Z component
+    };
+}
+static Vector4 Tree3DNormalizePlane(float a, float b, float c, float d) {
+    float len = sqrtf(a * a + b * b + c * c);
+    if (len > 0.0f) {
+        a /= len; b /= len; c /= len; d /= len;
+    }
+    return (Vector4){a, b, c, d};
+}
+
+// Extract the culling planes from the camera's view-projection matrix
+// (Gribb/Hartmann). The projection mirrors the one BeginMode3D sets up,
+// with the far plane pulled in to farDistance.
+Tree3DFrustum Tree3DGetCameraFrustum(Camera3D camera, float aspect, float farDistance) {
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix proj;
+    
+    if (camera.projection == CAMERA_ORTHOGRAPHIC) {
+        double top = camera.fovy / 2.0;
+        double right = top * aspect;
+        proj = MatrixOrtho(-right, right, -top, top, TREE3D_CULL_NEAR, farDistance);
+    } else {
+        proj = MatrixPerspective(camera.fovy * DEG2RAD, aspect, TREE3D_CULL_NEAR, farDistance);
+    }
+    
+    // Rows of the combined clip matrix: row i = (m[i], m[i + 4], m[i + 8], m[i + 12])
+    Matrix m = MatrixMultiply(view, proj);
+    Tree3DFrustum frustum;
+    frustum.planes[0] = Tree3DNormalizePlane(m.m3 + m.m0, m.m7 + m.m4, m.m11 + m.m8,  m.m15 + m.m12);
+    frustum.planes[1] = Tree3DNormalizePlane(m.m3 - m.m0, m.m7 - m.m4, m.m11 - m.m8,  m.m15 - m.m12);
+    frustum.planes[2] = Tree3DNormalizePlane(m.m3 + m.m1, m.m7 + m.m5, m.m11 + m.m9,  m.m15 + m.m13);
+    frustum.planes[3] = Tree3DNormalizePlane(m.m3 - m.m1, m.m7 - m.m5, m.m11 - m.m9,  m.m15 - m.m13);
+    frustum.planes[4] = Tree3DNormalizePlane(m.m3 + m.m2, m.m7 + m.m6, m.m11 + m.m10, m.m15 + m.m14);
+    frustum.planes[5] = Tree3DNormalizePlane(m.m3 - m.m2, m.m7 - m.m6, m.m11 - m.m10, m.m15 - m.m14);
+    return frustum;
+}
+
+// Conservative test: false only when the box is fully behind one plane
+bool Tree3DFrustumContainsBox(const Tree3DFrustum *frustum, BoundingBox box) {
+    for (int i = 0; i < 6; i++) {
+        Vector4 p = frustum->planes[i];
+        
+        // Corner furthest along the plane normal
+        float x = (p.x >= 0.0f) ? box.max.x : box.min.x;
+        float y = (p.y >= 0.0f) ? box.max.y : box.min.y;
+        float z = (p.z >= 0.0f) ? box.max.z : box.min.z;
+        
+        if (p.x * x + p.y * y + p.z * z + p.w < 0.0f) return false;
+    }
+    return true;
+}
+
+bool Tree3DFrustumContainsSphere(const Tree3DFrustum *frustum, Vector3 center, float radius) {
+    for (int i = 0; i < 6; i++) {
+        Vector4 p = frustum->planes[i];
+        if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius) return false;
+    }
+    return true;
+}
+
+float Tree3DGetScreenAspect(void) {
+    int height = GetScreenHeight();
+    return (height > 0) ? (float)GetScreenWidth() / (float)height : 1.0f;
+}
+
+// Whole-tree frustum test against the tree's bounding box
+bool Tree3DIsVisible(const Tree3D *tree, Camera3D camera) {
+    Tree3DFrustum frustum = Tree3DGetCameraFrustum(camera, Tree3DGetScreenAspect(), tree->cullDistance);
+    return Tree3DFrustumContainsBox(&frustum, tree->bounds);
+}
+
+// SIMD Lanes
+// Thin wrappers so each branch kernel is written once for AVX, SSE2, NEON
+// and plain floats. Comparisons return lane masks for Select and Bits.
+#if defined(TREE3D_SIMD_AVX)
+#define TREE3D_LANES 8
+typedef __m256 Tree3DLane;
+static inline Tree3DLane Tree3DLaneLoad(const float *p) { return _mm256_loadu_ps(p); }
+static inline void Tree3DLaneStore(float *p, Tree3DLane a) { _mm256_storeu_ps(p, a); }
+static inline Tree3DLane Tree3DLaneSet(float v) { return _mm256_set1_ps(v); }
+static inline Tree3DLane Tree3DLaneAdd(Tree3DLane a, Tree3DLane b) { return _mm256_add_ps(a, b); }
+static inline Tree3DLane Tree3DLaneSub(Tree3DLane a, Tree3DLane b) { return _mm256_sub_ps(a, b); }
+static inline Tree3DLane Tree3DLaneMul(Tree3DLane a, Tree3DLane b) { return _mm256_mul_ps(a, b); }
+static inline Tree3DLane Tree3DLaneDiv(Tree3DLane a, Tree3DLane b) { return _mm256_div_ps(a, b); }
+static inline Tree3DLane Tree3DLaneSqrt(Tree3DLane a) { return _mm256_sqrt_ps(a); }
+static inline Tree3DLane Tree3DLaneAbs(Tree3DLane a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline Tree3DLane Tree3DLaneLess(Tree3DLane a, Tree3DLane b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline Tree3DLane Tree3DLaneOr(Tree3DLane a, Tree3DLane b) { return _mm256_or_ps(a, b); }
+static inline Tree3DLane Tree3DLaneSelect(Tree3DLane mask, Tree3DLane a, Tree3DLane b) { return _mm256_blendv_ps(b, a, mask); }
+static inline int Tree3DLaneBits(Tree3DLane mask) { return _mm256_movemask_ps(mask); }
+#elif defined(TREE3D_SIMD_SSE)
+#define TREE3D_LANES 4
+typedef __m128 Tree3DLane;
+static inline Tree3DLane Tree3DLaneLoad(const float *p) { return _mm_loadu_ps(p); }
+static inline void Tree3DLaneStore(float *p, Tree3DLane a) { _mm_storeu_ps(p, a); }
+static inline Tree3DLane Tree3DLaneSet(float v) { return _mm_set1_ps(v); }
+static inline Tree3DLane Tree3DLaneAdd(Tree3DLane a, Tree3DLane b) { return _mm_add_ps(a, b); }
+static inline Tree3DLane Tree3DLaneSub(Tree3DLane a, Tree3DLane b) { return _mm_sub_ps(a, b); }
+static inline Tree3DLane Tree3DLaneMul(Tree3DLane a, Tree3DLane b) { return _mm_mul_ps(a, b); }
+static inline Tree3DLane Tree3DLaneDiv(Tree3DLane a, Tree3DLane b) { return _mm_div_ps(a, b); }
+static inline Tree3DLane Tree3DLaneSqrt(Tree3DLane a) { return _mm_sqrt_ps(a); }
+static inline Tree3DLane Tree3DLaneAbs(Tree3DLane a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline Tree3DLane Tree3DLaneLess(Tree3DLane a, Tree3DLane b) { return _mm_cmplt_ps(a, b); }
+static inline Tree3DLane Tree3DLaneOr(Tree3DLane a, Tree3DLane b) { return _mm_or_ps(a, b); }
+static inline Tree3DLane Tree3DLaneSelect(Tree3DLane mask, Tree3DLane a, Tree3DLane b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+static inline int Tree3DLaneBits(Tree3DLane mask) { return _mm_movemask_ps(mask); }
+#elif defined(TREE3D_SIMD_NEON)
+#define TREE3D_LANES 4
+typedef float32x4_t Tree3DLane;
+static inline Tree3DLane Tree3DLaneLoad(const float *p) { return vld1q_f32(p); }
+static inline void Tree3DLaneStore(float *p, Tree3DLane a) { vst1q_f32(p, a); }
+static inline Tree3DLane Tree3DLaneSet(float v) { return vdupq_n_f32(v); }
+static inline Tree3DLane Tree3DLaneAdd(Tree3DLane a, Tree3DLane b) { return vaddq_f32(a, b); }
+static inline Tree3DLane Tree3DLaneSub(Tree3DLane a, Tree3DLane b) { return vsubq_f32(a, b); }
+static inline Tree3DLane Tree3DLaneMul(Tree3DLane a, Tree3DLane b) { return vmulq_f32(a, b); }
+static inline Tree3DLane Tree3DLaneDiv(Tree3DLane a, Tree3DLane b) { return vdivq_f32(a, b); }
+static inline Tree3DLane Tree3DLaneSqrt(Tree3DLane a) { return vsqrtq_f32(a); }
+static inline Tree3DLane Tree3DLaneAbs(Tree3DLane a) { return vabsq_f32(a); }
+static inline Tree3DLane Tree3DLaneLess(Tree3DLane a, Tree3DLane b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+static inline Tree3DLane Tree3DLaneOr(Tree3DLane a, Tree3DLane b) {
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+static inline Tree3DLane Tree3DLaneSelect(Tree3DLane mask, Tree3DLane a, Tree3DLane b) {
+    return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+}
+static inline int Tree3DLaneBits(Tree3DLane mask) {
+    uint32x4_t sign = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+    return (int)(vgetq_lane_u32(sign, 0) | vgetq_lane_u32(sign, 1) << 1 |
+                 vgetq_lane_u32(sign, 2) << 2 | vgetq_lane_u32(sign, 3) << 3);
+}
+#else
+#define TREE3D_LANES 1
+typedef float Tree3DLane;       // Masks are 1.0f or 0.0f
+static inline Tree3DLane Tree3DLaneLoad(const float *p) { return *p; }
+static inline void Tree3DLaneStore(float *p, Tree3DLane a) { *p = a; }
+static inline Tree3DLane Tree3DLaneSet(float v) { return v; }
+static inline Tree3DLane Tree3DLaneAdd(Tree3DLane a, Tree3DLane b) { return a + b; }
+static inline Tree3DLane Tree3DLaneSub(Tree3DLane a, Tree3DLane b) { return a - b; }
+static inline Tree3DLane Tree3DLaneMul(Tree3DLane a, Tree3DLane b) { return a * b; }
+static inline Tree3DLane Tree3DLaneDiv(Tree3DLane a, Tree3DLane b) { return a / b; }
+static inline Tree3DLane Tree3DLaneSqrt(Tree3DLane a) { return sqrtf(a); }
+static inline Tree3DLane Tree3DLaneAbs(Tree3DLane a) { return fabsf(a); }
+static inline Tree3DLane Tree3DLaneLess(Tree3DLane a, Tree3DLane b) { return a < b ? 1.0f : 0.0f; }
+static inline Tree3DLane Tree3DLaneOr(Tree3DLane a, Tree3DLane b) { return (a != 0.0f || b != 0.0f) ? 1.0f : 0.0f; }
+static inline Tree3DLane Tree3DLaneSelect(Tree3DLane mask, Tree3DLane a, Tree3DLane b) { return mask != 0.0f ? a : b; }
+static inline int Tree3DLaneBits(Tree3DLane mask) { return mask != 0.0f; }
+#endif
+
+// Lanes of a stream starting at src. A short tail is copied to scratch and
+// padded with its last element so every lane holds a real branch.
+static const float* Tree3DLaneSource(const float *src, int n, float *scratch) {
+    if (n == TREE3D_LANES) return src;
+    for (int k = 0; k < TREE3D_LANES; k++) scratch[k] = src[k < n ? k : n - 1];
+    return scratch;
+}
+
+// Branches per kernel call when culling a long contained range
+#define TREE3D_CULL_CHUNK 256
+
+// Frustum test of branches [first, first + count) as drawn with `grow` of
+// their length still to grow in, using each segment's bounding sphere
+// padded by its width. Sets visible[i] for branches that pass and returns
+// how many did; contained skips the planes.
+static int Tree3DCullBranches(const Tree3DFrustum *frustum, const Tree3DBranchStreams *s,
+                              size_t first, int count, float grow, bool contained, unsigned char *visible) {
+    int total = 0;
+    
+    if (contained) {
+        memset(visible, 1, count);
+        return count;
+    }
+    
+    float pad[7][TREE3D_LANES];
+    Tree3DLane g = Tree3DLaneSet(grow);
+    Tree3DLane half = Tree3DLaneSet(0.5f);
+    Tree3DLane zero = Tree3DLaneSet(0.0f);
+    
+    for (int i = 0; i < count; i += TREE3D_LANES) {
+        int n = count - i < TREE3D_LANES ? count - i : TREE3D_LANES;
+        size_t b = first + i;
+        Tree3DLane x1 = Tree3DLaneLoad(Tree3DLaneSource(s->x1 + b, n, pad[0]));
+        Tree3DLane y1 = Tree3DLaneLoad(Tree3DLaneSource(s->y1 + b, n, pad[1]));
+        Tree3DLane z1 = Tree3DLaneLoad(Tree3DLaneSource(s->z1 + b, n, pad[2]));
+        Tree3DLane x2 = Tree3DLaneLoad(Tree3DLaneSource(s->x2 + b, n, pad[3]));
+        Tree3DLane y2 = Tree3DLaneLoad(Tree3DLaneSource(s->y2 + b, n, pad[4]));
+        Tree3DLane z2 = Tree3DLaneLoad(Tree3DLaneSource(s->z2 + b, n, pad[5]));
+        Tree3DLane width = Tree3DLaneLoad(Tree3DLaneSource(s->width + b, n, pad[6]));
+        
+        // Drawn tip, pulled back towards the base while growing in
+        x2 = Tree3DLaneAdd(x2, Tree3DLaneMul(Tree3DLaneSub(x1, x2), g));
+        y2 = Tree3DLaneAdd(y2, Tree3DLaneMul(Tree3DLaneSub(y1, y2), g));
+        z2 = Tree3DLaneAdd(z2, Tree3DLaneMul(Tree3DLaneSub(z1, z2), g));
+        
+        Tree3DLane cx = Tree3DLaneMul(Tree3DLaneAdd(x1, x2), half);
+        Tree3DLane cy = Tree3DLaneMul(Tree3DLaneAdd(y1, y2), half);
+        Tree3DLane cz = Tree3DLaneMul(Tree3DLaneAdd(z1, z2), half);
+        Tree3DLane dx = Tree3DLaneSub(x2, x1);
+        Tree3DLane dy = Tree3DLaneSub(y2, y1);
+        Tree3DLane dz = Tree3DLaneSub(z2, z1);
+        Tree3DLane length = Tree3DLaneSqrt(Tree3DLaneAdd(Tree3DLaneAdd(Tree3DLaneMul(dx, dx), Tree3DLaneMul(dy, dy)),
+                                                         Tree3DLaneMul(dz, dz)));
+        Tree3DLane negRadius = Tree3DLaneSub(zero, Tree3DLaneAdd(Tree3DLaneMul(length, half), width));
+        
+        Tree3DLane outside = zero;
+        for (int p = 0; p < 6; p++) {
+            Vector4 plane = frustum->planes[p];
+            Tree3DLane d = Tree3DLaneAdd(Tree3DLaneAdd(Tree3DLaneAdd(
+                Tree3DLaneMul(Tree3DLaneSet(plane.x), cx),
+                Tree3DLaneMul(Tree3DLaneSet(plane.y), cy)),
+                Tree3DLaneMul(Tree3DLaneSet(plane.z), cz)),
+                Tree3DLaneSet(plane.w));
+            outside = Tree3DLaneOr(outside, Tree3DLaneLess(d, negRadius));
+        }
+        
+        int culled = Tree3DLaneBits(outside);
+        for (int k = 0; k < n; k++) {
+            visible[i + k] = !(culled >> k & 1);
+            total += visible[i + k];
+        }
+    }
+    return total;
+}
+
+enum { TREE3D_OUTSIDE = 0, TREE3D_INTERSECTS, TREE3D_INSIDE };
+
+static int Tree3DFrustumClassifyBox(const Tree3DFrustum *frustum, BoundingBox box) {
+    int result = TREE3D_INSIDE;
+    for (int i = 0; i < 6; i++) {
+        Vector4 p = frustum->planes[i];
+        float px = (p.x >= 0.0f) ? box.max.x : box.min.x;
+        float py = (p.y >= 0.0f) ? box.max.y : box.min.y;
+        float pz = (p.z >= 0.0f) ? box.max.z : box.min.z;
+        if (p.x * px + p.y * py + p.z * pz + p.w < 0.0f) return TREE3D_OUTSIDE;
+        
+        float nx = (p.x >= 0.0f) ? box.min.x : box.max.x;
+        float ny = (p.y >= 0.0f) ? box.min.y : box.max.y;
+        float nz = (p.z >= 0.0f) ? box.min.z : box.max.z;
+        if (p.x * nx + p.y * ny + p.z * nz + p.w < 0.0f) result = TREE3D_INTERSECTS;
+    }
+    return result;
+}
+
+// BVH Construction
+static BoundingBox Tree3DEmptyBox(void) {
+    return (BoundingBox){{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+}
+
+static BoundingBox Tree3DMergeBox(BoundingBox a, BoundingBox b) {
+    return (BoundingBox){Vector3Min(a.min, b.min), Vector3Max(a.max, b.max)};
+}
+
+static bool Tree3DBoxesOverlap(BoundingBox a, BoundingBox b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static BoundingBox Tree3DBranchBox(const Tree3D *tree, size_t i) {
+    const Tree3DBranchStreams *s = &tree->memPool.branches;
+    Vector3 v1 = Tree3DBranchStart(s, i);
+    Vector3 v2 = Tree3DBranchTip(s, i);
+    Vector3 pad = {s->width[i], s->width[i], s->width[i]};
+    return (BoundingBox){
+        Vector3Subtract(Vector3Min(v1, v2), pad),
+        Vector3Add(Vector3Max(v1, v2), pad)
+    };
+}
+
+static BoundingBox Tree3DLeafBox(const Tree3D *tree, const Tree3DLeaf *l) {
+    float r = l->Radius * tree->Scale;
+    Vector3 pad = {r, r, r};
+    return (BoundingBox){
+        Vector3Subtract(Vector3Min(l->V1, l->V2), pad),
+        Vector3Add(Vector3Max(l->V1, l->V2), pad)
+    };
+}
+
+static int Tree3DAllocBVHNode(Tree3D *tree) {
+    Tree3DBVH *bvh = &tree->bvh;
+    if (bvh->nodeCount >= bvh->nodeCapacity) {
+        int newCapacity = bvh->nodeCapacity > 0 ? bvh->nodeCapacity * 2 : 64;
+        Tree3DBVHNode *nodes = (Tree3DBVHNode*)Tree3DRealloc(tree, bvh->nodes,
+                                                            bvh->nodeCapacity * sizeof(Tree3DBVHNode),
+                                                            newCapacity * sizeof(Tree3DBVHNode));
+        if (!nodes) {
+            fprintf(stderr, "Failed to allocate BVH nodes\n");
+            exit(1);
+        }
+        bvh->nodes = nodes;
+        bvh->nodeCapacity = newCapacity;
+    }
+    return bvh->nodeCount++;
+}
+
+static int Tree3DBuildBVHRange(Tree3D *tree, int row, int first, int count, bool leaves) {
+    int index = Tree3DAllocBVHNode(tree);
+    Tree3DBVHNode node = {Tree3DEmptyBox(), first, count, -1, -1};
+    
+    if (count <= TREE3D_BVH_LEAF_SIZE) {
+        for (int i = first; i < first + count; i++) {
+            if (leaves) {
+                node.bounds = Tree3DMergeBox(node.bounds, Tree3DLeafBox(tree, &tree->memPool.leafPool[i]));
+            } else {
+                node.bounds = Tree3DMergeBox(node.bounds, Tree3DBranchBox(tree, Tree3DBranchIndex(tree, row, i)));
+            }
+        }
+    } else {
+        int half = count / 2;
+        node.left = Tree3DBuildBVHRange(tree, row, first, half, leaves);
+        node.right = Tree3DBuildBVHRange(tree, row, first + half, count - half, leaves);
+        node.bounds = Tree3DMergeBox(tree->bvh.nodes[node.left].bounds, tree->bvh.nodes[node.right].bounds);
+    }
+    
+    // Written last: building the children may have moved the node array
+    tree->bvh.nodes[index] = node;
+    return index;
+}
+
+void Tree3DResetBVH(Tree3D *tree) {
+    tree->bvh.nodeCount = 0;
+    tree->bvh.builtRows = 0;
+}
+
+// Build the hierarchy for a freshly grown row: its branches plus the leaf
+// pool range [firstLeaf, firstLeaf + leafCount) that sits on it
+void Tree3DBuildRowBVH(Tree3D *tree, int row, int firstLeaf, int leafCount) {
+    Tree3DBVH *bvh = &tree->bvh;
+    if (row < 0 || row >= MAX_ROWS) return;
+    
+    bvh->rowBranchRoot[row] = (tree->BranchCount[row] > 0)
+        ? Tree3DBuildBVHRange(tree, row, 0, tree->BranchCount[row], false) : -1;
+    bvh->rowLeafRoot[row] = (leafCount > 0)
+        ? Tree3DBuildBVHRange(tree, row, firstLeaf, leafCount, true) : -1;
+    
+    BoundingBox bounds = Tree3DEmptyBox();
+    if (bvh->rowBranchRoot[row] >= 0) bounds = Tree3DMergeBox(bounds, bvh->nodes[bvh->rowBranchRoot[row]].bounds);
+    if (bvh->rowLeafRoot[row] >= 0) bounds = Tree3DMergeBox(bounds, bvh->nodes[bvh->rowLeafRoot[row]].bounds);
+    bvh->rowBounds[row] = bounds;
+    
+    if (row + 1 > bvh->builtRows) bvh->builtRows = row + 1;
+    tree->needsBoundsUpdate = true;
+}
+
+void Tree3DFreeBVH(Tree3D *tree) {
+    Tree3DBVH *bvh = &tree->bvh;
+    if (bvh->nodes) {
+        Tree3DDealloc(tree, bvh->nodes);
+        bvh->nodes = NULL;
+    }
+    bvh->nodeCount = bvh->nodeCapacity = 0;
+    bvh->builtRows = 0;
+}
+
+// BVH Traversal
+typedef void (*Tree3DItemVisitor)(Tree3D *tree, int row, int first, int count, bool contained, void *ctx);
+
+// Visit the item ranges under a node that may be in the frustum. Ranges
+// under a node fully inside the frustum are passed with contained = true
+// and need no test.
+static void Tree3DCullVisit(Tree3D *tree, const Tree3DFrustum *frustum, int node, int row,
+                            Tree3DItemVisitor visit, void *ctx) {
+    if (node < 0) return;
+    
+    const Tree3DBVHNode *n = &tree->bvh.nodes[node];
+    int state = Tree3DFrustumClassifyBox(frustum, n->bounds);
+    if (state == TREE3D_OUTSIDE) return;
+    
+    if (state == TREE3D_INSIDE || n->left < 0) {
+        visit(tree, row, n->first, n->count, state == TREE3D_INSIDE, ctx);
+        return;
+    }
+    
+    Tree3DCullVisit(tree, frustum, n->left, row, visit, ctx);
+    Tree3DCullVisit(tree, frustum, n->right, row, visit, ctx);
+}
+
+// Closest distance between point p and segment ab
+static float Tree3DSegmentDistance(Vector3 p, Vector3 a, Vector3 b) {
+    Vector3 ab = Vector3Subtract(b, a);
+    float len = Vector3DotProduct(ab, ab);
+    float t = (len > 0.0f) ? Vector3DotProduct(Vector3Subtract(p, a), ab) / len : 0.0f;
+    t = Clamp(t, 0.0f, 1.0f);
+    return Vector3Distance(p, Vector3Add(a, Vector3Scale(ab, t)));
+}
+
+static bool Tree3DSphereOverlapsBox(Vector3 c, float r, BoundingBox box) {
+    Vector3 q = {Clamp(c.x, box.min.x, box.max.x), Clamp(c.y, box.min.y, box.max.y), Clamp(c.z, box.min.z, box.max.z)};
+    return Vector3DistanceSqr(c, q) <= r * r;
+}
+
+// Slab test; returns the entry distance in *tNear
+static bool Tree3DRayBox(Ray ray, BoundingBox box, float maxDistance, float *tNear) {
+    float tmin = 0.0f, tmax = maxDistance;
+    float o[3] = {ray.position.x, ray.position.y, ray.position.z};
+    float d[3] = {ray.direction.x, ray.direction.y, ray.direction.z};
+    float lo[3] = {box.min.x, box.min.y, box.min.z};
+    float hi[3] = {box.max.x, box.max.y, box.max.z};
+    
+    for (int i = 0; i < 3; i++) {
+        if (fabsf(d[i]) < 1e-8f) {
+            if (o[i] < lo[i] || o[i] > hi[i]) return false;
+            continue;
+        }
+        float inv = 1.0f / d[i];
+        float t0 = (lo[i] - o[i]) * inv;
+        float t1 = (hi[i] - o[i]) * inv;
+        if (t0 > t1) { float t = t0; t0 = t1; t1 = t; }
+        if (t0 > tmin) tmin = t0;
+        if (t1 < tmax) tmax = t1;
+        if (tmin > tmax) return false;
+    }
+    
+    *tNear = tmin;
+    return true;
+}
+
+// Ray against a sphere, direction normalized; -1 on miss
+static float Tree3DRaySphere(Ray ray, Vector3 center, float radius) {
+    Vector3 oc = Vector3Subtract(ray.position, center);
+    float b = Vector3DotProduct(oc, ray.direction);
+    float c = Vector3DotProduct(oc, oc) - radius * radius;
+    float h = b * b - c;
+    if (h < 0.0f) return -1.0f;
+    return -b - sqrtf(h);
+}
+
+// Ray against the capsule a-b of radius r, direction normalized; -1 on miss
+static float Tree3DRayCapsule(Ray ray, Vector3 a, Vector3 b, float r) {
+    Vector3 ba = Vector3Subtract(b, a);
+    Vector3 oa = Vector3Subtract(ray.position, a);
+    float baba = Vector3DotProduct(ba, ba);
+    float bard = Vector3DotProduct(ba, ray.direction);
+    float baoa = Vector3DotProduct(ba, oa);
+    float rdoa = Vector3DotProduct(ray.direction, oa);
+    float oaoa = Vector3DotProduct(oa, oa);
+    float qa = baba - bard * bard;
+    
+    if (qa > 1e-8f) {
+        float qb = baba * rdoa - baoa * bard;
+        float qc = baba * oaoa - baoa * baoa - r * r * baba;
+        float h = qb * qb - qa * qc;
+        if (h < 0.0f) return -1.0f;
+        
+        float t = (-qb - sqrtf(h)) / qa;
+        float y = baoa + t * bard;
+        if (y > 0.0f && y < baba) return t;
+        return Tree3DRaySphere(ray, (y <= 0.0f) ? a : b, r);
+    }
+    
+    // Ray parallel to the axis: only the end caps can be hit first
+    float ta = Tree3DRaySphere(ray, a, r);
+    float tb = Tree3DRaySphere(ray, b, r);
+    if (ta < 0.0f) return tb;
+    if (tb < 0.0f) return ta;
+    return fminf(ta, tb);
+}
+
+typedef struct {
+    BoundingBox box;
+    Vector3 center;
+    float radius;
+    bool sphere;
+    Tree3DQueryHit *hits;
+    int maxHits;
+    int count;
+} Tree3DOverlapQuery;
+
+static void Tree3DOverlapNode(const Tree3D *tree, int node, int row, bool leaves, Tree3DOverlapQuery *q) {
+    if (node < 0 || q->count >= q->maxHits) return;
+    
+    const Tree3DBVHNode *n = &tree->bvh.nodes[node];
+    if (!Tree3DBoxesOverlap(n->bounds, q->box)) return;
+    if (q->sphere && !Tree3DSphereOverlapsBox(q->center, q->radius, n->bounds)) return;
+    
+    if (n->left >= 0) {
+        Tree3DOverlapNode(tree, n->left, row, leaves, q);
+        Tree3DOverlapNode(tree, n->right, row, leaves, q);
+        return;
+    }
+    
+    for (int i = n->first; i < n->first + n->count && q->count < q->maxHits; i++) {
+        bool hit;
+        if (leaves) {
+            const Tree3DLeaf *l = &tree->memPool.leafPool[i];
+            if (!l->isActive) continue;
+            float r = l->Radius * tree->Scale;
+            hit = q->sphere
+                ? (Vector3Distance(q->center, l->V1) <= q->radius + r ||
+                   Vector3Distance(q->center, l->V2) <= q->radius + r)
+                : Tree3DBoxesOverlap(Tree3DLeafBox(tree, l), q->box);
+        } else {
+            const Tree3DBranchStreams *s = &tree->memPool.branches;
+            size_t b = Tree3DBranchIndex(tree, row, i);
+            hit = q->sphere
+                ? Tree3DSegmentDistance(q->center, Tree3DBranchStart(s, b), Tree3DBranchTip(s, b)) <= q->radius + s->width[b]
+                : Tree3DBoxesOverlap(Tree3DBranchBox(tree, b), q->box);
+        }
+        
+        if (hit) {
+            q->hits[q->count++] = (Tree3DQueryHit){row, i, leaves};
+        }
+    }
+}
+
+static int Tree3DOverlapQueryRun(const Tree3D *tree, Tree3DOverlapQuery *q) {
+    for (int row = 0; row < tree->bvh.builtRows && q->count < q->maxHits; row++) {
+        if (!Tree3DBoxesOverlap(tree->bvh.rowBounds[row], q->box)) continue;
+        Tree3DOverlapNode(tree, tree->bvh.rowBranchRoot[row], row, false, q);
+        Tree3DOverlapNode(tree, tree->bvh.rowLeafRoot[row], row, true, q);
+    }
+    return q->count;
+}
+
+// Branches whose padded bounds and leaves whose spheres' bounds overlap box.
+// Returns the number of hits written.
+int Tree3DQueryBox(const Tree3D *tree, BoundingBox box, Tree3DQueryHit *hits, int maxHits) {
+    Tree3DOverlapQuery q = {box, {0.0f, 0.0f, 0.0f}, 0.0f, false, hits, maxHits, 0};
+    return Tree3DOverlapQueryRun(tree, &q);
+}
+
+// Branches (as capsules) and leaf spheres touching the sphere
+int Tree3DQuerySphere(const Tree3D *tree, Vector3 center, float radius, Tree3DQueryHit *hits, int maxHits) {
+    Vector3 pad = {radius, radius, radius};
+    BoundingBox box = {Vector3Subtract(center, pad), Vector3Add(center, pad)};
+    Tree3DOverlapQuery q = {box, center, radius, true, hits, maxHits, 0};
+    return Tree3DOverlapQueryRun(tree, &q);
+}
+
+static void Tree3DRaycastNode(const Tree3D *tree, Ray ray, int node, int row, bool leaves, Tree3DRayHit *best) {
+    if (node < 0) return;
+    
+    const Tree3DBVHNode *n = &tree->bvh.nodes[node];
+    float tNear;
+    if (!Tree3DRayBox(ray, n->bounds, best->distance, &tNear)) return;
+    
+    if (n->left >= 0) {
+        Tree3DRaycastNode(tree, ray, n->left, row, leaves, best);
+        Tree3DRaycastNode(tree, ray, n->right, row, leaves, best);
+        return;
+    }
+    
+    for (int i = n->first; i < n->first + n->count; i++) {
+        float t;
+        if (leaves) {
+            const Tree3DLeaf *l = &tree->memPool.leafPool[i];
+            if (!l->isActive) continue;
+            float r = l->Radius * tree->Scale;
+            float t1 = Tree3DRaySphere(ray, l->V1, r);
+            float t2 = Tree3DRaySphere(ray, l->V2, r);
+            t = (t1 >= 0.0f && (t2 < 0.0f || t1 < t2)) ? t1 : t2;
+        } else {
+            const Tree3DBranchStreams *s = &tree->memPool.branches;
+            size_t b = Tree3DBranchIndex(tree, row, i);
+            t = Tree3DRayCapsule(ray, Tree3DBranchStart(s, b), Tree3DBranchTip(s, b), s->width[b]);
+        }
+        
+        if (t >= 0.0f && t < best->distance) {
+            best->distance = t;
+            best->item = (Tree3DQueryHit){row, i, leaves};
+        }
+    }
+}
+
+// Nearest branch or leaf hit by the ray within maxDistance
+bool Tree3DRaycast(const Tree3D *tree, Ray ray, float maxDistance, Tree3DRayHit *hit) {
+    ray.direction = Vector3Normalize(ray.direction);
+    Tree3DRayHit best = {{-1, -1, false}, maxDistance, {0.0f, 0.0f, 0.0f}};
+    
+    for (int row = 0; row < tree->bvh.builtRows; row++) {
+        float tNear;
+        if (!Tree3DRayBox(ray, tree->bvh.rowBounds[row], best.distance, &tNear)) continue;
+        Tree3DRaycastNode(tree, ray, tree->bvh.rowBranchRoot[row], row, false, &best);
+        Tree3DRaycastNode(tree, ray, tree->bvh.rowLeafRoot[row], row, true, &best);
+    }
+    
+    if (best.item.index < 0) return false;
+    
+    best.point = Vector3Add(ray.position, Vector3Scale(ray.direction, best.distance));
+    if (hit) *hit = best;
+    return true;
+}
+
+// Shared instancing resources, created once per GL context
+static struct {
+    bool ready;
+    bool failed;        // The instancing shader did not build; draw immediately
+    Mesh branchMesh;
+    Mesh leafMesh;
+    Material material;
+    Material bakedMaterial;
+} tree3dRenderer = {0};
+
+// The color is packed into the bottom row of the instance matrix and the row is
+// restored to (0, 0, 0, 1) before transforming the vertex
+static const char *tree3dInstanceVS =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in mat4 instanceTransform;\n"
+    "uniform mat4 mvp;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    mat4 model = instanceTransform;\n"
+    "    fragColor = vec4(model[0][3], model[1][3], model[2][3], 1.0);\n"
+    "    model[0][3] = 0.0; model[1][3] = 0.0; model[2][3] = 0.0;\n"
+    "    gl_Position = mvp*model*vec4(vertexPosition, 1.0);\n"
+    "}\n";
+
+static const char *tree3dInstanceFS =
+    "#version 330\n"
+    "in vec4 fragColor;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    finalColor = fragColor*colDiffuse;\n"
+    "}\n";
+
+static void Tree3DEmitVertex(float *vertices, unsigned char *colors, int index, Vector3 v, Color color) {
+    vertices[index * 3] = v.x;
+    vertices[index * 3 + 1] = v.y;
+    vertices[index * 3 + 2] = v.z;
+    if (colors) {
+        colors[index * 4] = color.r;
+        colors[index * 4 + 1] = color.g;
+        colors[index * 4 + 2] = color.b;
+        colors[index * 4 + 3] = color.a;
+    }
+}
+
+// Two unit vectors perpendicular to dir and to each other
+static void Tree3DGetBasis(Vector3 dir, Vector3 *u, Vector3 *w) {
+    Vector3 ref = (fabsf(dir.y) < 0.99f) ? (Vector3){0.0f, 1.0f, 0.0f} : (Vector3){1.0f, 0.0f, 0.0f};
+    *u = Vector3Normalize(Vector3CrossProduct(dir, ref));
+    *w = Vector3CrossProduct(dir, *u);
+}
+
+// Number of vertices written by Tree3DEmitTube / Tree3DEmitSphere
+#define TREE3D_TUBE_VERTICES(slices) ((slices) * 9)
+#define TREE3D_SPHERE_VERTICES(rings, slices) ((rings) * (slices) * 6)
+
+// Non-indexed tapered tube with a top cap; returns the number of vertices written
+static int Tree3DEmitTube(float *vertices, unsigned char *colors, int first,
+                          Vector3 start, Vector3 end, float startRadius, float endRadius,
+                          int slices, Color color) {
+    Vector3 dir = Vector3Normalize(Vector3Subtract(end, start));
+    Vector3 u, w;
+    Tree3DGetBasis(dir, &u, &w);
+    
+    int n = first;
+    for (int i = 0; i < slices; i++) {
+        float a0 = (2.0f * PI * i) / slices;
+        float a1 = (2.0f * PI * (i + 1)) / slices;
+        Vector3 r0 = Vector3Add(Vector3Scale(u, cosf(a0)), Vector3Scale(w, sinf(a0)));
+        Vector3 r1 = Vector3Add(Vector3Scale(u, cosf(a1)), Vector3Scale(w, sinf(a1)));
+        
+        Vector3 b0 = Vector3Add(start, Vector3Scale(r0, startRadius));
+        Vector3 b1 = Vector3Add(start, Vector3Scale(r1, startRadius));
+        Vector3 t0 = Vector3Add(end, Vector3Scale(r0, endRadius));
+        Vector3 t1 = Vector3Add(end, Vector3Scale(r1, endRadius));
+        
+        Tree3DEmitVertex(vertices, colors, n++, b0, color);
+        Tree3DEmitVertex(vertices, colors, n++, b1, color);
+        Tree3DEmitVertex(vertices, colors, n++, t1, color);
+        
+        Tree3DEmitVertex(vertices, colors, n++, b0, color);
+        Tree3DEmitVertex(vertices, colors, n++, t1, color);
+        Tree3DEmitVertex(vertices, colors, n++, t0, color);
+        
+        Tree3DEmitVertex(vertices, colors, n++, end, color);
+        Tree3DEmitVertex(vertices, colors, n++, t0, color);
+        Tree3DEmitVertex(vertices, colors, n++, t1, color);
+    }
+    
+    return n - first;
+}
+
+// Non-indexed UV sphere; returns the number of vertices written
+static int Tree3DEmitSphere(float *vertices, unsigned char *colors, int first,
+                            Vector3 center, float radius, int rings, int slices, Color color) {
+    int n = first;
+    for (int i = 0; i < rings; i++) {
+        float p0 = PI * i / rings - PI / 2.0f;
+        float p1 = PI * (i + 1) / rings - PI / 2.0f;
+        for (int j = 0; j < slices; j++) {
+            float a0 = (2.0f * PI * j) / slices;
+            float a1 = (2.0f * PI * (j + 1)) / slices;
+            Vector3 v00 = {cosf(p0) * cosf(a0), sinf(p0), cosf(p0) * sinf(a0)};
+            Vector3 v01 = {cosf(p0) * cosf(a1), sinf(p0), cosf(p0) * sinf(a1)};
+            Vector3 v10 = {cosf(p1) * cosf(a0), sinf(p1), cosf(p1) * sinf(a0)};
+            Vector3 v11 = {cosf(p1) * cosf(a1), sinf(p1), cosf(p1) * sinf(a1)};
+            v00 = Vector3Add(center, Vector3Scale(v00, radius));
+            v01 = Vector3Add(center, Vector3Scale(v01, radius));
+            v10 = Vector3Add(center, Vector3Scale(v10, radius));
+            v11 = Vector3Add(center, Vector3Scale(v11, radius));
+            
+            Tree3DEmitVertex(vertices, colors, n++, v00, color);
+            Tree3DEmitVertex(vertices, colors, n++, v11, color);
+            Tree3DEmitVertex(vertices, colors, n++, v01, color);
+            
+            Tree3DEmitVertex(vertices, colors, n++, v00, color);
+            Tree3DEmitVertex(vertices, colors, n++, v10, color);
+            Tree3DEmitVertex(vertices, colors, n++, v11, color);
+        }
+    }
+    
+    return n - first;
+}
+
+static Mesh Tree3DAllocMesh(int vertexCount) {
+    Mesh mesh = {0};
+    mesh.vertexCount = vertexCount;
+    mesh.triangleCount = vertexCount / 3;
+    mesh.vertices = (float*)RL_CALLOC(vertexCount * 3, sizeof(float));
+    
+    if (!mesh.vertices) {
+        fprintf(stderr, "Failed to allocate mesh data\n");
+        exit(1);
+    }
+    
+    return mesh;
+}
+
+// False when the instancing shader cannot be built, in which case callers
+// draw as TREE3D_RENDER_IMMEDIATE. A failure is not retried until
+// Tree3DCloseRenderer.
+bool Tree3DInitRenderer(void) {
+    if (tree3dRenderer.ready) return true;
+    if (tree3dRenderer.failed) return false;
+    
+    Shader shader = LoadShaderFromMemory(tree3dInstanceVS, tree3dInstanceFS);
+    if (shader.id == 0 || shader.id == rlGetShaderIdDefault()) {
+        fprintf(stderr, "Failed to build the instancing shader, drawing trees immediately\n");
+        tree3dRenderer.failed = true;
+        return false;
+    }
+    shader.locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(shader, "mvp");
+    shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shader, "instanceTransform");
+    if (shader.locs[SHADER_LOC_MATRIX_MODEL] < 0) {
+        fprintf(stderr, "Instancing shader has no instanceTransform attribute, drawing trees immediately\n");
+        UnloadShader(shader);
+        tree3dRenderer.failed = true;
+        return false;
+    }
+    
+    // Unit branch: base at the origin, radius 1, growing one unit along +Y
+    tree3dRenderer.branchMesh = Tree3DAllocMesh(TREE3D_TUBE_VERTICES(TREE3D_INSTANCE_SLICES));
+    Tree3DEmitTube(tree3dRenderer.branchMesh.vertices, NULL, 0,
+                   (Vector3){0.0f, 0.0f, 0.0f}, (Vector3){0.0f, 1.0f, 0.0f},
+                   1.0f, TREE3D_BRANCH_TAPER, TREE3D_INSTANCE_SLICES, WHITE);
+    UploadMesh(&tree3dRenderer.branchMesh, false);
+    
+    // Unit leaf sphere
+    tree3dRenderer.leafMesh = Tree3DAllocMesh(TREE3D_SPHERE_VERTICES(TREE3D_LEAF_RINGS, TREE3D_LEAF_SLICES));
+    Tree3DEmitSphere(tree3dRenderer.leafMesh.vertices, NULL, 0,
+                     (Vector3){0.0f, 0.0f, 0.0f}, 1.0f, TREE3D_LEAF_RINGS, TREE3D_LEAF_SLICES, WHITE);
+    UploadMesh(&tree3dRenderer.leafMesh, false);
+    
+    tree3dRenderer.material = LoadMaterialDefault();
+    tree3dRenderer.material.shader = shader;
+    
+    // Baked meshes carry vertex colors, which the default shader already uses
+    tree3dRenderer.bakedMaterial = LoadMaterialDefault();
+    
+    tree3dRenderer.ready = true;
+    return true;
+}
+
+// Release the shared draw resources, the impostor shader included; call it
+// before CloseWindow so a later window starts fresh
+void Tree3DCloseRenderer(void) {
+    TreeImpostorUnloadShader();
+    tree3dRenderer.failed = false;
+    if (!tree3dRenderer.ready) return;
+    
+    UnloadMesh(tree3dRenderer.branchMesh);
+    UnloadMesh(tree3dRenderer.leafMesh);
+    UnloadMaterial(tree3dRenderer.material);
+    UnloadMaterial(tree3dRenderer.bakedMaterial);
+    
+    tree3dRenderer.ready = false;
+}
+
+static void Tree3DPackInstanceColor(Matrix *m, Color color) {
+    m->m3 = color.r / 255.0f;
+    m->m7 = color.g / 255.0f;
+    m->m11 = color.b / 255.0f;
+    m->m15 = 1.0f;
+}
+
+// Instance transforms for the branches of [first, first + count) flagged in
+// visible, written compactly to out. Each maps the unit branch mesh onto the
+// drawn segment; the basis comes from the full-grown direction so it stays
+// valid while the branch animates. Returns the number written.
+static int Tree3DBranchInstances(const Tree3DBranchStreams *s, size_t first, int count, float grow,
+                                 const unsigned char *visible, Matrix *out) {
+    float pad[7][TREE3D_LANES];
+    float lanes[12][TREE3D_LANES];
+    Tree3DLane keep = Tree3DLaneSet(1.0f - grow);
+    Tree3DLane zero = Tree3DLaneSet(0.0f);
+    Tree3DLane one = Tree3DLaneSet(1.0f);
+    int written = 0;
+    
+    for (int i = 0; i < count; i += TREE3D_LANES) {
+        int n = count - i < TREE3D_LANES ? count - i : TREE3D_LANES;
+        size_t b = first + i;
+        bool any = false;
+        for (int k = 0; k < n; k++) any |= visible[i + k] != 0;
+        if (!any) continue;
+        
+        Tree3DLane x1 = Tree3DLaneLoad(Tree3DLaneSource(s->x1 + b, n, pad[0]));
+        Tree3DLane y1 = Tree3DLaneLoad(Tree3DLaneSource(s->y1 + b, n, pad[1]));
+        Tree3DLane z1 = Tree3DLaneLoad(Tree3DLaneSource(s->z1 + b, n, pad[2]));
+        Tree3DLane ax = Tree3DLaneSub(Tree3DLaneLoad(Tree3DLaneSource(s->x2 + b, n, pad[3])), x1);
+        Tree3DLane ay = Tree3DLaneSub(Tree3DLaneLoad(Tree3DLaneSource(s->y2 + b, n, pad[4])), y1);
+        Tree3DLane az = Tree3DLaneSub(Tree3DLaneLoad(Tree3DLaneSource(s->z2 + b, n, pad[5])), z1);
+        Tree3DLane width = Tree3DLaneLoad(Tree3DLaneSource(s->width + b, n, pad[6]));
+        
+        // dir = normalize(axis)
+        Tree3DLane length = Tree3DLaneSqrt(Tree3DLaneAdd(Tree3DLaneAdd(Tree3DLaneMul(ax, ax), Tree3DLaneMul(ay, ay)),
+                                                         Tree3DLaneMul(az, az)));
+        Tree3DLane inv = Tree3DLaneSelect(Tree3DLaneLess(zero, length), Tree3DLaneDiv(one, length), zero);
+        Tree3DLane dx = Tree3DLaneMul(ax, inv);
+        Tree3DLane dy = Tree3DLaneMul(ay, inv);
+        Tree3DLane dz = Tree3DLaneMul(az, inv);
+        
+        // u = normalize(dir x ref), ref = +Y unless dir is nearly vertical, then +X
+        Tree3DLane useY = Tree3DLaneLess(Tree3DLaneAbs(dy), Tree3DLaneSet(0.99f));
+        Tree3DLane ux = Tree3DLaneSelect(useY, Tree3DLaneSub(zero, dz), zero);
+        Tree3DLane uy = Tree3DLaneSelect(useY, zero, dz);
+        Tree3DLane uz = Tree3DLaneSelect(useY, dx, Tree3DLaneSub(zero, dy));
+        length = Tree3DLaneSqrt(Tree3DLaneAdd(Tree3DLaneAdd(Tree3DLaneMul(ux, ux), Tree3DLaneMul(uy, uy)),
+                                              Tree3DLaneMul(uz, uz)));
+        inv = Tree3DLaneSelect(Tree3DLaneLess(zero, length), Tree3DLaneDiv(one, length), zero);
+        ux = Tree3DLaneMul(ux, inv);
+        uy = Tree3DLaneMul(uy, inv);
+        uz = Tree3DLaneMul(uz, inv);
+        
+        // w = u x dir keeps the basis right-handed so winding survives
+        Tree3DLane wx = Tree3DLaneSub(Tree3DLaneMul(uy, dz), Tree3DLaneMul(uz, dy));
+        Tree3DLane wy = Tree3DLaneSub(Tree3DLaneMul(uz, dx), Tree3DLaneMul(ux, dz));
+        Tree3DLane wz = Tree3DLaneSub(Tree3DLaneMul(ux, dy), Tree3DLaneMul(uy, dx));
+        
+        Tree3DLaneStore(lanes[0], Tree3DLaneMul(ux, width));
+        Tree3DLaneStore(lanes[1], Tree3DLaneMul(uy, width));
+        Tree3DLaneStore(lanes[2], Tree3DLaneMul(uz, width));
+        Tree3DLaneStore(lanes[3], Tree3DLaneMul(ax, keep));
+        Tree3DLaneStore(lanes[4], Tree3DLaneMul(ay, keep));
+        Tree3DLaneStore(lanes[5], Tree3DLaneMul(az, keep));
+        Tree3DLaneStore(lanes[6], Tree3DLaneMul(wx, width));
+        Tree3DLaneStore(lanes[7], Tree3DLaneMul(wy, width));
+        Tree3DLaneStore(lanes[8], Tree3DLaneMul(wz, width));
+        Tree3DLaneStore(lanes[9], x1);
+        Tree3DLaneStore(lanes[10], y1);
+        Tree3DLaneStore(lanes[11], z1);
+        
+        for (int k = 0; k < n; k++) {
+            if (!visible[i + k]) continue;
+            Matrix m = {0};
+            m.m0 = lanes[0][k]; m.m4 = lanes[3][k]; m.m8 = lanes[6][k];  m.m12 = lanes[9][k];
+            m.m1 = lanes[1][k]; m.m5 = lanes[4][k]; m.m9 = lanes[7][k];  m.m13 = lanes[10][k];
+            m.m2 = lanes[2][k]; m.m6 = lanes[5][k]; m.m10 = lanes[8][k]; m.m14 = lanes[11][k];
+            Tree3DPackInstanceColor(&m, s->nodes[b + k].color);
+            out[written++] = m;
+        }
+    }
+    return written;
+}
+
+static Matrix Tree3DEllipsoidTransform(Vector3 center, Vector3 radii, Color color) {
+    Matrix m = {0};
+    m.m0 = radii.x; m.m5 = radii.y; m.m10 = radii.z;
+    m.m12 = center.x; m.m13 = center.y; m.m14 = center.z;
+    Tree3DPackInstanceColor(&m, color);
+    return m;
+}
+
+static Matrix Tree3DLeafTransform(Vector3 center, float radius, Color color) {
+    return Tree3DEllipsoidTransform(center, (Vector3){radius, radius, radius}, color);
+}
+
+static void Tree3DResizeBakedVertices(Tree3D *tree, int newCapacity) {
+    Tree3DBakedMesh *baked = &tree->baked;
+    float *vertices = (float*)Tree3DRealloc(tree, baked->vertices, baked->capacity * 3 * sizeof(float),
+                                            newCapacity * 3 * sizeof(float));
+    if (vertices) baked->vertices = vertices;
+    unsigned char *colors = (unsigned char*)Tree3DRealloc(tree, baked->colors, baked->capacity * 4 * sizeof(unsigned char),
+                                                          newCapacity * 4 * sizeof(unsigned char));
+    if (colors) baked->colors = colors;
+    
+    if (!vertices || !colors) {
+        fprintf(stderr, "Failed to allocate baked mesh\n");
+        exit(1);
+    }
+    
+    baked->capacity = newCapacity;
+}
+
+static void Tree3DReserveBakedVertices(Tree3D *tree, int needed) {
+    Tree3DBakedMesh *baked = &tree->baked;
+    if (needed <= baked->capacity) return;
+    
+    int newCapacity = baked->capacity > 0 ? baked->capacity : 4096;
+    while (newCapacity < needed) newCapacity *= 2;
+    Tree3DResizeBakedVertices(tree, newCapacity);
+}
+
+// Append rows [bakedRows, rowCount) and the leaves hanging off them to the
+// baked mesh. Leaves grown from row r sit on row r + 1 and carry Row = r.
+void Tree3DBakeRows(Tree3D *tree, int rowCount) {
+    Tree3DBakedMesh *baked = &tree->baked;
+    if (rowCount > tree->CurrentRow + 1) rowCount = tree->CurrentRow + 1;
+    if (rowCount <= baked->bakedRows) return;
+    
+    Vector3 origin = {tree->X, tree->Y, tree->Z};
+    
+    for (int i = baked->bakedRows; i < rowCount; i++) {
+        Tree3DReserveBakedVertices(tree, baked->vertexCount +
+                                   tree->BranchCount[i] * TREE3D_TUBE_VERTICES(TREE3D_BAKE_SLICES));
+        
+        const Tree3DBranchStreams *s = &tree->memPool.branches;
+        for (int j = 0; j < tree->BranchCount[i]; j++) {
+            size_t b = Tree3DBranchIndex(tree, i, j);
+            baked->vertexCount += Tree3DEmitTube(baked->vertices, baked->colors, baked->vertexCount,
+                                                 Vector3Subtract(Tree3DBranchStart(s, b), origin),
+                                                 Vector3Subtract(Tree3DBranchTip(s, b), origin),
+                                                 s->width[b], s->width[b] * TREE3D_BRANCH_TAPER,
+                                                 TREE3D_BAKE_SLICES, s->nodes[b].color);
+        }
+    }
+    
+    int leafVertices = TREE3D_SPHERE_VERTICES(TREE3D_BAKE_LEAF_RINGS, TREE3D_BAKE_LEAF_SLICES);
+    while (baked->bakedLeaves < tree->LeafCount) {
+        Tree3DLeaf *l = &tree->memPool.leafPool[baked->bakedLeaves];
+        if ((int)l->Row + 1 >= rowCount) break;
+        
+        if (l->isActive) {
+            Tree3DReserveBakedVertices(tree, baked->vertexCount + leafVertices * 2);
+            float radius = l->Radius * tree->Scale;
+            baked->vertexCount += Tree3DEmitSphere(baked->vertices, baked->colors, baked->vertexCount,
+                                                   Vector3Subtract(l->V1, origin), radius,
+                                                   TREE3D_BAKE_LEAF_RINGS, TREE3D_BAKE_LEAF_SLICES, l->Color);
+            baked->vertexCount += Tree3DEmitSphere(baked->vertices, baked->colors, baked->vertexCount,
+                                                   Vector3Subtract(l->V2, origin), radius,
+                                                   TREE3D_BAKE_LEAF_RINGS, TREE3D_BAKE_LEAF_SLICES, l->Color);
+        }
+        baked->bakedLeaves++;
+    }
+    
+    baked->bakedRows = rowCount;
+    baked->dirty = true;
+    
+    // Nothing more will be appended once the last row is in
+    if (rowCount > tree->MaxRow && baked->vertexCount > 0 && baked->vertexCount < baked->capacity) {
+        Tree3DResizeBakedVertices(tree, baked->vertexCount);
+    }
+}
+
+static void Tree3DUnloadBakedGPU(Tree3DBakedMesh *baked) {
+    if (baked->mesh.vaoId > 0) {
+        UnloadMesh(baked->mesh);
+    }
+    baked->mesh = (Mesh){0};
+}
+
+void Tree3DResetBakedMesh(Tree3D *tree) {
+    tree->baked.vertexCount = 0;
+    tree->baked.bakedRows = 0;
+    tree->baked.bakedLeaves = 0;
+    tree->baked.dirty = true;
+}
+
+void Tree3DDrawBakedMesh(Tree3D *tree) {
+    Tree3DBakedMesh *baked = &tree->baked;
+    
+    if (baked->dirty) {
+        Tree3DUnloadBakedGPU(baked);
+        if (baked->vertexCount > 0) {
+            baked->mesh.vertexCount = baked->vertexCount;
+            baked->mesh.triangleCount = baked->vertexCount / 3;
+            baked->mesh.vertices = baked->vertices;
+            baked->mesh.colors = baked->colors;
+            UploadMesh(&baked->mesh, false);
+            
+            // The CPU copy stays owned by the tree so rows can keep appending
+            baked->mesh.vertices = NULL;
+            baked->mesh.colors = NULL;
+        }
+        baked->dirty = false;
+    }
+    
+    if (baked->mesh.vaoId == 0) return;
+    
+    if (!Tree3DInitRenderer()) return;
+    DrawMesh(baked->mesh, tree3dRenderer.bakedMaterial, MatrixTranslate(tree->X, tree->Y, tree->Z));
+    TREE_STATS_ADD(tree3dFrameStats, drawCalls, 1);
+}
+
+void Tree3DFreeBakedMesh(Tree3D *tree) {
+    Tree3DBakedMesh *baked = &tree->baked;
+    Tree3DUnloadBakedGPU(baked);
+    
+    if (baked->vertices) {
+        Tree3DDealloc(tree, baked->vertices);
+        baked->vertices = NULL;
+    }
+    
+    if (baked->colors) {
+        Tree3DDealloc(tree, baked->colors);
+        baked->colors = NULL;
+    }
+    
+    baked->vertexCount = baked->capacity = 0;
+    baked->bakedRows = baked->bakedLeaves = 0;
+}
+
+// First row and leaf that still need per-frame drawing
+static void Tree3DGetDynamicRange(const Tree3D *tree, int *firstRow, int *firstLeaf) {
+    *firstRow = tree->useBakedMesh ? tree->baked.bakedRows : 0;
+    *firstLeaf = tree->useBakedMesh ? tree->baked.bakedLeaves : 0;
+}
+
+// Branch and Growth Functions
+void Tree3DAppendRow(Tree3D *tree) {
+    if (tree->CurrentRow + 1 < tree->AllocatedRows) {
+        tree->RowOffsets[tree->CurrentRow + 1] = (int)tree->memPool.branchPoolIndex;
+        tree->BranchCount[tree->CurrentRow + 1] = 0;
+    }
+}
+
+// Pool index of a fresh branch slot, or -1 when the pool is exhausted
+static long Tree3DGetNextBranch(Tree3D *tree) {
+    if (!tree) {
+        return -1;
+    }
+    
+    if (tree->memPool.branchPoolIndex >= (size_t)MAX_ROWS * MAX_BRANCHES_PER_ROW) {
+        tree->droppedBranches++;
+        return -1;
+    }
+    
+    Tree3DReserveBranches(tree, tree->memPool.branchPoolIndex + 1);
+    return (long)tree->memPool.branchPoolIndex++;
+}
+
+
+Tree3DLeaf* Tree3DGetNextLeaf(Tree3D *tree) {
+    if (tree->memPool.leafPoolIndex >= MAX_LEAVES) {
+        return NULL;
+    }
+    Tree3DReserveLeaves(tree, tree->memPool.leafPoolIndex + 1);
+    return &tree->memPool.leafPool[tree->memPool.leafPoolIndex++];
+}
+
+
+void Tree3DAppendBranch(Tree3D *tree, int row, Tree3DBranch branch) {
+    if (!tree || !tree->RowOffsets || !tree->BranchCount) {
+        fprintf(stderr, "Tree not properly initialized\n");
+        return;
+    }
+    
+    if (row >= tree->AllocatedRows || row < 0) {
+        fprintf(stderr, "Invalid row index: %d\n", row);
+        return;
+    }
+    
+    // Rows are contiguous in the pool, so only the newest row can take branches
+    if ((size_t)(tree->RowOffsets[row] + tree->BranchCount[row]) != tree->memPool.branchPoolIndex) {
+        fprintf(stderr, "Branches must be appended to the newest row\n");
+        return;
+    }
+    
+    if (tree->BranchCount[row] >= MAX_BRANCHES_PER_ROW) {
+        tree->droppedBranches++;
+        return;
+    }
+    
+    long slot = Tree3DGetNextBranch(tree);
+    if (slot < 0) return;
+    
+    Tree3DStoreBranch(&tree->memPool.branches, (size_t)slot, &branch, TREE3D_NO_PARENT, row);
+    tree->BranchCount[row]++;
+    tree->needsBoundsUpdate = true;
+}
+
+void Tree3DAppendLeaf(Tree3D *tree, Tree3DLeaf leaf) {
+    if (tree->LeafCount >= MAX_LEAVES) {
+        tree->droppedLeaves++;
+        return;
+    }
+    
+    Tree3DLeaf* newLeaf = Tree3DGetNextLeaf(tree);
+    if (!newLeaf) {
+        tree->droppedLeaves++;
+        return;
+    }
+    
+    *newLeaf = leaf;
+    newLeaf->isActive = true;
+    tree->LeafCount++;
+}
+
+// Union of the per-row BVH bounds: every grown branch (full length, padded
+// by width) and leaf. MinX/MaxX/MinZ/MaxZ mirror the box.
+void Tree3DUpdateBounds(Tree3D *tree) {
+    if (!tree->needsBoundsUpdate) return;
+    
+    BoundingBox bounds = Tree3DEmptyBox();
+    for (int i = 0; i < tree->bvh.builtRows; i++) {
+        bounds = Tree3DMergeBox(bounds, tree->bvh.rowBounds[i]);
+    }
+    
+    tree->bounds = bounds;
+    tree->MinX = bounds.min.x;
+    tree->MaxX = bounds.max.x;
+    tree->MinZ = bounds.min.z;
+    tree->MaxZ = bounds.max.z;
+    tree->needsBoundsUpdate = false;
+}
+
+// Canopy Clustering
+// Leaf spheres are bucketed on a grid with TREE3D_CANOPY_GRID cells along the
+// longest side of their bounds. Each occupied cell becomes a blob at the
+// spheres' mean, reaching sqrt(3) standard deviations out on each axis (the
+// half extent of an evenly filled box) plus their average radius.
+typedef struct {
+    double sum[3];
+    double sumSq[3];
+    double color[4];
+    double radius;
+    int spheres;
+} Tree3DCanopyCell;
+    
+static void Tree3DAddCanopySphere(Tree3DCanopyCell *cell, Vector3 p, float radius, Color color) {
+    float v[3] = {p.x, p.y, p.z};
+    for (int a = 0; a < 3; a++) {
+        cell->sum[a] += v[a];
+        cell->sumSq[a] += (double)v[a] * v[a];
+    }
+    cell->color[0] += color.r;
+    cell->color[1] += color.g;
+    cell->color[2] += color.b;
+    cell->color[3] += color.a;
+    cell->radius += radius;
+    cell->spheres++;
+}
+
+// Cluster the active leaves into canopy blobs. Called when growth finishes
+// if a tier uses them, and again by a canopy tier once leaves were added.
+void Tree3DBuildCanopy(Tree3D *tree) {
+    tree->canopyCount = 0;
+    tree->canopyLeaves = tree->LeafCount;
+    
+    BoundingBox box = Tree3DEmptyBox();
+    int active = 0;
+    for (int i = 0; i < tree->LeafCount; i++) {
+        const Tree3DLeaf *l = &tree->memPool.leafPool[i];
+        if (!l->isActive) continue;
+        box.min = Vector3Min(box.min, Vector3Min(l->V1, l->V2));
+        box.max = Vector3Max(box.max, Vector3Max(l->V1, l->V2));
+        active++;
+    }
+    if (active == 0) return;
+    
+    float extent[3] = {box.max.x - box.min.x, box.max.y - box.min.y, box.max.z - box.min.z};
+    float origin[3] = {box.min.x, box.min.y, box.min.z};
+    float longest = fmaxf(extent[0], fmaxf(extent[1], extent[2]));
+    float cellSize = longest > 0.0f ? longest / TREE3D_CANOPY_GRID : 1.0f;
+    int dims[3];
+    for (int a = 0; a < 3; a++) {
+        dims[a] = (int)ceilf(extent[a] / cellSize);
+        if (dims[a] < 1) dims[a] = 1;
+        if (dims[a] > TREE3D_CANOPY_GRID) dims[a] = TREE3D_CANOPY_GRID;
+    }
+    
+    int cellCount = dims[0] * dims[1] * dims[2];
+    Tree3DCanopyCell *cells = (Tree3DCanopyCell*)Tree3DAlloc(tree, cellCount * sizeof(Tree3DCanopyCell));
+    if (!cells) {
+        fprintf(stderr, "Failed to allocate canopy cells\n");
+        exit(1);
+    }
+    memset(cells, 0, cellCount * sizeof(Tree3DCanopyCell));
+    
+    for (int i = 0; i < tree->LeafCount; i++) {
+        const Tree3DLeaf *l = &tree->memPool.leafPool[i];
+        if (!l->isActive) continue;
+    
+        for (int j = 0; j < 2; j++) {
+            Vector3 p = j == 0 ? l->V1 : l->V2;
+            float v[3] = {p.x, p.y, p.z};
+            int c[3];
+            for (int a = 0; a < 3; a++) {
+                c[a] = (int)((v[a] - origin[a]) / cellSize);
+                if (c[a] < 0) c[a] = 0;
+                if (c[a] >= dims[a]) c[a] = dims[a] - 1;
+            }
+            Tree3DCanopyCell *cell = &cells[(c[2] * dims[1] + c[1]) * dims[0] + c[0]];
+            Tree3DAddCanopySphere(cell, p, l->Radius * tree->Scale, l->Color);
+        }
+    }
+    
+    int occupied = 0;
+    for (int i = 0; i < cellCount; i++) {
+        if (cells[i].spheres > 0) occupied++;
+    }
+    if (occupied > tree->canopyCapacity) {
+        tree->canopy = (Tree3DCanopyBlob*)Tree3DRealloc(tree, tree->canopy,
+                                                        (size_t)tree->canopyCapacity * sizeof(Tree3DCanopyBlob),
+                                                        (size_t)occupied * sizeof(Tree3DCanopyBlob));
+        if (!tree->canopy) {
+            fprintf(stderr, "Failed to allocate canopy\n");
+            exit(1);
+        }
+        tree->canopyCapacity = occupied;
+    }
+    
+    for (int i = 0; i < cellCount; i++) {
+        const Tree3DCanopyCell *cell = &cells[i];
+        if (cell->spheres == 0) continue;
+    
+        double n = cell->spheres;
+        float radius = (float)(cell->radius / n);
+        float center[3], radii[3];
+        for (int a = 0; a < 3; a++) {
+            double mean = cell->sum[a] / n;
+            double variance = cell->sumSq[a] / n - mean * mean;
+            center[a] = (float)mean;
+            radii[a] = (float)sqrt(variance > 0.0 ? 3.0 * variance : 0.0) + radius;
+        }
+    
+        Tree3DCanopyBlob *blob = &tree->canopy[tree->canopyCount++];
+        blob->center = (Vector3){center[0], center[1], center[2]};
+        blob->radii = (Vector3){radii[0], radii[1], radii[2]};
+        blob->color = (Color){
+            (unsigned char)(cell->color[0] / n + 0.5),
+            (unsigned char)(cell->color[1] / n + 0.5),
+            (unsigned char)(cell->color[2] / n + 0.5),
+            (unsigned char)(cell->color[3] / n + 0.5)
+        };
+        blob->spheres = cell->spheres;
+    }
+    
+    Tree3DDealloc(tree, cells);
+}
+
+float Tree3DGetNextPos(Tree3D *tree, float a, float b) {
+    return b + (a - b) * tree->GrowTimer / (float)tree->GrowTime;
+}
+
+// Growth Random Numbers
+// Counter-based: each value hashes the tree's growKey, the parent branch
+// and a fixed slot, so children come out the same whatever order (or
+// thread) they are generated in.
+enum {
+    TREE3D_SLOT_SPLIT = 0,
+    TREE3D_SLOT_ANGLE_X,
+    TREE3D_SLOT_ANGLE_Z,
+    TREE3D_SLOT_SPLIT_TYPE,
+    TREE3D_SLOT_CHILD           // Per child: branch r, g, b, leaf roll, leaf r, g, b
+};
+#define TREE3D_SLOTS_PER_CHILD 8
+
+static uint64_t Tree3DMix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t Tree3DBranchKey(const Tree3D *tree, int row, int index) {
+    return Tree3DMix64(tree->growKey ^ ((uint64_t)(uint32_t)row << 32 | (uint32_t)index));
+}
+
+static uint32_t Tree3DSlotRandom(uint64_t key, int slot) {
+    return (uint32_t)(Tree3DMix64(key + (uint64_t)(slot + 1) * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static int Tree3DSlotInt(uint64_t key, int slot, int n) {
+    if (n <= 0) return 0;
+    return (int)(((uint64_t)Tree3DSlotRandom(key, slot) * (uint32_t)n) >> 32);
+}
+
+static Color Tree3DSlotColor(uint64_t key, int slot, const unsigned char cs[6]) {
+    Color color;
+    color.r = cs[0] + Tree3DSlotInt(key, slot, cs[1] - cs[0] + 1);
+    color.g = cs[2] + Tree3DSlotInt(key, slot + 1, cs[3] - cs[2] + 1);
+    color.b = cs[4] + Tree3DSlotInt(key, slot + 2, cs[5] - cs[4] + 1);
+    color.a = 255;
+    return color;
+}
+
+// Row Growth
+// Phase one decides every parent's children (count, angles, leaves); a
+// prefix sum then gives each parent its output slots; phase two fills the
+// children. Both phases only touch their own parent's data, so they can be
+// split across threads.
+typedef struct {
+    int degX[2];
+    int degZ[2];
+    int childCount;
+    bool hasLeaf[2];
+    int firstChild;     // Slot in the new row
+    int firstLeaf;      // Slot after the row's first leaf
+} Tree3DGrowPlan;
+
+typedef struct {
+    Tree3DGrowPlan *plans;
+    int parentRow;
+    size_t childBase;   // Pool index of the new row
+    size_t leafBase;    // Pool index of the row's first leaf
+    int maxChildren;    // Slots past these are dropped
+    int maxLeaves;
+} Tree3DGrowRow;
+
+static void Tree3DPlanChildren(Tree3D *tree, int begin, int end, void *ctx) {
+    Tree3DGrowRow *grow = (Tree3DGrowRow*)ctx;
+    int splitMin = tree->SplitAngle[0] * TREE3D_TRIG_RESOLUTION;
+    int splitRange = (tree->SplitAngle[1] - tree->SplitAngle[0]) * TREE3D_TRIG_RESOLUTION;
+    int jitter = 10 * TREE3D_TRIG_RESOLUTION;
+    const Tree3DBranchStreams *s = &tree->memPool.branches;
+    
+    for (int i = begin; i < end; i++) {
+        Tree3DGrowPlan *plan = &grow->plans[i];
+        const Tree3DBranchNode *node = &s->nodes[Tree3DBranchIndex(tree, grow->parentRow, i)];
+        int degX = node->degX;
+        int degZ = node->degZ;
+        uint64_t key = Tree3DBranchKey(tree, grow->parentRow, i);
+        
+        if (tree->SplitChance > Tree3DSlotInt(key, TREE3D_SLOT_SPLIT, 100)) {
+            // Two branches, the second mirrored in X, Z or both
+            int angleX = splitMin + Tree3DSlotInt(key, TREE3D_SLOT_ANGLE_X, splitRange);
+            int angleZ = splitMin + Tree3DSlotInt(key, TREE3D_SLOT_ANGLE_Z, splitRange);
+            int splitType = Tree3DSlotInt(key, TREE3D_SLOT_SPLIT_TYPE, 3);  // 0 = X, 1 = Z, 2 = both
+            
+            plan->degX[0] = degX + angleX;
+            plan->degZ[0] = degZ + angleZ;
+            plan->degX[1] = degX + (splitType == 1 ? angleX : -angleX);
+            plan->degZ[1] = degZ + (splitType == 0 ? angleZ : -angleZ);
+            plan->childCount = 2;
+        } else {
+            // Single branch with slight variation
+            plan->degX[0] = degX + Tree3DSlotInt(key, TREE3D_SLOT_ANGLE_X, 2 * jitter + 1) - jitter;
+            plan->degZ[0] = degZ + Tree3DSlotInt(key, TREE3D_SLOT_ANGLE_Z, 2 * jitter + 1) - jitter;
+            plan->childCount = 1;
+        }
+        
+        for (int c = 0; c < plan->childCount; c++) {
+            int slot = TREE3D_SLOT_CHILD + c * TREE3D_SLOTS_PER_CHILD + 3;
+            float leafChance = (Tree3DSlotRandom(key, slot) >> 8) * (1.0f / 16777215.0f)
+                               * tree->CurrentRow / tree->MaxRow;
+            plan->hasLeaf[c] = leafChance > tree->LeafChance;
+        }
+    }
+}
+
+// The fill stays scalar. Each child gathers its parent's tip and a
+// trig-table rotation, which the lane wrappers have no gather for, and that
+// leaves only a few multiply-adds per child to vectorise.
+static void Tree3DFillChildren(Tree3D *tree, int begin, int end, void *ctx) {
+    Tree3DGrowRow *grow = (Tree3DGrowRow*)ctx;
+    Tree3DBranchStreams *s = &tree->memPool.branches;
+    
+    for (int i = begin; i < end; i++) {
+        const Tree3DGrowPlan *plan = &grow->plans[i];
+        size_t parent = Tree3DBranchIndex(tree, grow->parentRow, i);
+        uint64_t key = Tree3DBranchKey(tree, grow->parentRow, i);
+        int leafSlot = plan->firstLeaf;
+        
+        // Children past the row limit are dropped from the end of the row
+        int kept = grow->maxChildren - plan->firstChild;
+        kept = kept < 0 ? 0 : (kept > plan->childCount ? plan->childCount : kept);
+        s->nodes[parent].firstChild = (uint32_t)(grow->childBase + plan->firstChild);
+        s->nodes[parent].childCount = (uint16_t)kept;
+        
+        for (int c = 0; c < plan->childCount; c++) {
+            int slot = TREE3D_SLOT_CHILD + c * TREE3D_SLOTS_PER_CHILD;
+            float w = s->width[parent] * 0.9f;
+            float h = s->nodes[parent].height * 0.95f;
+            Vector3 pos = Tree3DBranchTip(s, parent);
+            Vector3 rot = Tree3DGetRotation(plan->degX[c], plan->degZ[c]);
+            Vector3 newPos = {
+                pos.x + rot.x * h * tree->Scale,
+                pos.y + rot.y * h * tree->Scale,
+                pos.z + rot.z * h * tree->Scale
+            };
+            
+            if (c < kept) {
+                Tree3DStoreBranch(s, grow->childBase + plan->firstChild + c, &(Tree3DBranch){
+                    .V1 = pos,
+                    .V2 = newPos,
+                    .Width = w,
+                    .Height = h,
+                    .Color = Tree3DSlotColor(key, slot, tree->CsBranch),
+                    .DegX = plan->degX[c],
+                    .DegZ = plan->degZ[c]
+                }, (uint32_t)parent, grow->parentRow + 1);
+            }
+            
+            if (!plan->hasLeaf[c]) continue;
+            if (leafSlot < grow->maxLeaves) {
+                Vector3 rotLeaf = Tree3DGetRotation(plan->degX[c] * 2, plan->degZ[c] * 2);
+                Vector3 leafOffset = {rotLeaf.x * w, rotLeaf.y * w, rotLeaf.z * w};
+                
+                tree->memPool.leafPool[grow->leafBase + leafSlot] = (Tree3DLeaf){
+                    .Row = tree->CurrentRow,
+                    .Radius = w,
+                    .V1 = Vector3Add(newPos, leafOffset),
+                    .V2 = Vector3Subtract(newPos, leafOffset),
+                    .Color = Tree3DSlotColor(key, slot + 4, tree->CsLeaf),
+                    .isActive = true
+                };
+            }
+            leafSlot++;
+        }
+    }
+}
+
+typedef void (*Tree3DRangeJob)(Tree3D *tree, int begin, int end, void *ctx);
+
+#ifdef TREE3D_THREADS
+typedef struct {
+    Tree3DRangeJob job;
+    Tree3D *tree;
+    int begin, end;
+    void *ctx;
+} Tree3DRangeTask;
+
+// Grow Workers
+// Started on the first parallel row and kept for the rest of the process,
+// asleep while no row is growing. One row at a time uses them; a row grown
+// meanwhile on another thread runs on that thread alone.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_mutex_t busy;           // Held by the thread whose row the workers run
+    Tree3DRangeTask tasks[TREE3D_MAX_GROW_THREADS];
+    bool queued[TREE3D_MAX_GROW_THREADS];   // Worker w has tasks[w] to run
+    int pending;                    // Worker tasks not yet finished
+    int workers;                    // Started so far; task 0 is the submitting thread's
+} Tree3DGrowPool;
+
+static Tree3DGrowPool tree3dGrowPool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .busy = PTHREAD_MUTEX_INITIALIZER
+};
+
+static void Tree3DRunRangeTask(const Tree3DRangeTask *task) {
+    task->job(task->tree, task->begin, task->end, task->ctx);
+}
+
+static void* Tree3DGrowWorker(void *arg) {
+    Tree3DGrowPool *pool = &tree3dGrowPool;
+    int worker = (int)(intptr_t)arg;
+    
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->queued[worker]) pthread_cond_wait(&pool->wake, &pool->lock);
+        pool->queued[worker] = false;
+        
+        pthread_mutex_unlock(&pool->lock);
+        Tree3DRunRangeTask(&pool->tasks[worker]);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) pthread_cond_signal(&pool->done);
+    }
+    return NULL;
+}
+
+// Start workers until `wanted` are running; returns how many are
+static int Tree3DStartGrowWorkers(Tree3DGrowPool *pool, int wanted) {
+    while (pool->workers < wanted) {
+        pthread_t thread;
+        // Worker 0 is the submitting thread
+        if (pthread_create(&thread, NULL, Tree3DGrowWorker, (void*)(intptr_t)(pool->workers + 1)) != 0) break;
+        pthread_detach(thread);
+        pool->workers++;
+    }
+    return pool->workers;
+}
+#endif
+
+// Run job over [0, count) in contiguous chunks, one per thread
+static void Tree3DRunRange(Tree3D *tree, int count, Tree3DRangeJob job, void *ctx) {
+#ifdef TREE3D_THREADS
+    int threads = tree->growThreads > 0 ? tree->growThreads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > count / TREE3D_GROW_GRAIN) threads = count / TREE3D_GROW_GRAIN;
+    if (threads > TREE3D_MAX_GROW_THREADS) threads = TREE3D_MAX_GROW_THREADS;
+    
+    Tree3DGrowPool *pool = &tree3dGrowPool;
+    if (tree->growMode == TREE3D_GROW_PARALLEL && threads > 1 && pthread_mutex_trylock(&pool->busy) == 0) {
+        // Only the thread holding busy starts workers or reads the count
+        int workers = Tree3DStartGrowWorkers(pool, threads - 1);
+        if (threads > workers + 1) threads = workers + 1;
+        
+        pthread_mutex_lock(&pool->lock);
+        for (int t = 0; t < threads; t++) {
+            pool->tasks[t] = (Tree3DRangeTask){job, tree, (int)((long long)count * t / threads),
+                                               (int)((long long)count * (t + 1) / threads), ctx};
+        }
+        for (int t = 1; t < threads; t++) pool->queued[t] = true;
+        pool->pending = threads - 1;
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+        
+        Tree3DRunRangeTask(&pool->tasks[0]);
+        
+        pthread_mutex_lock(&pool->lock);
+        while (pool->pending > 0) pthread_cond_wait(&pool->done, &pool->lock);
+        pthread_mutex_unlock(&pool->lock);
+        pthread_mutex_unlock(&pool->busy);
+        return;
+    }
+#endif
+    job(tree, 0, count, ctx);
+}
+
+// Work done once the last row has grown
+static void Tree3DFinishGrowth(Tree3D *tree) {
+    Tree3DShrinkStorage(tree);
+    if (tree->buildDepthOrder) Tree3DBuildDepthOrder(tree);
+    for (int i = 0; i < LOD_LEVELS; i++) {
+        if (tree->lodCanopy[i]) {
+            Tree3DBuildCanopy(tree);
+            break;
+        }
+    }
+}
+
+void Tree3DGrow(Tree3D *tree) {
+    if (tree->CurrentRow >= tree->MaxRow) return;
+
+    // MaxRow may have been raised since Tree3DLoad sized the row tables
+    Tree3DReserveRowTables(tree);
+
+    // No row past MAX_ROWS: its branches are dropped and growth ends here,
+    // so loops growing to MaxRow still finish
+    if (tree->CurrentRow + 1 >= tree->AllocatedRows) {
+        tree->droppedBranches += tree->BranchCount[tree->CurrentRow];
+        tree->MaxRow = tree->CurrentRow;
+        Tree3DFinishGrowth(tree);
+        return;
+    }
+
+    TREE_ZONE_BEGIN(tree3dZones, "Tree3DGrow");
+    Tree3DAppendRow(tree);
+    int prevRow = tree->CurrentRow;
+    int firstLeaf = tree->LeafCount;
+    int parents = tree->BranchCount[prevRow];
+    
+    // Every branch yields at most two children and two leaves
+    size_t maxChildren = 2 * (size_t)parents;
+    Tree3DReserveBranches(tree, tree->memPool.branchPoolIndex + maxChildren);
+    Tree3DReserveLeaves(tree, tree->memPool.leafPoolIndex + maxChildren);
+    
+    Tree3DGrowRow grow = {0};
+    grow.parentRow = prevRow;
+    grow.childBase = tree->memPool.branchPoolIndex;
+    grow.leafBase = tree->memPool.leafPoolIndex;
+    grow.maxChildren = MAX_BRANCHES_PER_ROW;
+    if ((size_t)grow.maxChildren > tree->memPool.branchCapacity - grow.childBase) {
+        grow.maxChildren = (int)(tree->memPool.branchCapacity - grow.childBase);
+    }
+    grow.maxLeaves = (int)(tree->memPool.leafCapacity - grow.leafBase);
+    grow.plans = (Tree3DGrowPlan*)Tree3DAlloc(tree, (parents > 0 ? parents : 1) * sizeof(Tree3DGrowPlan));
+    if (!grow.plans) {
+        fprintf(stderr, "Failed to allocate growth plans\n");
+        exit(1);
+    }
+    
+    Tree3DRunRange(tree, parents, Tree3DPlanChildren, &grow);
+    
+    // Prefix sums give every parent its output slots
+    int childTotal = 0, leafTotal = 0;
+    for (int i = 0; i < parents; i++) {
+        Tree3DGrowPlan *plan = &grow.plans[i];
+        plan->firstChild = childTotal;
+        plan->firstLeaf = leafTotal;
+        childTotal += plan->childCount;
+        for (int c = 0; c < plan->childCount; c++) {
+            leafTotal += plan->hasLeaf[c];
+        }
+    }
+    
+    Tree3DRunRange(tree, parents, Tree3DFillChildren, &grow);
+    Tree3DDealloc(tree, grow.plans);
+    
+    // Growth past a full row or pool is dropped and counted for Tree3DGetStats
+    if (childTotal > grow.maxChildren) {
+        tree->droppedBranches += childTotal - grow.maxChildren;
+        childTotal = grow.maxChildren;
+    }
+    if (leafTotal > grow.maxLeaves) {
+        tree->droppedLeaves += leafTotal - grow.maxLeaves;
+        leafTotal = grow.maxLeaves;
+    }
+    
+    tree->BranchCount[prevRow + 1] = childTotal;
+    tree->memPool.branchPoolIndex += childTotal;
+    tree->memPool.leafPoolIndex += leafTotal;
+    tree->LeafCount += leafTotal;
+        
+    Tree3DBuildRowBVH(tree, prevRow + 1, firstLeaf, tree->LeafCount - firstLeaf);
+    tree->CurrentRow++;
+    tree->needsBoundsUpdate = true;
+    
+    // Every row below the one now animating is final
+    if (tree->useBakedMesh) {
+        Tree3DBakeRows(tree, tree->CurrentRow);
+    }
+    
+    if (tree->CurrentRow >= tree->MaxRow) Tree3DFinishGrowth(tree);
+    TREE_ZONE_END(tree3dZones, "Tree3DGrow");
+}
+
+void Tree3DLoad(Tree3D *tree) {
+    if (!tree) {
+        fprintf(stderr, "Tree not properly initialized\n");
+        return;
+    }
+
+    Tree3DLoadBegin(tree);
+    while (Tree3DGenerateStep(tree)) {}
+}
+
+// Tree3DLoad without the RandomRow fast-forward: the trunk is in place and
+// the row to reach is picked, but no row is grown. Tree3DGenerateStep or
+// Tree3DGenerate grow the rest, a row at a time, to the same tree Tree3DLoad
+// would have made. Until then the tree can be queried and drawn as far as
+// it has grown; Tree3DUpdate leaves it alone.
+void Tree3DLoadBegin(Tree3D *tree) {
+    if (!tree) {
+        fprintf(stderr, "Tree not properly initialized\n");
+        return;
+    }
+
+    Tree3DInitTrigTables();
+    Tree3DSeedRandom(tree);
+    // Trees that fast-forward size their pools on the first generated row,
+    // so spawning many at once only pays for their trunks
+    if (tree->RandomRow) Tree3DReserveRowTables(tree);
+    else Tree3DReserveStorage(tree);
+    tree->CurrentRow = 0;
+    tree->memPool.branchPoolIndex = 0;
+    tree->memPool.leafPoolIndex = 0;
+    tree->LeafCount = 0;
+    tree->depthOrderCount = 0;
+    tree->canopyCount = 0;
+    tree->canopyLeaves = 0;
+    tree->droppedBranches = 0;
+    tree->droppedLeaves = 0;
+    Tree3DResetBakedMesh(tree);
+    Tree3DResetBVH(tree);
+    
+    memset(tree->RowOffsets, 0, tree->AllocatedRows * sizeof(int));
+    memset(tree->BranchCount, 0, tree->AllocatedRows * sizeof(int));
+    
+    Tree3DBranch initialBranch = {
+        .V1 = {tree->X, tree->Y, tree->Z},
+        .V2 = {tree->X, tree->Y + (tree->Height * tree->Scale), tree->Z},
+        .Width = tree->Width * tree->Scale,
+        .Height = tree->Height * tree->Scale,
+        .Color = Tree3DGetColor(tree, tree->CsBranch),
+        .DegX = 0,
+        .DegZ = 0
+    };
+
+    Tree3DAppendBranch(tree, 0, initialBranch);
+    Tree3DBuildRowBVH(tree, 0, 0, 0);
+    tree->GrowTimer = tree->GrowTime;
+    tree->generateRow = tree->RandomRow ? Tree3DRandomInt(tree, tree->MaxRow) : 0;
+    if (tree->RandomRow && tree->generateRow == 0) Tree3DReserveStorage(tree);
+    tree->needsBoundsUpdate = true;
+}
+
+// Grow one row of a tree started with Tree3DLoadBegin. Returns true while
+// rows remain.
+bool Tree3DGenerateStep(Tree3D *tree) {
+    if (tree->CurrentRow >= tree->generateRow) return false;
+    if (tree->CurrentRow == 0) Tree3DReserveStorage(tree);
+    Tree3DGrow(tree);
+    return tree->CurrentRow < tree->generateRow;
+}
+
+bool Tree3DIsGenerating(const Tree3D *tree) {
+    return tree->CurrentRow < tree->generateRow;
+}
+
+// Round-robin over trees[indices[0..count)] (trees[0..count) without
+// indices), growing one row of each tree still generating until the deadline;
+// at least one row is grown. *cursor is the turn to resume from. stepped, if
+// set, sees each tree after its row. Returns false once a whole turn found
+// nothing left to grow.
+static bool Tree3DGenerateTurns(Tree3D *trees, const int *indices, int count, int *cursor, double deadline,
+                                void (*stepped)(void *user, Tree3D *tree), void *user) {
+    int i = (*cursor > 0) ? *cursor % count : 0;
+    int idle = 0;       // Trees in a row found with nothing left to grow
+
+    while (idle < count) {
+        Tree3D *tree = &trees[indices ? indices[i] : i];
+        i = (i + 1) % count;
+        if (!Tree3DIsGenerating(tree)) {
+            idle++;
+            continue;
+        }
+
+        Tree3DGenerateStep(tree);
+        if (stepped) stepped(user, tree);
+        idle = 0;
+        if (GetTime() >= deadline) break;
+    }
+    *cursor = i;
+    return idle < count;
+}
+
+// Grow rows of the trees still generating, one row per tree in turn, until
+// budgetUs microseconds have passed; at least one row is grown per call.
+// *cursor keeps the turn between calls (start it at 0) so every tree keeps
+// advancing. Call once per frame; returns the trees still generating.
+int Tree3DGenerate(Tree3D *trees, int count, int *cursor, float budgetUs) {
+    if (count <= 0) return 0;
+
+    int turn = cursor ? *cursor : 0;
+    bool generating = Tree3DGenerateTurns(trees, NULL, count, &turn, GetTime() + budgetUs * 1e-6, NULL, NULL);
+    if (cursor) *cursor = turn;
+    if (!generating) return 0;
+
+    int pending = 0;
+    for (int t = 0; t < count; t++) pending += Tree3DIsGenerating(&trees[t]);
+    return pending;
+}
+
+void Tree3DUpdate(Tree3D *tree) {
+    // Rows still to fast-forward belong to Tree3DGenerate, not the animation
+    if (Tree3DIsGenerating(tree)) return;
 
-// Initialize trig lookup tables
-void Tree3DInitTrigTables(Tree3D *tree) {
-    tree->sinTable = (float*)malloc(TRIG_TABLE_SIZE * sizeof(float));
-    tree->cosTable = (float*)malloc(TRIG_TABLE_SIZE * sizeof(float));
-    
-    if (!tree->sinTable || !tree->cosTable) {
-        fprintf(stderr, "Failed to allocate trig tables\n");
-        exit(1);
+    if (tree->GrowTimer > 0) {
+        tree->GrowTimer--;
+        tree->growthState.needsUpdate = true;
     }
-    
-    for (int i = 0; i < TRIG_TABLE_SIZE; i++) {
-        float rad = i * DEG_TO_RAD;
-        tree->sinTable[i] = sinf(rad);
-        tree->cosTable[i] = cosf(rad);
+
+    if (tree->GrowTimer == 0) {
+        if (tree->CurrentRow < tree->MaxRow) {
+            Tree3DGrow(tree);
+            tree->GrowTimer = tree->GrowTime;
+        } else if (tree->useBakedMesh) {
+            // The last row has finished animating
+            Tree3DBakeRows(tree, tree->CurrentRow + 1);
+        }
     }
 }
 
-void Tree3DInitMemoryPool(Tree3D *tree) {
-    tree->memPool.branchPool = (Tree3DBranch*)calloc(
-        MAX_ROWS * MAX_BRANCHES_PER_ROW, sizeof(Tree3DBranch));
-    tree->memPool.leafPool = (Tree3DLeaf*)calloc(
-        MAX_LEAVES, sizeof(Tree3DLeaf));
-    
-    if (!tree->memPool.branchPool || !tree->memPool.leafPool) {
-        fprintf(stderr, "Failed to allocate memory pools\n");
-        exit(1);
+// Fraction of a row's branch length still to grow in this frame
+static float Tree3DGetGrowFraction(const Tree3D *tree, int row) {
+    if (row == tree->CurrentRow && tree->GrowTimer > 0) {
+        return tree->GrowTimer / (float)tree->GrowTime;
     }
-    
-    tree->memPool.branchPoolIndex = 0;
-    tree->memPool.leafPoolIndex = 0;
+    return 0.0f;
 }
 
-void Tree3DInitBatchData(Tree3D *tree) {
-    tree->batchData.capacity = BATCH_SIZE;
-    tree->batchData.positions = (Vector3*)malloc(BATCH_SIZE * 2 * sizeof(Vector3));
-    tree->batchData.widths = (float*)malloc(BATCH_SIZE * 2 * sizeof(float));
-    tree->batchData.colors = (Color*)malloc(BATCH_SIZE * sizeof(Color));
-    
-    if (!tree->batchData.positions || !tree->batchData.widths || !tree->batchData.colors) {
-        fprintf(stderr, "Failed to allocate batch data\n");
-        exit(1);
-    }
-    
-    tree->batchData.count = 0;
+// Last row drawn at a detail tier: the outermost lodSkipRows rows are left out
+static int Tree3DLastLODRow(const Tree3D *tree, int tier) {
+    int last = tree->CurrentRow - tree->lodSkipRows[tier];
+    return last < 0 ? 0 : last;
 }
 
-// Optimized color generation
-Color Tree3DGetColor(unsigned char cs[6]) {
-    static unsigned int lastSeed = 0;
-    unsigned int currentSeed = time(NULL);
+// Spheres drawn for leafPool[index] at a merge factor (see lodLeafMerge):
+// both of its spheres, or one standing in for the merge / 2 leaves from
+// index, or none when the leaf is merged into another. A merged sphere sits
+// at the centroid of the group's spheres and is drawn grown to about their
+// volume; cullRadius, when given, receives a radius that encloses all of
+// them, so culling the merged sphere never drops a leaf it stands for.
+// Returns the sphere count.
+static int Tree3DLeafSpheres(const Tree3D *tree, size_t index, int merge, Vector3 centers[2], float *radius,
+                             float *cullRadius) {
+    const Tree3DLeaf *l = &tree->memPool.leafPool[index];
     
-    if (currentSeed != lastSeed) {
-        srand(currentSeed);
-        lastSeed = currentSeed;
+    if (merge <= 1) {
+        if (!l->isActive) return 0;
+        *radius = l->Radius * tree->Scale;
+        if (cullRadius) *cullRadius = *radius;
+        centers[0] = l->V1;
+        centers[1] = l->V2;
+        return 2;
     }
     
-    return (Color){
-        rand() % (cs[1] - cs[0] + 1) + cs[0],
-        rand() % (cs[3] - cs[2] + 1) + cs[2],
-        rand() % (cs[5] - cs[4] + 1) + cs[4],
-        255
-    };
-}
-
-// Optimized rotation calculation using lookup tables
-Vector3 Tree3DGetRotation(Tree3D *tree, int degX, int degZ) {
-    int indexX = ((degX % 360) + 360) % 360;
-    int indexZ = ((degZ % 360) + 360) % 360;
-    
-    return (Vector3){
-        tree->cosTable[indexZ] * tree->sinTable[indexX],  // X component
-        tree->cosTable[indexX],                           // Y component
-        tree->sinTable[indexZ]                            // Z component
-    };
-}
-// Frustum culling check
-bool Tree3DIsVisible(const Tree3D *tree, Vector3 point, Camera3D camera) {
-    // Simple distance-based culling
-    float distSq = Vector3DistanceSqr(camera.position, point);
-    if (distSq > 10000.0f) return false;
+    size_t stride = (size_t)(merge / 2);
+    if (stride > 1 && index % stride != 0) return 0;
+    size_t end = index + stride < tree->memPool.leafPoolIndex ? index + stride : tree->memPool.leafPoolIndex;
     
-    // Simplified bounding check for now
-    return (point.x >= tree->bounds.min.x && point.x <= tree->bounds.max.x &&
-            point.y >= tree->bounds.min.y && point.y <= tree->bounds.max.y &&
-            point.z >= tree->bounds.min.z && point.z <= tree->bounds.max.z);
-}
-int Tree3DGetLODLevel(const Tree3D *tree, Vector3 position, Camera3D camera) {
-    float distance = Vector3Distance(camera.position, position);
+    Vector3 sum = {0.0f, 0.0f, 0.0f};
+    float leafRadius = 0.0f;
+    int active = 0;
+    for (size_t i = index; i < end; i++) {
+        const Tree3DLeaf *g = &tree->memPool.leafPool[i];
+        if (!g->isActive) continue;
+        sum = Vector3Add(sum, Vector3Add(g->V1, g->V2));
+        leafRadius = fmaxf(leafRadius, g->Radius * tree->Scale);
+        active++;
+    }
+    if (active == 0) return 0;
     
-    for (int i = 0; i < LOD_LEVELS; i++) {
-        if (distance <= tree->lodDistances[i]) {
-            return tree->lodLevels[i];
+    centers[0] = Vector3Scale(sum, 0.5f / (float)active);
+    *radius = leafRadius * sqrtf((float)merge);
+    if (cullRadius) {
+        float bound = *radius;
+        for (size_t i = index; i < end; i++) {
+            const Tree3DLeaf *g = &tree->memPool.leafPool[i];
+            if (!g->isActive) continue;
+            float r = g->Radius * tree->Scale;
+            bound = fmaxf(bound, Vector3Distance(centers[0], g->V1) + r);
+            bound = fmaxf(bound, Vector3Distance(centers[0], g->V2) + r);
         }
+        *cullRadius = bound;
     }
-    
-    return tree->lodLevels[LOD_LEVELS - 1];
+    return 1;
 }
 
-// Branch and Growth Functions
-void Tree3DAppendRow(Tree3D *tree) {
-    if (tree->CurrentRow + 1 < tree->AllocatedRows) {
-        tree->BranchCount[tree->CurrentRow + 1] = 0;
+// Frustum test for the spheres of `count` leaves from leafPool[first];
+// visible[2k] and visible[2k + 1] flag leaf k's spheres
+static void Tree3DCullLeaves(const Tree3D *tree, const Tree3DFrustum *frustum, int first, int count,
+                             int merge, bool contained, unsigned char *visible) {
+    for (int k = 0; k < count; k++) {
+        Vector3 centers[2];
+        float radius, cullRadius;
+        int spheres = Tree3DLeafSpheres(tree, (size_t)(first + k), merge, centers, &radius,
+                                        contained ? NULL : &cullRadius);
+        for (int j = 0; j < 2; j++) {
+            visible[k * 2 + j] = j < spheres &&
+                (contained || Tree3DFrustumContainsSphere(frustum, centers[j], cullRadius));
+        }
     }
 }
 
-Tree3DBranch* Tree3DGetNextBranch(Tree3D *tree) {
-    if (!tree || !tree->memPool.branchPool) {
-        return NULL;
-    }
-    
-    if (tree->memPool.branchPoolIndex >= MAX_ROWS * MAX_BRANCHES_PER_ROW) {
-        fprintf(stderr, "Branch pool exhausted\n");
-        return NULL;
-    }
-    
-    Tree3DBranch* branch = &tree->memPool.branchPool[tree->memPool.branchPoolIndex++];
-    return branch;
+// Whether a tier draws canopy blobs, rebuilding them if leaves were added.
+// Canopy tiers leave the baked mesh out and draw their rows from the trunk.
+static bool Tree3DUseCanopy(Tree3D *tree, int tier) {
+    if (!tree->lodCanopy[tier]) return false;
+    if (tree->canopyLeaves != tree->LeafCount) Tree3DBuildCanopy(tree);
+    return true;
 }
 
+// The baked mesh holds its rows and leaves at full detail, so only tiers
+// that leave nothing out draw it; coarser tiers draw every row themselves
+static bool Tree3DUseBakedMesh(const Tree3D *tree, int tier) {
+    return tree->useBakedMesh && !tree->lodCanopy[tier] &&
+           tree->lodSkipRows[tier] <= 0 && tree->lodLeafMerge[tier] <= 1;
+}
 
-Tree3DLeaf* Tree3DGetNextLeaf(Tree3D *tree) {
-    if (tree->memPool.leafPoolIndex >= MAX_LEAVES) {
-        return NULL;
-    }
-    return &tree->memPool.leafPool[tree->memPool.leafPoolIndex++];
+static bool Tree3DCanopyBlobVisible(const Tree3DFrustum *frustum, const Tree3DCanopyBlob *blob) {
+    float bound = fmaxf(blob->radii.x, fmaxf(blob->radii.y, blob->radii.z));
+    return Tree3DFrustumContainsSphere(frustum, blob->center, bound);
 }
 
+typedef struct {
+    const Tree3DFrustum *frustum;
+    Tree3DInstanceData *data;
+    int leafMerge;
+} Tree3DCollectContext;
 
-void Tree3DAppendBranch(Tree3D *tree, int row, Tree3DBranch branch) {
-    if (!tree || !tree->Branches || !tree->BranchCount) {
-        fprintf(stderr, "Tree not properly initialized\n");
-        return;
-    }
-    
-    if (row >= MAX_ROWS || row < 0) {
-        fprintf(stderr, "Invalid row index: %d\n", row);
-        return;
-    }
+static void Tree3DCollectBranches(Tree3D *tree, int row, int first, int count, bool contained, void *ctx) {
+    Tree3DCollectContext *c = (Tree3DCollectContext*)ctx;
+    const Tree3DBranchStreams *s = &tree->memPool.branches;
+    float grow = Tree3DGetGrowFraction(tree, row);
+    unsigned char visible[TREE3D_CULL_CHUNK];
+    TREE_STATS_TIMER(timer);
     
-    if (tree->BranchCount[row] >= MAX_BRANCHES_PER_ROW) {
-        fprintf(stderr, "Too many branches in row %d\n", row);
-        return;
+    for (int i = 0; i < count; i += TREE3D_CULL_CHUNK) {
+        int n = count - i < TREE3D_CULL_CHUNK ? count - i : TREE3D_CULL_CHUNK;
+        size_t b = Tree3DBranchIndex(tree, row, first + i);
+        TREE_STATS_START(tree3dFrameStats, timer);
+        int visibleCount = Tree3DCullBranches(c->frustum, s, b, n, grow, contained, visible);
+        TREE_STATS_LAP(tree3dFrameStats, timer, cullUs);
+        if (visibleCount == 0) continue;
+        
+        c->data->branchCount += Tree3DBranchInstances(s, b, n, grow, visible,
+                                                      c->data->branchTransforms + c->data->branchCount);
+        TREE_STATS_LAP(tree3dFrameStats, timer, batchUs);
+        TREE_STATS_ADD(tree3dFrameStats, branchesDrawn, visibleCount);
     }
+}
+
+static void Tree3DCollectLeaves(Tree3D *tree, int row, int first, int count, bool contained, void *ctx) {
+    Tree3DCollectContext *c = (Tree3DCollectContext*)ctx;
+    unsigned char visible[2 * TREE3D_CULL_CHUNK];
+    TREE_STATS_TIMER(timer);
+    (void)row;
     
-    Tree3DBranch* newBranch = Tree3DGetNextBranch(tree);
-    if (!newBranch) {
-        fprintf(stderr, "Failed to get new branch\n");
-        return;
+    for (int i = 0; i < count; i += TREE3D_CULL_CHUNK) {
+        int n = count - i < TREE3D_CULL_CHUNK ? count - i : TREE3D_CULL_CHUNK;
+        TREE_STATS_START(tree3dFrameStats, timer);
+        Tree3DCullLeaves(tree, c->frustum, first + i, n, c->leafMerge, contained, visible);
+        TREE_STATS_LAP(tree3dFrameStats, timer, cullUs);
+        
+        for (int k = 0; k < n; k++) {
+            Vector3 centers[2];
+            float radius;
+            size_t leaf = (size_t)(first + i + k);
+            int spheres = Tree3DLeafSpheres(tree, leaf, c->leafMerge, centers, &radius, NULL);
+            for (int j = 0; j < spheres; j++) {
+                if (!visible[k * 2 + j]) continue;
+                c->data->leafTransforms[c->data->leafCount++] =
+                    Tree3DLeafTransform(centers[j], radius, tree->memPool.leafPool[leaf].Color);
+                TREE_STATS_ADD(tree3dFrameStats, leavesDrawn, 1);
+            }
+        }
+        TREE_STATS_LAP(tree3dFrameStats, timer, batchUs);
     }
-    
-    *newBranch = branch;
-    newBranch->isActive = true;
-    tree->Branches[row][tree->BranchCount[row]] = newBranch;
-    tree->BranchCount[row]++;
-    tree->needsBoundsUpdate = true;
 }
 
-void Tree3DAppendLeaf(Tree3D *tree, Tree3DLeaf leaf) {
-    if (tree->LeafCount >= MAX_LEAVES) {
-        return;
-    }
-    
-    Tree3DLeaf* newLeaf = Tree3DGetNextLeaf(tree);
-    if (!newLeaf) return;
+// Canopy blobs in the frustum as leaf instances
+static void Tree3DCollectCanopy(Tree3D *tree, const Tree3DFrustum *frustum, Tree3DInstanceData *data) {
+    TREE_STATS_TIMER(timer);
+    TREE_STATS_START(tree3dFrameStats, timer);
     
-    *newLeaf = leaf;
-    newLeaf->isActive = true;
-    tree->LeafCount++;
+    for (int i = 0; i < tree->canopyCount; i++) {
+        const Tree3DCanopyBlob *blob = &tree->canopy[i];
+        if (!Tree3DCanopyBlobVisible(frustum, blob)) continue;
+        data->leafTransforms[data->leafCount++] = Tree3DEllipsoidTransform(blob->center, blob->radii, blob->color);
+        TREE_STATS_ADD(tree3dFrameStats, leavesDrawn, 1);
+    }
+    TREE_STATS_LAP(tree3dFrameStats, timer, batchUs);
 }
 
-void Tree3DAddBranch(Tree3D *tree, int degX, int degZ, Tree3DBranch *branch) {
-    float w = branch->Width * 0.9f;
-    float h = branch->Height * 0.95f;
-    Vector3 pos = branch->V2;
-    Vector3 rot = Tree3DGetRotation(tree, degX, degZ);
+static void Tree3DCollectTier(Tree3D *tree, const Tree3DFrustum *frustum, int tier, Tree3DInstanceData *data) {
+    bool canopy = Tree3DUseCanopy(tree, tier);
+    int firstRow = 0, firstLeaf = 0;
+    if (Tree3DUseBakedMesh(tree, tier)) Tree3DGetDynamicRange(tree, &firstRow, &firstLeaf);
+    int lastRow = Tree3DLastLODRow(tree, tier);
     
-    Vector3 newPos = {
-        pos.x + rot.x * h * tree->Scale,
-        pos.y + rot.y * h * tree->Scale,
-        pos.z + rot.z * h * tree->Scale
-    };
+    int branches = 0;
+    for (int i = firstRow; i <= lastRow; i++) branches += tree->BranchCount[i];
+    data->branchTransforms = Tree3DReserveInstances(data->branchTransforms, &data->branchCapacity,
+                                                    data->branchCount + branches);
+    data->leafTransforms = Tree3DReserveInstances(data->leafTransforms, &data->leafCapacity,
+                                                  data->leafCount + (canopy ? tree->canopyCount
+                                                                            : (tree->LeafCount - firstLeaf) * 2));
     
-    Tree3DBranch newBranch = {
-        .V1 = pos,
-        .V2 = newPos,
-        .Width = w,
-        .Height = h,
-        .Color = Tree3DGetColor(tree->CsBranch),
-        .DegX = degX,
-        .DegZ = degZ,
-        .isActive = true
-    };
+    // Leaves on skipped rows are kept: they are most of the canopy
+    Tree3DCollectContext ctx = {frustum, data, tree->lodLeafMerge[tier]};
+    for (int i = firstRow; i <= tree->CurrentRow && i < tree->bvh.builtRows; i++) {
+        if (i <= lastRow) {
+            Tree3DCullVisit(tree, frustum, tree->bvh.rowBranchRoot[i], i, Tree3DCollectBranches, &ctx);
+        }
+        if (!canopy) {
+            Tree3DCullVisit(tree, frustum, tree->bvh.rowLeafRoot[i], i, Tree3DCollectLeaves, &ctx);
+        }
+    }
+    if (canopy) Tree3DCollectCanopy(tree, frustum, data);
+}
 
-    Tree3DAppendBranch(tree, tree->CurrentRow + 1, newBranch);
+// Append the visible branches and leaves of a tree to an instance buffer at
+// full detail. Several trees may share one buffer so a whole forest draws in
+// two calls. Rows already in the baked mesh are skipped.
+void Tree3DCollectInstances(Tree3D *tree, const Tree3DFrustum *frustum, Tree3DInstanceData *data) {
+    Tree3DCollectTier(tree, frustum, 0, data);
+}
 
-    // Leaf generation with optimized random check
-    float leafChance = ((float)rand() / RAND_MAX) * tree->CurrentRow / tree->MaxRow;
-    if (leafChance > tree->LeafChance) {
-        Vector3 rotLeaf = Tree3DGetRotation(tree, degX * 2, degZ * 2);
-        Vector3 leafOffset = {
-            rotLeaf.x * w,
-            rotLeaf.y * w,
-            rotLeaf.z * w
-        };
-        
-        Tree3DLeaf newLeaf = {
-            .Row = tree->CurrentRow,
-            .Radius = w,
-            .V1 = {
-                newPos.x + leafOffset.x,
-                newPos.y + leafOffset.y,
-                newPos.z + leafOffset.z
-            },
-            .V2 = {
-                newPos.x - leafOffset.x,
-                newPos.y - leafOffset.y,
-                newPos.z - leafOffset.z
-            },
-            .Color = Tree3DGetColor(tree->CsLeaf),
-            .isActive = true
-        };
-        
-        Tree3DAppendLeaf(tree, newLeaf);
+// Queue a tree's impostor quad behind the instances
+static void Tree3DQueueImpostor(Tree3DInstanceData *data, Tree3DImpostorInstance instance) {
+    if (data->impostorCount >= data->impostorCapacity) {
+        int newCapacity = data->impostorCapacity > 0 ? data->impostorCapacity * 2 : 256;
+        Tree3DImpostorInstance *grown = (Tree3DImpostorInstance*)TREE3D_REALLOC(
+            data->impostors, newCapacity * sizeof(Tree3DImpostorInstance));
+        if (!grown) {
+            fprintf(stderr, "Failed to allocate instance data\n");
+            exit(1);
+        }
+        data->impostors = grown;
+        data->impostorCapacity = newCapacity;
     }
+    data->impostors[data->impostorCount++] = instance;
+}
 
-    // Update bounds
-    if (newPos.x < tree->MinX) tree->MinX = newPos.x;
-    if (newPos.x > tree->MaxX) tree->MaxX = newPos.x + w;
-    if (newPos.z < tree->MinZ) tree->MinZ = newPos.z;
-    if (newPos.z > tree->MaxZ) tree->MaxZ = newPos.z + w;
+static int Tree3DCompareImpostors(const void *a, const void *b) {
+    uintptr_t x = (uintptr_t)((const Tree3DImpostorInstance*)a)->impostor;
+    uintptr_t y = (uintptr_t)((const Tree3DImpostorInstance*)b)->impostor;
+    return (x > y) - (x < y);
 }
 
-void Tree3DUpdateBounds(Tree3D *tree) {
-    if (!tree->needsBoundsUpdate) return;
+// Draw everything queued. Impostors are sorted by atlas first, so raylib
+// batches each species' quads into one draw.
+void Tree3DDrawInstances(Tree3DInstanceData *data) {
+    TREE_STATS_TIMER(timer);
+    TREE_STATS_START(tree3dFrameStats, timer);
     
-    tree->bounds = (BoundingBox){
-        .min = {tree->MinX, tree->Y, tree->MinZ},
-        .max = {tree->MaxX, tree->Y + (tree->Height * tree->Scale * tree->CurrentRow), tree->MaxZ}
-    };
+    if (Tree3DInitRenderer()) {
+        if (data->branchCount > 0) {
+            DrawMeshInstanced(tree3dRenderer.branchMesh, tree3dRenderer.material,
+                              data->branchTransforms, data->branchCount);
+            TREE_STATS_ADD(tree3dFrameStats, drawCalls, 1);
+        }
+        
+        if (data->leafCount > 0) {
+            DrawMeshInstanced(tree3dRenderer.leafMesh, tree3dRenderer.material,
+                              data->leafTransforms, data->leafCount);
+            TREE_STATS_ADD(tree3dFrameStats, drawCalls, 1);
+        }
+    }
     
-    tree->needsBoundsUpdate = false;
+    if (data->impostorCount > 0) {
+        qsort(data->impostors, data->impostorCount, sizeof(Tree3DImpostorInstance), Tree3DCompareImpostors);
+        TreeImpostorBegin();
+        for (int i = 0; i < data->impostorCount; i++) {
+            const Tree3DImpostorInstance *q = &data->impostors[i];
+            TreeImpostorDraw(q->impostor, q->viewer, q->origin, q->scale, WHITE);
+            TREE_STATS_ADD(tree3dFrameStats, drawCalls, i == 0 || q->impostor != q[-1].impostor);
+        }
+        TreeImpostorEnd();
+    }
+    
+    TREE_STATS_LAP(tree3dFrameStats, timer, submitUs);
 }
 
-float Tree3DGetNextPos(Tree3D *tree, float a, float b) {
-    return b + (a - b) * tree->GrowTimer / (float)tree->GrowTime;
+typedef struct {
+    const Tree3DFrustum *frustum;
+    int slices;
+    int leafMerge;
+} Tree3DImmediateContext;
+
+static void Tree3DFlushBatch(Tree3D *tree, int sides) {
+    for (int k = 0; k < tree->batchData.count; k++) {
+        DrawCylinderEx(
+            tree->batchData.positions[k * 2],
+            tree->batchData.positions[k * 2 + 1],
+            tree->batchData.widths[k * 2],
+            tree->batchData.widths[k * 2 + 1],
+            sides,
+            tree->batchData.colors[k]
+        );
+    }
+    TREE_STATS_ADD(tree3dFrameStats, branchesDrawn, tree->batchData.count);
+    TREE_STATS_ADD(tree3dFrameStats, drawCalls, tree->batchData.count);
+    tree->batchData.count = 0;
 }
-void Tree3DGrow(Tree3D *tree) {
-    if (tree->CurrentRow >= tree->MaxRow) return;
 
-    Tree3DAppendRow(tree);
-    int prevRow = tree->CurrentRow;
-    for (int i = 0; i < tree->BranchCount[prevRow]; i++) {
-        Tree3DBranch *b = tree->Branches[prevRow][i];
-        if (!b || !b->isActive) continue;
-
-        int split = rand() % 100;
-        if (tree->SplitChance > split) {
-            // Two branches with optimized angle calculation
-            int angleX1 = tree->SplitAngle[0] + (rand() % (tree->SplitAngle[1] - tree->SplitAngle[0]));
-            int angleZ1 = tree->SplitAngle[0] + (rand() % (tree->SplitAngle[1] - tree->SplitAngle[0]));
-            
-            // Randomly choose split direction (X, Z, or both)
-            int splitType = rand() % 3;  // 0 = X, 1 = Z, 2 = both
+static void Tree3DBatchBranches(Tree3D *tree, int row, int first, int count, bool contained, void *ctx) {
+    Tree3DImmediateContext *c = (Tree3DImmediateContext*)ctx;
+    const Tree3DBranchStreams *s = &tree->memPool.branches;
+    float grow = Tree3DGetGrowFraction(tree, row);
+    unsigned char visible[TREE3D_CULL_CHUNK];
+    TREE_STATS_TIMER(timer);
+    
+    for (int i = 0; i < count; i += TREE3D_CULL_CHUNK) {
+        int n = count - i < TREE3D_CULL_CHUNK ? count - i : TREE3D_CULL_CHUNK;
+        size_t base = Tree3DBranchIndex(tree, row, first + i);
+        TREE_STATS_START(tree3dFrameStats, timer);
+        int visibleCount = Tree3DCullBranches(c->frustum, s, base, n, grow, contained, visible);
+        TREE_STATS_LAP(tree3dFrameStats, timer, cullUs);
+        if (visibleCount == 0) continue;
+        
+        Tree3DInitBatchData(tree);
+        for (int k = 0; k < n; k++) {
+            if (!visible[k]) continue;
+            size_t b = base + k;
+            Vector3 v1 = Tree3DBranchStart(s, b);
+            Vector3 v2 = Tree3DBranchTip(s, b);
+            v2 = Vector3Add(v2, Vector3Scale(Vector3Subtract(v1, v2), grow));
             
-            // First branch is always the same
-            Tree3DAddBranch(tree, b->DegX + angleX1, b->DegZ + angleZ1, b);
+            tree->batchData.positions[tree->batchData.count * 2] = v1;
+            tree->batchData.positions[tree->batchData.count * 2 + 1] = v2;
+            tree->batchData.widths[tree->batchData.count * 2] = s->width[b];
+            tree->batchData.widths[tree->batchData.count * 2 + 1] = s->width[b] * 0.8f;
+            tree->batchData.colors[tree->batchData.count] = s->nodes[b].color;
+            tree->batchData.count++;
             
-            // Second branch mirrors based on split type
-            switch(splitType) {
-                case 0:  // Mirror X only
-                    Tree3DAddBranch(tree, b->DegX - angleX1, b->DegZ + angleZ1, b);
-                    break;
-                case 1:  // Mirror Z only
-                    Tree3DAddBranch(tree, b->DegX + angleX1, b->DegZ - angleZ1, b);
-                    break;
-                case 2:  // Mirror both
-                    Tree3DAddBranch(tree, b->DegX - angleX1, b->DegZ - angleZ1, b);
-                    break;
+            if (tree->batchData.count >= BATCH_SIZE) {
+                // Draw batch using raylib's batch drawing
+                TREE_STATS_LAP(tree3dFrameStats, timer, batchUs);
+                Tree3DFlushBatch(tree, c->slices);
+                TREE_STATS_LAP(tree3dFrameStats, timer, submitUs);
             }
-        } else {
-            // Single branch with slight variation
-            int angleX = (rand() % 21) - 10;
-            int angleZ = (rand() % 21) - 10;
-            Tree3DAddBranch(tree, b->DegX + angleX, b->DegZ + angleZ, b);
         }
+        TREE_STATS_LAP(tree3dFrameStats, timer, batchUs);
     }
+}
+
+static void Tree3DDrawLeaves(Tree3D *tree, int row, int first, int count, bool contained, void *ctx) {
+    Tree3DImmediateContext *c = (Tree3DImmediateContext*)ctx;
+    unsigned char visible[2 * TREE3D_CULL_CHUNK];
+    TREE_STATS_TIMER(timer);
+    (void)row;
+    
+    for (int i = 0; i < count; i += TREE3D_CULL_CHUNK) {
+        int n = count - i < TREE3D_CULL_CHUNK ? count - i : TREE3D_CULL_CHUNK;
+        TREE_STATS_START(tree3dFrameStats, timer);
+        Tree3DCullLeaves(tree, c->frustum, first + i, n, c->leafMerge, contained, visible);
+        TREE_STATS_LAP(tree3dFrameStats, timer, cullUs);
         
-    tree->CurrentRow++;
-    tree->needsBoundsUpdate = true;
+        for (int k = 0; k < n; k++) {
+            Vector3 centers[2];
+            float radius;
+            size_t leaf = (size_t)(first + i + k);
+            int spheres = Tree3DLeafSpheres(tree, leaf, c->leafMerge, centers, &radius, NULL);
+            for (int j = 0; j < spheres; j++) {
+                if (!visible[k * 2 + j]) continue;
+                DrawSphere(centers[j], radius, tree->memPool.leafPool[leaf].Color);
+                TREE_STATS_ADD(tree3dFrameStats, leavesDrawn, 1);
+                TREE_STATS_ADD(tree3dFrameStats, drawCalls, 1);
+            }
+        }
+        TREE_STATS_LAP(tree3dFrameStats, timer, submitUs);
+    }
 }
 
-void Tree3DLoad(Tree3D *tree) {
-    if (!tree || !tree->Branches || !tree->BranchCount) {
-        fprintf(stderr, "Tree not properly initialized\n");
-        return;
+// Canopy blobs drawn as spheres of the same volume
+static void Tree3DDrawCanopy(Tree3D *tree, const Tree3DFrustum *frustum) {
+    for (int i = 0; i < tree->canopyCount; i++) {
+        const Tree3DCanopyBlob *blob = &tree->canopy[i];
+        if (!Tree3DCanopyBlobVisible(frustum, blob)) continue;
+        DrawSphere(blob->center, cbrtf(blob->radii.x * blob->radii.y * blob->radii.z), blob->color);
+        TREE_STATS_ADD(tree3dFrameStats, leavesDrawn, 1);
+        TREE_STATS_ADD(tree3dFrameStats, drawCalls, 1);
     }
+}
 
-    tree->CurrentRow = 0;
-    tree->memPool.branchPoolIndex = 0;
-    tree->memPool.leafPoolIndex = 0;
-    tree->LeafCount = 0;
-    
-    memset(tree->BranchCount, 0, MAX_ROWS * sizeof(int));
-    
-    Tree3DBranch initialBranch = {
-        .V1 = {tree->X, tree->Y, tree->Z},
-        .V2 = {tree->X, tree->Y + (tree->Height * tree->Scale), tree->Z},
-        .Width = tree->Width * tree->Scale,
-        .Height = tree->Height * tree->Scale,
-        .Color = Tree3DGetColor(tree->CsBranch),
-        .DegX = 0,
-        .DegZ = 0,
-        .isActive = true
-    };
+// Whether the tree can be drawn as its impostor: one is baked and the tree
+// has finished growing, so the views match its shape
+bool Tree3DHasImpostor(const Tree3D *tree) {
+    return tree->impostor && tree->impostor->views > 0 && tree->impostor->height > 0.0f &&
+           tree->CurrentRow >= tree->MaxRow;
+}
 
-    Tree3DAppendBranch(tree, 0, initialBranch);
-    tree->GrowTimer = tree->GrowTime;
+// Queue the tree's impostor on shared, or draw it straight away. Copies
+// are scaled by their height against the baked tree's.
+static void Tree3DDrawImpostor(Tree3D *tree, Camera3D camera, Tree3DInstanceData *shared) {
+    Tree3DImpostorInstance instance = {
+        tree->impostor,
+        {tree->X, tree->Y, tree->Z},
+        camera.position,
+        (tree->bounds.max.y - tree->Y) / tree->impostor->height
+    };
     
-    if (tree->RandomRow) {
-        int targetRow = rand() % tree->MaxRow;
-        while (tree->CurrentRow < targetRow) {
-            Tree3DGrow(tree);
-        }
+    if (shared) {
+        Tree3DQueueImpostor(shared, instance);
+        return;
     }
     
-    tree->needsBoundsUpdate = true;
+    TreeImpostorBegin();
+    TreeImpostorDraw(instance.impostor, instance.viewer, instance.origin, instance.scale, WHITE);
+    TreeImpostorEnd();
+    TREE_STATS_ADD(tree3dFrameStats, drawCalls, 1);
 }
 
-void Tree3DUpdate(Tree3D *tree) {
-    if (tree->CurrentRow >= tree->MaxRow) return;
-
-    if (tree->GrowTimer > 0) {
-        tree->GrowTimer--;
-        tree->growthState.needsUpdate = true;
+// Detail tier of a tree from the height its bounding sphere covers on screen:
+// the first lodScreenSizes entry it reaches, the last tier below them all,
+// or TREE3D_LOD_IMPOSTOR below impostorScreenSize when Tree3DHasImpostor
+int Tree3DSelectLOD(Tree3D *tree, Camera3D camera) {
+    Tree3DUpdateBounds(tree);
+    
+    Vector3 center = Vector3Scale(Vector3Add(tree->bounds.min, tree->bounds.max), 0.5f);
+    float radius = 0.5f * Vector3Distance(tree->bounds.min, tree->bounds.max);
+    float screenHeight = (float)GetScreenHeight();
+    float pixels;
+    
+    if (camera.projection == CAMERA_ORTHOGRAPHIC) {
+        pixels = 2.0f * radius / camera.fovy * screenHeight;
+    } else {
+        float distance = Vector3Distance(camera.position, center);
+        if (distance <= radius) return 0;
+        pixels = radius / (distance * tanf(camera.fovy * 0.5f * (float)DEG_TO_RAD)) * screenHeight;
     }
-
-    if (tree->GrowTimer == 0) {
-        Tree3DGrow(tree);
-        tree->GrowTimer = tree->GrowTime;
+    
+    if (pixels < tree->impostorScreenSize && Tree3DHasImpostor(tree)) return TREE3D_LOD_IMPOSTOR;
+    
+    for (int i = 0; i < LOD_LEVELS; i++) {
+        if (pixels >= tree->lodScreenSizes[i]) return i;
     }
+    return LOD_LEVELS - 1;
 }
 
-void Tree3DBatchDraw(Tree3D *tree, Camera3D camera) {
-    tree->batchData.count = 0;
+// Returns the tier drawn, -1 when the whole tree was culled
+static int Tree3DDrawTree(Tree3D *tree, Camera3D camera, const Tree3DFrustum *frustum,
+                          int lodLevel, Tree3DInstanceData *shared) {
+    TREE_STATS_TIMER(timer);
+    TREE_STATS_START(tree3dFrameStats, timer);
+    Tree3DUpdateBounds(tree);
     
-    for (int i = 0; i <= tree->CurrentRow; i++) {
-        for (int j = 0; j < tree->BranchCount[i]; j++) {
-            Tree3DBranch *b = tree->Branches[i][j];
-            if (!b || !b->isActive) continue;
-            
-            Vector3 v2 = b->V2;
-            if (i == tree->CurrentRow && tree->GrowTimer > 0) {
-                v2 = (Vector3){
-                    Tree3DGetNextPos(tree, b->V1.x, v2.x),
-                    Tree3DGetNextPos(tree, b->V1.y, v2.y),
-                    Tree3DGetNextPos(tree, b->V1.z, v2.z)
-                };
-            }
-            
-            if (!Tree3DIsVisible(tree, b->V1, camera) && !Tree3DIsVisible(tree, v2, camera)) {
-                continue;
-            }
-            
-            int lodLevel = Tree3DGetLODLevel(tree, b->V1, camera);
-            
-            tree->batchData.positions[tree->batchData.count * 2] = b->V1;
-            tree->batchData.positions[tree->batchData.count * 2 + 1] = v2;
-            tree->batchData.widths[tree->batchData.count * 2] = b->Width;
-            tree->batchData.widths[tree->batchData.count * 2 + 1] = b->Width * 0.8f;
-            tree->batchData.colors[tree->batchData.count] = b->Color;
-            tree->batchData.count++;
-            
-            if (tree->batchData.count >= BATCH_SIZE) {
-                // Draw batch using raylib's batch drawing
-                for (int k = 0; k < tree->batchData.count; k++) {
-                    DrawCylinderEx(
-                        tree->batchData.positions[k * 2],
-                        tree->batchData.positions[k * 2 + 1],
-                        tree->batchData.widths[k * 2],
-                        tree->batchData.widths[k * 2 + 1],
-                        lodLevel,
-                        tree->batchData.colors[k]
-                    );
-                }
-                tree->batchData.count = 0;
-            }
+    // Reject the whole tree before any branch is visited
+    bool visible = Tree3DFrustumContainsBox(frustum, tree->bounds);
+    TREE_STATS_LAP(tree3dFrameStats, timer, cullUs);
+    if (!visible) return -1;
+    
+    int tier = (lodLevel >= 0 && lodLevel <= TREE3D_LOD_IMPOSTOR) ? lodLevel : Tree3DSelectLOD(tree, camera);
+    if (tier == TREE3D_LOD_IMPOSTOR) {
+        if (Tree3DHasImpostor(tree)) {
+            Tree3DDrawImpostor(tree, camera, shared);
+            TREE_STATS_LAP(tree3dFrameStats, timer, submitUs);
+            return tier;
         }
+        tier = LOD_LEVELS - 1;
     }
+    bool canopy = Tree3DUseCanopy(tree, tier);
+    bool baked = Tree3DUseBakedMesh(tree, tier) && Tree3DInitRenderer();
     
-    // Draw remaining batch
-    if (tree->batchData.count > 0) {
-        for (int k = 0; k < tree->batchData.count; k++) {
-            DrawCylinderEx(
-                tree->batchData.positions[k * 2],
-                tree->batchData.positions[k * 2 + 1],
-                tree->batchData.widths[k * 2],
-                tree->batchData.widths[k * 2 + 1],
-                8,
-                tree->batchData.colors[k]
-            );
+    int firstRow = 0, firstLeaf = 0;
+    if (baked) Tree3DGetDynamicRange(tree, &firstRow, &firstLeaf);
+    
+    if (baked) {
+        Tree3DDrawBakedMesh(tree);
+        TREE_STATS_LAP(tree3dFrameStats, timer, submitUs);
+        TREE_STATS_ADD(tree3dFrameStats, branchesDrawn, firstRow <= tree->CurrentRow
+                       ? (long)tree->RowOffsets[firstRow] : (long)tree->memPool.branchPoolIndex);
+        TREE_STATS_ADD(tree3dFrameStats, leavesDrawn, firstLeaf * 2);
+    }
+    
+    if (tree->renderMode == TREE3D_RENDER_INSTANCED && Tree3DInitRenderer()) {
+        if (shared) {
+            Tree3DCollectTier(tree, frustum, tier, shared);
+            return tier;
         }
+        Tree3DClearInstanceData(&tree->instanceData);
+        Tree3DCollectTier(tree, frustum, tier, &tree->instanceData);
+        Tree3DDrawInstances(&tree->instanceData);
+        return tier;
     }
     
-    // Draw leaves
-    for (int i = 0; i < tree->LeafCount; i++) {
-        Tree3DLeaf *l = &tree->memPool.leafPool[i];
-        if (!l->isActive) continue;
+    Tree3DImmediateContext ctx = {frustum, tree->lodLevels[tier], tree->lodLeafMerge[tier]};
+    int lastRow = Tree3DLastLODRow(tree, tier);
+    tree->batchData.count = 0;
+    
+    for (int i = firstRow; i <= lastRow && i < tree->bvh.builtRows; i++) {
+        Tree3DCullVisit(tree, frustum, tree->bvh.rowBranchRoot[i], i, Tree3DBatchBranches, &ctx);
+    }
+    
+    // Draw remaining batch
+    TREE_STATS_START(tree3dFrameStats, timer);
+    Tree3DFlushBatch(tree, ctx.slices);
+    TREE_STATS_LAP(tree3dFrameStats, timer, submitUs);
+    
+    if (canopy) {
+        TREE_STATS_START(tree3dFrameStats, timer);
+        Tree3DDrawCanopy(tree, frustum);
+        TREE_STATS_LAP(tree3dFrameStats, timer, submitUs);
+        return tier;
+    }
+    
+    // Draw leaves, including those on skipped rows
+    for (int i = firstRow; i <= tree->CurrentRow && i < tree->bvh.builtRows; i++) {
+        Tree3DCullVisit(tree, frustum, tree->bvh.rowLeafRoot[i], i, Tree3DDrawLeaves, &ctx);
+    }
+    return tier;
+}
+
+// Draw a tree against a frustum computed by the caller. lodLevel forces a
+// detail tier (TREE3D_LOD_IMPOSTOR falls back to the last level for a tree
+// without a usable impostor), or -1 picks one with Tree3DSelectLOD. When shared is given,
+// instanced geometry is appended to it and the caller draws it once for
+// many trees.
+void Tree3DDrawFrustum(Tree3D *tree, Camera3D camera, const Tree3DFrustum *frustum,
+                       int lodLevel, Tree3DInstanceData *shared) {
+#ifdef TREE_STATS
+    TreeFrameStats *stats = tree3dFrameStats;
+    if (stats) {
+        long considered = (long)tree->memPool.branchPoolIndex;
+        long drawn = stats->branchesDrawn;
+        stats->branchesConsidered += considered;
         
-        if ((int)l->Row < tree->CurrentRow && 
-            !(i == tree->CurrentRow && tree->GrowTimer > 0)) {
-            if (Tree3DIsVisible(tree, l->V1, camera)) {
-                DrawSphere(l->V1, l->Radius * tree->Scale, l->Color);
-            }
-            if (Tree3DIsVisible(tree, l->V2, camera)) {
-                DrawSphere(l->V2, l->Radius * tree->Scale, l->Color);
-            }
-        }
+        int tier = Tree3DDrawTree(tree, camera, frustum, lodLevel, shared);
+        
+        // Branches left out by the tier count as culled
+        stats->branchesCulled += considered - (stats->branchesDrawn - drawn);
+        if (tier >= 0) stats->lodHistogram[tier]++;
+        return;
     }
+#endif
+    Tree3DDrawTree(tree, camera, frustum, lodLevel, shared);
+}
+
+void Tree3DBatchDraw(Tree3D *tree, Camera3D camera) {
+    TREE_ZONE_BEGIN(tree3dZones, "Tree3DBatchDraw");
+    Tree3DFrustum frustum = Tree3DGetCameraFrustum(camera, Tree3DGetScreenAspect(), tree->cullDistance);
+    Tree3DDrawFrustum(tree, camera, &frustum, -1, NULL);
+    TREE_ZONE_END(tree3dZones, "Tree3DBatchDraw");
 }
 void Tree3DDraw(Tree3D *tree, Camera3D camera) {
     if (tree->needsBoundsUpdate) {
@@ -580,48 +3573,53 @@ void Tree3DDraw(Tree3D *tree, Camera3D camera) {
     }
     Tree3DBatchDraw(tree, camera);
 }
-Tree3D Tree3DNewTree() {
-    Tree3D tree = {0};
+
+// Impostor Baking
+static void Tree3DDrawImpostorView(Camera3D camera, void *user) {
+    Tree3D *tree = (Tree3D*)user;
+    Tree3DFrustum frustum = Tree3DGetCameraFrustum(camera, 1.0f, 2.0f * camera.fovy);
+    Tree3DDrawFrustum(tree, camera, &frustum, 0, NULL);
+}
+
+// Render views of a fully grown tree at full detail into impostor, to be
+// shared through Tree3D.impostor by every tree of its species. Needs a GL
+// context; see TreeImpostorBake.
+bool Tree3DBakeImpostor(Tree3D *tree, TreeImpostor *impostor, int views, int cellSize) {
+    Tree3DUpdateBounds(tree);
+    return TreeImpostorBake(impostor, tree->bounds, (Vector3){tree->X, tree->Y, tree->Z},
+                            views, cellSize, Tree3DDrawImpostorView, tree);
+}
+
+// Chunk Geometry
+// Append the tree in world space at the coarsest detail: the rows of the
+// last tier as open prisms at full length and canopy blobs for the leaves.
+// Growth animation is left out; the chunk is rebuilt when a row is added.
+void Tree3DAppendToChunk(Tree3D *tree, TreeChunkMesh *chunk) {
+    const Tree3DBranchStreams *s = &tree->memPool.branches;
+    int lastRow = Tree3DLastLODRow(tree, LOD_LEVELS - 1);
     
-    // Allocate BranchCount array
-    tree.BranchCount = (int*)malloc(MAX_ROWS * sizeof(int));
-    if (!tree.BranchCount) {
-        fprintf(stderr, "Failed to allocate BranchCount array\n");
-        exit(1);
+    for (int i = 0; i <= lastRow && i < tree->AllocatedRows; i++) {
+        for (int j = 0; j < tree->BranchCount[i]; j++) {
+            size_t b = Tree3DBranchIndex(tree, i, j);
+            TreeChunkAddTube(chunk, Tree3DBranchStart(s, b), Tree3DBranchTip(s, b),
+                             s->width[b], s->width[b] * TREE3D_BRANCH_TAPER, s->nodes[b].color);
+        }
     }
-    memset(tree.BranchCount, 0, MAX_ROWS * sizeof(int));
     
-    // Allocate three levels of pointers
-    tree.Branches = (Tree3DBranch***)malloc(MAX_ROWS * sizeof(Tree3DBranch**));
-    if (!tree.Branches) {
-        fprintf(stderr, "Failed to allocate Branches array\n");
-        free(tree.BranchCount);
-        exit(1);
+    if (tree->canopyLeaves != tree->LeafCount) Tree3DBuildCanopy(tree);
+    for (int i = 0; i < tree->canopyCount; i++) {
+        TreeChunkAddBlob(chunk, tree->canopy[i].center, tree->canopy[i].radii, tree->canopy[i].color);
     }
     
-    for (int i = 0; i < MAX_ROWS; i++) {
-        tree.Branches[i] = (Tree3DBranch**)malloc(MAX_BRANCHES_PER_ROW * sizeof(Tree3DBranch*));
-        if (!tree.Branches[i]) {
-            for (int j = 0; j < i; j++) {
-                free(tree.Branches[j]);
-            }
-            free(tree.Branches);
-            free(tree.BranchCount);
-            fprintf(stderr, "Failed to allocate row %d\n", i);
-            exit(1);
-        }
-        for (int j = 0; j < MAX_BRANCHES_PER_ROW; j++) {
-            tree.Branches[i][j] = NULL;
-        }
-    }
+    chunk->objects++;
+    chunk->dirty = true;
+}
+
+Tree3D Tree3DNewTree() {
+    Tree3D tree = {0};
     
     Tree3DInitMemoryPool(&tree);
-    Tree3DInitTrigTables(&tree);
-    Tree3DInitBatchData(&tree);
-    
-    tree.AllocatedRows = MAX_ROWS;
-    tree.AllocatedBranchesPerRow = MAX_BRANCHES_PER_ROW;
-    tree.AllocatedLeaves = MAX_LEAVES;
+    Tree3DInitInstanceData(&tree.instanceData);
     
     tree.LeafChance = 0.5f;
     tree.MaxRow = 10;
@@ -640,14 +3638,30 @@ Tree3D Tree3DNewTree() {
     tree.CsLeaf[2] = 190; tree.CsLeaf[3] = 230;
     tree.CsLeaf[4] = 159; tree.CsLeaf[5] = 178;
     
-    tree.lodDistances[0] = 10.0f;
-    tree.lodDistances[1] = 30.0f;
-    tree.lodDistances[2] = 60.0f;
+    tree.cullDistance = TREE3D_CULL_FAR;
+    
+    tree.lodScreenSizes[0] = 160.0f;
+    tree.lodScreenSizes[1] = 60.0f;
+    tree.lodScreenSizes[2] = 0.0f;
     
     tree.lodLevels[0] = 8;
     tree.lodLevels[1] = 6;
     tree.lodLevels[2] = 4;
     
+    tree.lodSkipRows[0] = 0;
+    tree.lodSkipRows[1] = 2;
+    tree.lodSkipRows[2] = 4;
+    
+    tree.lodLeafMerge[0] = 1;
+    tree.lodLeafMerge[1] = 2;
+    tree.lodLeafMerge[2] = 8;
+    
+    tree.lodCanopy[2] = true;
+    tree.impostorScreenSize = 24.0f;
+    
+    tree.renderMode = TREE3D_RENDER_INSTANCED;
+    tree.useBakedMesh = true;
+    
     tree.MinX = 9999999.0f;
     tree.MaxX = -9999999.0f;
     tree.MinZ = 9999999.0f;
@@ -691,55 +3705,57 @@ Tree3D Tree3DNewJungleTree(float x, float y, float z) {
 void Tree3DFree(Tree3D *tree) {
     if (!tree) return;
     
-    if (tree->Branches) {
-        for (int i = 0; i < tree->AllocatedRows; i++) {
-            if (tree->Branches[i]) {
-                free(tree->Branches[i]);
-            }
-        }
-        free(tree->Branches);
-        tree->Branches = NULL;
+    if (tree->RowOffsets) {
+        Tree3DDealloc(tree, tree->RowOffsets);
+        tree->RowOffsets = NULL;
     }
 
     if (tree->BranchCount) {
-        free(tree->BranchCount);
+        Tree3DDealloc(tree, tree->BranchCount);
         tree->BranchCount = NULL;
     }
     
-    if (tree->memPool.branchPool) {
-        free(tree->memPool.branchPool);
-        tree->memPool.branchPool = NULL;
+    Tree3DFreeBranchPool(tree);
+    
+    if (tree->depthOrder) {
+        Tree3DDealloc(tree, tree->depthOrder);
+        tree->depthOrder = NULL;
     }
+    tree->depthOrderCount = tree->depthOrderCapacity = 0;
     
     if (tree->memPool.leafPool) {
-        free(tree->memPool.leafPool);
+        Tree3DDealloc(tree, tree->memPool.leafPool);
         tree->memPool.leafPool = NULL;
     }
     
-    if (tree->sinTable) {
-        free(tree->sinTable);
-        tree->sinTable = NULL;
-    }
-    
-    if (tree->cosTable) {
-        free(tree->cosTable);
-        tree->cosTable = NULL;
+    if (tree->canopy) {
+        Tree3DDealloc(tree, tree->canopy);
+        tree->canopy = NULL;
     }
+    tree->canopyCount = tree->canopyCapacity = tree->canopyLeaves = 0;
     
     if (tree->batchData.positions) {
-        free(tree->batchData.positions);
+        Tree3DDealloc(tree, tree->batchData.positions);
         tree->batchData.positions = NULL;
     }
     
     if (tree->batchData.widths) {
-        free(tree->batchData.widths);
+        Tree3DDealloc(tree, tree->batchData.widths);
         tree->batchData.widths = NULL;
     }
     
     if (tree->batchData.colors) {
-        free(tree->batchData.colors);
+        Tree3DDealloc(tree, tree->batchData.colors);
         tree->batchData.colors = NULL;
     }
+    tree->batchData.count = tree->batchData.capacity = 0;
+    
+    tree->memPool = (Tree3DMemoryPool){0};
+    tree->AllocatedRows = tree->AllocatedBranches = tree->AllocatedLeaves = 0;
+    
+    Tree3DFreeInstanceData(&tree->instanceData);
+    Tree3DFreeBakedMesh(tree);
+    Tree3DFreeBVH(tree);
 }
 
 
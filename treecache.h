@@ -0,0 +1,305 @@
+#ifndef TREECACHE_H
+#define TREECACHE_H
+
+#include "tree3d.h"
+#include "rlgl.h"
+
+// Define TREECACHE_IMPLEMENTATION (together with TREE3D_IMPLEMENTATION) in
+// ONE source file to include the implementation
+
+// Shared grown trees. Trees with the same generation parameters and seed
+// grow the same branches, so the cache grows each distinct tree once, at
+// the origin, and hands out placements that hold only a pointer to it and a
+// position. Memory and growth time scale with the number of distinct trees
+// rather than the number placed.
+
+// Configuration Macros
+#ifndef TREE3D_CACHE_BLOCK_SIZE
+#define TREE3D_CACHE_BLOCK_SIZE (1024 * 1024)
+#endif
+
+// Pre-declare structures
+typedef struct Tree3DCacheKey Tree3DCacheKey;
+typedef struct Tree3DCacheEntry Tree3DCacheEntry;
+typedef struct Tree3DCache Tree3DCache;
+typedef struct Tree3DCachedTree Tree3DCachedTree;
+
+// Every field that changes what Tree3DLoad and Tree3DGrow produce. Position
+// is left out: a Seed of 0 is grown as at the origin, so all seed-0 trees
+// with the same parameters share one.
+struct Tree3DCacheKey {
+    uint64_t seed;
+    float leafChance;
+    float scale;
+    float width;
+    float height;
+    int32_t maxRow;
+    int32_t splitChance;
+    int32_t splitAngle[2];
+    unsigned char csBranch[6];
+    unsigned char csLeaf[6];
+};
+
+// One distinct tree, fully grown and baked at the origin. Its branches,
+// leaves, canopy and bounds never change once grown, but drawing writes
+// the rest: the batch and instance scratch are refilled on every draw and
+// the baked mesh is uploaded on the first. No draw reads what an earlier
+// one left, so placements drawn with different cameras do not affect each
+// other.
+struct Tree3DCacheEntry {
+    Tree3DCacheKey key;
+    uint64_t hash;
+    Tree3D tree;
+    int placements;         // Tree3DCachePlace calls that returned it
+};
+
+struct Tree3DCache {
+    Tree3DCacheEntry **entries;     // Individually allocated, so pointers into them stay valid
+    int count;
+    int capacity;
+    int *slots;                     // Open-addressed by hash, -1 when empty
+    int slotCount;                  // Power of two
+    int hits;
+    int misses;
+    Tree3DArena *arena;             // Storage of every cached tree
+};
+
+// A placed tree: the shared tree and where to draw it
+struct Tree3DCachedTree {
+    Tree3D *tree;
+    Vector3 position;
+};
+
+// Function Declarations
+Tree3DCache Tree3DCacheNew(void);
+Tree3DCacheKey Tree3DCacheMakeKey(const Tree3D *tree);
+Tree3D* Tree3DCacheGet(Tree3DCache *cache, const Tree3D *tree);
+Tree3D* Tree3DCacheGetSeeded(Tree3DCache *cache, const Tree3D *tree, uint64_t seed);
+Tree3DCachedTree Tree3DCachePlace(Tree3DCache *cache, const Tree3D *tree, Vector3 position);
+void Tree3DCacheDraw(const Tree3DCachedTree *placed, Camera3D camera);
+void Tree3DCacheDrawAt(Tree3D *tree, Vector3 position, float yaw, Camera3D camera);
+BoundingBox Tree3DCacheGetBounds(const Tree3DCachedTree *placed);
+void Tree3DCacheFree(Tree3DCache *cache);
+
+#ifdef TREECACHE_IMPLEMENTATION
+
+Tree3DCache Tree3DCacheNew(void) {
+    Tree3DCache cache = {0};
+    cache.arena = Tree3DArenaCreate(TREE3D_CACHE_BLOCK_SIZE);
+    return cache;
+}
+
+// Padding is zeroed so keys can be hashed and compared bytewise
+Tree3DCacheKey Tree3DCacheMakeKey(const Tree3D *tree) {
+    Tree3DCacheKey key;
+    memset(&key, 0, sizeof(key));
+    key.seed = tree->Seed;
+    key.leafChance = tree->LeafChance;
+    key.scale = tree->Scale;
+    key.width = tree->Width;
+    key.height = tree->Height;
+    key.maxRow = tree->MaxRow;
+    key.splitChance = tree->SplitChance;
+    key.splitAngle[0] = tree->SplitAngle[0];
+    key.splitAngle[1] = tree->SplitAngle[1];
+    memcpy(key.csBranch, tree->CsBranch, sizeof(key.csBranch));
+    memcpy(key.csLeaf, tree->CsLeaf, sizeof(key.csLeaf));
+    return key;
+}
+
+// The key eight bytes at a time, each word mixed in with the splitmix64 finalizer
+static uint64_t Tree3DCacheHash(const Tree3DCacheKey *key) {
+    const unsigned char *bytes = (const unsigned char*)key;
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < sizeof(*key); i += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        size_t n = sizeof(*key) - i < sizeof(word) ? sizeof(*key) - i : sizeof(word);
+        memcpy(&word, bytes + i, n);
+        h ^= word;
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+static int Tree3DCacheFind(const Tree3DCache *cache, const Tree3DCacheKey *key, uint64_t hash) {
+    if (cache->slotCount == 0) return -1;
+
+    int mask = cache->slotCount - 1;
+    for (int i = (int)(hash & (uint64_t)mask); cache->slots[i] >= 0; i = (i + 1) & mask) {
+        const Tree3DCacheEntry *entry = cache->entries[cache->slots[i]];
+        if (entry->hash == hash && memcmp(&entry->key, key, sizeof(*key)) == 0) {
+            return cache->slots[i];
+        }
+    }
+    return -1;
+}
+
+static void Tree3DCacheInsertSlot(Tree3DCache *cache, int index) {
+    int mask = cache->slotCount - 1;
+    int i = (int)(cache->entries[index]->hash & (uint64_t)mask);
+    while (cache->slots[i] >= 0) i = (i + 1) & mask;
+    cache->slots[i] = index;
+}
+
+// Keep the table at most half full
+static void Tree3DCacheReserve(Tree3DCache *cache, int needed) {
+    if (needed > cache->capacity) {
+        int newCapacity = cache->capacity > 0 ? cache->capacity * 2 : 16;
+        while (newCapacity < needed) newCapacity *= 2;
+        Tree3DCacheEntry **entries = (Tree3DCacheEntry**)TREE3D_REALLOC(cache->entries,
+                                                                        newCapacity * sizeof(Tree3DCacheEntry*));
+        if (!entries) {
+            fprintf(stderr, "Failed to allocate tree cache\n");
+            exit(1);
+        }
+        cache->entries = entries;
+        cache->capacity = newCapacity;
+    }
+
+    if (needed * 2 <= cache->slotCount) return;
+
+    int slotCount = cache->slotCount > 0 ? cache->slotCount * 2 : 32;
+    while (needed * 2 > slotCount) slotCount *= 2;
+    int *slots = (int*)TREE3D_MALLOC(slotCount * sizeof(int));
+    if (!slots) {
+        fprintf(stderr, "Failed to allocate tree cache\n");
+        exit(1);
+    }
+    TREE3D_FREE(cache->slots);
+    cache->slots = slots;
+    cache->slotCount = slotCount;
+    memset(slots, 0xFF, slotCount * sizeof(int));
+    for (int i = 0; i < cache->count; i++) Tree3DCacheInsertSlot(cache, i);
+}
+
+// Grow a configured tree to its last row at the origin, baked and with its
+// canopy and bounds settled, so drawing never changes it. It grows on the
+// heap and only its final storage moves into the arena, which cannot
+// reclaim the pools a growing tree outgrows.
+static void Tree3DCacheGrow(Tree3DCache *cache, Tree3D *tree) {
+    tree->X = tree->Y = tree->Z = 0.0f;
+    tree->RandomRow = false;
+    tree->allocator = NULL;
+
+    Tree3DLoad(tree);
+    while (tree->CurrentRow < tree->MaxRow) Tree3DGrow(tree);
+    tree->GrowTimer = 0;
+    if (tree->useBakedMesh) Tree3DBakeRows(tree, tree->CurrentRow + 1);
+    if (tree->canopyLeaves != tree->LeafCount) Tree3DBuildCanopy(tree);
+    Tree3DUpdateBounds(tree);
+    Tree3DMoveStorage(tree, &cache->arena->allocator);
+}
+
+// The tree is only copied on a miss, so lookups with a species' parameters
+// and a seed of their own stay cheap
+static Tree3DCacheEntry* Tree3DCacheLookup(Tree3DCache *cache, const Tree3D *tree, uint64_t seed) {
+    Tree3DCacheKey key = Tree3DCacheMakeKey(tree);
+    key.seed = seed;
+    uint64_t hash = Tree3DCacheHash(&key);
+
+    int index = Tree3DCacheFind(cache, &key, hash);
+    if (index >= 0) {
+        cache->hits++;
+        return cache->entries[index];
+    }
+
+    Tree3DCacheReserve(cache, cache->count + 1);
+    Tree3DCacheEntry *entry = (Tree3DCacheEntry*)TREE3D_MALLOC(sizeof(Tree3DCacheEntry));
+    if (!entry) {
+        fprintf(stderr, "Failed to allocate tree cache entry\n");
+        exit(1);
+    }
+    entry->key = key;
+    entry->hash = hash;
+    entry->tree = *tree;
+    entry->tree.Seed = seed;
+    entry->placements = 0;
+    Tree3DCacheGrow(cache, &entry->tree);
+
+    index = cache->count++;
+    cache->entries[index] = entry;
+    Tree3DCacheInsertSlot(cache, index);
+    cache->misses++;
+    return entry;
+}
+
+// The shared, fully grown tree for a configured, not yet loaded tree's
+// parameters and seed, grown on first request. Drawing settings (LOD tables, render mode,
+// impostor) are taken from the first request. The returned tree belongs to
+// the cache and stays valid until Tree3DCacheFree; change nothing but what
+// drawing changes.
+Tree3D* Tree3DCacheGet(Tree3DCache *cache, const Tree3D *tree) {
+    return &Tree3DCacheLookup(cache, tree, tree->Seed)->tree;
+}
+
+// Tree3DCacheGet with `seed` in place of the tree's own Seed
+Tree3D* Tree3DCacheGetSeeded(Tree3DCache *cache, const Tree3D *tree, uint64_t seed) {
+    return &Tree3DCacheLookup(cache, tree, seed)->tree;
+}
+
+// Place a tree with the given parameters and seed at a position, sharing
+// the grown tree with every other placement of the same key
+Tree3DCachedTree Tree3DCachePlace(Tree3DCache *cache, const Tree3D *tree, Vector3 position) {
+    Tree3DCacheEntry *entry = Tree3DCacheLookup(cache, tree, tree->Seed);
+    entry->placements++;
+    return (Tree3DCachedTree){&entry->tree, position};
+}
+
+// World-space bounds of a placement
+BoundingBox Tree3DCacheGetBounds(const Tree3DCachedTree *placed) {
+    BoundingBox box = placed->tree->bounds;
+    box.min = Vector3Add(box.min, placed->position);
+    box.max = Vector3Add(box.max, placed->position);
+    return box;
+}
+
+// World to tree space for a tree turned `yaw` degrees about +Y (the
+// inverse of rlRotatef(yaw, 0, 1, 0))
+static Vector3 Tree3DCacheToLocal(Vector3 v, float s, float c) {
+    return (Vector3){c * v.x - s * v.z, v.y, s * v.x + c * v.z};
+}
+
+// Draw a shared tree at a position, turned `yaw` degrees about the vertical
+// axis. The tree is culled and its detail tier picked against the camera
+// moved into its space, and the geometry is moved back with the rlgl
+// transform, so the tree's own position and bounds are left as grown. The
+// draw still writes the tree's scratch (see Tree3DCacheEntry).
+void Tree3DCacheDrawAt(Tree3D *tree, Vector3 position, float yaw, Camera3D camera) {
+    float s = sinf(yaw * DEG2RAD);
+    float c = cosf(yaw * DEG2RAD);
+    Camera3D local = camera;
+    local.position = Tree3DCacheToLocal(Vector3Subtract(camera.position, position), s, c);
+    local.target = Tree3DCacheToLocal(Vector3Subtract(camera.target, position), s, c);
+    local.up = Tree3DCacheToLocal(camera.up, s, c);
+
+    rlPushMatrix();
+    rlTranslatef(position.x, position.y, position.z);
+    if (yaw != 0.0f) rlRotatef(yaw, 0.0f, 1.0f, 0.0f);
+    Tree3DBatchDraw(tree, local);
+    rlPopMatrix();
+}
+
+void Tree3DCacheDraw(const Tree3DCachedTree *placed, Camera3D camera) {
+    Tree3DCacheDrawAt(placed->tree, placed->position, 0.0f, camera);
+}
+
+void Tree3DCacheFree(Tree3DCache *cache) {
+    if (!cache) return;
+
+    // GPU meshes and scratch go per tree, pool storage with the arena
+    for (int i = 0; i < cache->count; i++) {
+        Tree3DFree(&cache->entries[i]->tree);
+        TREE3D_FREE(cache->entries[i]);
+    }
+    Tree3DArenaDestroy(cache->arena);
+    TREE3D_FREE(cache->entries);
+    TREE3D_FREE(cache->slots);
+    *cache = (Tree3DCache){0};
+}
+
+#endif // TREECACHE_IMPLEMENTATION
+#endif // TREECACHE_H
@@ -0,0 +1,183 @@
+#ifndef TREECHUNK_H
+#define TREECHUNK_H
+
+#include <raylib.h>
+#include "raymath.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Merged far geometry shared by tree3d.h, bush3d.h and forest3d.h. Many
+// objects append coarse triangles in world space to one chunk mesh, which is
+// uploaded once and drawn with a single DrawMesh, so a far hillside costs
+// one draw instead of one per tree.
+
+// Configuration Macros
+#ifndef TREE_CHUNK_TUBE_SIDES
+#define TREE_CHUNK_TUBE_SIDES 3
+#endif
+
+#ifndef TREE_CHUNK_BLOB_RINGS
+#define TREE_CHUNK_BLOB_RINGS 3
+#endif
+
+#ifndef TREE_CHUNK_BLOB_SLICES
+#define TREE_CHUNK_BLOB_SLICES 4
+#endif
+
+#ifndef TREE_CHUNK_REALLOC
+#define TREE_CHUNK_REALLOC(ptr, size) realloc(ptr, size)
+#endif
+
+#ifndef TREE_CHUNK_FREE
+#define TREE_CHUNK_FREE(ptr) free(ptr)
+#endif
+
+// Non-indexed triangles with vertex colors. The CPU copy is kept so the
+// chunk can be cleared and refilled when its contents change.
+typedef struct TreeChunkMesh {
+    float *vertices;
+    unsigned char *colors;
+    int vertexCount;
+    int capacity;
+    int objects;        // Trees and bushes appended since the last clear
+    bool dirty;         // The CPU copy differs from the uploaded mesh
+    Mesh mesh;
+} TreeChunkMesh;
+
+static inline void TreeChunkClear(TreeChunkMesh *chunk) {
+    chunk->vertexCount = 0;
+    chunk->objects = 0;
+    chunk->dirty = true;
+}
+
+static inline void TreeChunkReserve(TreeChunkMesh *chunk, int needed) {
+    if (needed <= chunk->capacity) return;
+
+    int newCapacity = chunk->capacity > 0 ? chunk->capacity : 1024;
+    while (newCapacity < needed) newCapacity *= 2;
+
+    float *vertices = (float*)TREE_CHUNK_REALLOC(chunk->vertices, newCapacity * 3 * sizeof(float));
+    if (vertices) chunk->vertices = vertices;
+    unsigned char *colors = (unsigned char*)TREE_CHUNK_REALLOC(chunk->colors, newCapacity * 4 * sizeof(unsigned char));
+    if (colors) chunk->colors = colors;
+
+    if (!vertices || !colors) {
+        fprintf(stderr, "Failed to allocate chunk mesh\n");
+        exit(1);
+    }
+
+    chunk->capacity = newCapacity;
+}
+
+static inline void TreeChunkEmit(TreeChunkMesh *chunk, Vector3 v, Color color) {
+    int i = chunk->vertexCount++;
+    chunk->vertices[i * 3] = v.x;
+    chunk->vertices[i * 3 + 1] = v.y;
+    chunk->vertices[i * 3 + 2] = v.z;
+    chunk->colors[i * 4] = color.r;
+    chunk->colors[i * 4 + 1] = color.g;
+    chunk->colors[i * 4 + 2] = color.b;
+    chunk->colors[i * 4 + 3] = color.a;
+}
+
+// Open prism of TREE_CHUNK_TUBE_SIDES sides from start to end
+static inline void TreeChunkAddTube(TreeChunkMesh *chunk, Vector3 start, Vector3 end,
+                                    float startRadius, float endRadius, Color color) {
+    Vector3 dir = Vector3Subtract(end, start);
+    if (Vector3Length(dir) <= 0.0f) return;
+    dir = Vector3Normalize(dir);
+    Vector3 ref = (fabsf(dir.y) < 0.99f) ? (Vector3){0.0f, 1.0f, 0.0f} : (Vector3){1.0f, 0.0f, 0.0f};
+    Vector3 u = Vector3Normalize(Vector3CrossProduct(dir, ref));
+    Vector3 w = Vector3CrossProduct(dir, u);
+
+    TreeChunkReserve(chunk, chunk->vertexCount + TREE_CHUNK_TUBE_SIDES * 6);
+    for (int i = 0; i < TREE_CHUNK_TUBE_SIDES; i++) {
+        float a0 = (2.0f * PI * i) / TREE_CHUNK_TUBE_SIDES;
+        float a1 = (2.0f * PI * (i + 1)) / TREE_CHUNK_TUBE_SIDES;
+        Vector3 r0 = Vector3Add(Vector3Scale(u, cosf(a0)), Vector3Scale(w, sinf(a0)));
+        Vector3 r1 = Vector3Add(Vector3Scale(u, cosf(a1)), Vector3Scale(w, sinf(a1)));
+
+        Vector3 b0 = Vector3Add(start, Vector3Scale(r0, startRadius));
+        Vector3 b1 = Vector3Add(start, Vector3Scale(r1, startRadius));
+        Vector3 t0 = Vector3Add(end, Vector3Scale(r0, endRadius));
+        Vector3 t1 = Vector3Add(end, Vector3Scale(r1, endRadius));
+
+        TreeChunkEmit(chunk, b0, color);
+        TreeChunkEmit(chunk, b1, color);
+        TreeChunkEmit(chunk, t1, color);
+
+        TreeChunkEmit(chunk, b0, color);
+        TreeChunkEmit(chunk, t1, color);
+        TreeChunkEmit(chunk, t0, color);
+    }
+}
+
+// Coarse axis-aligned ellipsoid of TREE_CHUNK_BLOB_RINGS x TREE_CHUNK_BLOB_SLICES quads
+static inline void TreeChunkAddBlob(TreeChunkMesh *chunk, Vector3 center, Vector3 radii, Color color) {
+    TreeChunkReserve(chunk, chunk->vertexCount + TREE_CHUNK_BLOB_RINGS * TREE_CHUNK_BLOB_SLICES * 6);
+    for (int i = 0; i < TREE_CHUNK_BLOB_RINGS; i++) {
+        float p0 = PI * i / TREE_CHUNK_BLOB_RINGS - PI / 2.0f;
+        float p1 = PI * (i + 1) / TREE_CHUNK_BLOB_RINGS - PI / 2.0f;
+        for (int j = 0; j < TREE_CHUNK_BLOB_SLICES; j++) {
+            float a0 = (2.0f * PI * j) / TREE_CHUNK_BLOB_SLICES;
+            float a1 = (2.0f * PI * (j + 1)) / TREE_CHUNK_BLOB_SLICES;
+            Vector3 v00 = {cosf(p0) * cosf(a0), sinf(p0), cosf(p0) * sinf(a0)};
+            Vector3 v01 = {cosf(p0) * cosf(a1), sinf(p0), cosf(p0) * sinf(a1)};
+            Vector3 v10 = {cosf(p1) * cosf(a0), sinf(p1), cosf(p1) * sinf(a0)};
+            Vector3 v11 = {cosf(p1) * cosf(a1), sinf(p1), cosf(p1) * sinf(a1)};
+            v00 = Vector3Add(center, Vector3Multiply(v00, radii));
+            v01 = Vector3Add(center, Vector3Multiply(v01, radii));
+            v10 = Vector3Add(center, Vector3Multiply(v10, radii));
+            v11 = Vector3Add(center, Vector3Multiply(v11, radii));
+
+            TreeChunkEmit(chunk, v00, color);
+            TreeChunkEmit(chunk, v11, color);
+            TreeChunkEmit(chunk, v01, color);
+
+            TreeChunkEmit(chunk, v00, color);
+            TreeChunkEmit(chunk, v10, color);
+            TreeChunkEmit(chunk, v11, color);
+        }
+    }
+}
+
+static inline void TreeChunkUnloadGPU(TreeChunkMesh *chunk) {
+    if (chunk->mesh.vaoId > 0) UnloadMesh(chunk->mesh);
+    chunk->mesh = (Mesh){0};
+}
+
+// Upload the chunk if it changed, then draw it in world space. Returns
+// whether anything was drawn.
+static inline bool TreeChunkDraw(TreeChunkMesh *chunk, Material material) {
+    if (chunk->dirty) {
+        TreeChunkUnloadGPU(chunk);
+        if (chunk->vertexCount > 0) {
+            chunk->mesh.vertexCount = chunk->vertexCount;
+            chunk->mesh.triangleCount = chunk->vertexCount / 3;
+            chunk->mesh.vertices = chunk->vertices;
+            chunk->mesh.colors = chunk->colors;
+            UploadMesh(&chunk->mesh, false);
+
+            // The CPU copy stays owned by the chunk so it can be refilled
+            chunk->mesh.vertices = NULL;
+            chunk->mesh.colors = NULL;
+        }
+        chunk->dirty = false;
+    }
+
+    if (chunk->mesh.vaoId == 0) return false;
+    DrawMesh(chunk->mesh, material, MatrixIdentity());
+    return true;
+}
+
+static inline void TreeChunkFree(TreeChunkMesh *chunk) {
+    if (!chunk) return;
+    TreeChunkUnloadGPU(chunk);
+    TREE_CHUNK_FREE(chunk->vertices);
+    TREE_CHUNK_FREE(chunk->colors);
+    *chunk = (TreeChunkMesh){0};
+}
+
+#endif // TREECHUNK_H
@@ -0,0 +1,203 @@
+#ifndef TREEIMPOSTOR_H
+#define TREEIMPOSTOR_H
+
+#include <raylib.h>
+#include "raymath.h"
+#include <math.h>
+#include <stdbool.h>
+
+// Billboard impostors shared by tree3d.h and bush3d.h. A few views around
+// the vertical axis are rendered once into one atlas texture; far away an
+// object is then drawn as a single quad turned toward the viewer, showing
+// the view taken from the nearest angle. Baking renders through raylib
+// render textures, so it needs a GL context (a hidden window on a software
+// renderer is enough) and must run outside BeginTextureMode.
+
+// Configuration Macros
+#ifndef TREE_IMPOSTOR_MAX_VIEWS
+#define TREE_IMPOSTOR_MAX_VIEWS 16
+#endif
+
+// Atlas texels with less alpha are discarded so the quad's empty corners
+// leave no depth behind
+#ifndef TREE_IMPOSTOR_ALPHA_CUTOFF
+#define TREE_IMPOSTOR_ALPHA_CUTOFF "0.5"
+#endif
+
+// Draws the object being baked; called once per view inside BeginMode3D
+typedef void (*TreeImpostorDrawCallback)(Camera3D camera, void *user);
+
+// One object's views. Copies of the object share it and draw it scaled;
+// it is read-only once baked.
+typedef struct TreeImpostor {
+    RenderTexture2D atlas;      // Views left to right by angle, top row first like a loaded image
+    int views;                  // 0 until baked
+    int cellSize;               // Pixels per (square) view
+    float size;                 // World width and height of a view
+    float centerHeight;         // View center above the object's origin
+    float height;               // Top of the baked object above its origin, to scale copies by
+} TreeImpostor;
+
+static inline void TreeImpostorUnload(TreeImpostor *impostor) {
+    if (!impostor) return;
+    if (impostor->atlas.id > 0) UnloadRenderTexture(impostor->atlas);
+    *impostor = (TreeImpostor){0};
+}
+
+// Alpha-tested billboard shader of this translation unit. It belongs to the
+// GL context it was created in, so TreeImpostorUnloadShader must run before
+// that context closes (Tree3DCloseRenderer does so).
+static inline Shader* TreeImpostorShaderSlot(void) {
+    static Shader shader = {0};
+    return &shader;
+}
+
+// The shader, created on first use in the current GL context
+static inline Shader TreeImpostorShader(void) {
+    Shader *shader = TreeImpostorShaderSlot();
+    if (shader->id == 0) {
+        *shader = LoadShaderFromMemory(NULL,
+            "#version 330\n"
+            "in vec2 fragTexCoord;\n"
+            "in vec4 fragColor;\n"
+            "uniform sampler2D texture0;\n"
+            "uniform vec4 colDiffuse;\n"
+            "out vec4 finalColor;\n"
+            "void main() {\n"
+            "    vec4 texel = texture(texture0, fragTexCoord)*colDiffuse*fragColor;\n"
+            "    if (texel.a < " TREE_IMPOSTOR_ALPHA_CUTOFF ") discard;\n"
+            "    finalColor = texel;\n"
+            "}\n");
+    }
+    return *shader;
+}
+
+// Release the shader so the next use builds it again, e.g. in a new window
+static inline void TreeImpostorUnloadShader(void) {
+    Shader *shader = TreeImpostorShaderSlot();
+    if (shader->id > 0) UnloadShader(*shader);
+    *shader = (Shader){0};
+}
+
+// Render `views` views of an object into a fresh atlas of cellSize pixel
+// cells. The views circle the vertical axis through origin (view 0 looks
+// from +Z) and are framed to hold bounds from any angle. A previous atlas
+// is released. Returns false when the render textures cannot be created.
+static inline bool TreeImpostorBake(TreeImpostor *impostor, BoundingBox bounds, Vector3 origin,
+                                    int views, int cellSize, TreeImpostorDrawCallback draw, void *user) {
+    if (views < 1) views = 1;
+    if (views > TREE_IMPOSTOR_MAX_VIEWS) views = TREE_IMPOSTOR_MAX_VIEWS;
+    if (cellSize < 1) return false;
+
+    float dx = fmaxf(fabsf(bounds.min.x - origin.x), fabsf(bounds.max.x - origin.x));
+    float dz = fmaxf(fabsf(bounds.min.z - origin.z), fabsf(bounds.max.z - origin.z));
+    float size = fmaxf(2.0f * sqrtf(dx * dx + dz * dz), bounds.max.y - bounds.min.y);
+    if (!(size > 0.0f)) return false;
+    Vector3 center = {origin.x, 0.5f * (bounds.min.y + bounds.max.y), origin.z};
+
+    RenderTexture2D view = LoadRenderTexture(cellSize, cellSize);
+    RenderTexture2D atlas = LoadRenderTexture(cellSize * views, cellSize);
+    if (view.id == 0 || atlas.id == 0) {
+        if (view.id > 0) UnloadRenderTexture(view);
+        if (atlas.id > 0) UnloadRenderTexture(atlas);
+        return false;
+    }
+
+    BeginTextureMode(atlas);
+    ClearBackground(BLANK);
+    EndTextureMode();
+
+    for (int i = 0; i < views; i++) {
+        float angle = 2.0f * PI * i / views;
+        Camera3D camera = {0};
+        camera.position = Vector3Add(center, (Vector3){sinf(angle) * size, 0.0f, cosf(angle) * size});
+        camera.target = center;
+        camera.up = (Vector3){0.0f, 1.0f, 0.0f};
+        camera.fovy = size;
+        camera.projection = CAMERA_ORTHOGRAPHIC;
+
+        BeginTextureMode(view);
+        ClearBackground(BLANK);
+        BeginMode3D(camera);
+        draw(camera, user);
+        EndMode3D();
+        EndTextureMode();
+
+        // A render texture holds its rows bottom-up; copying it unflipped
+        // stores the view top row first
+        BeginTextureMode(atlas);
+        DrawTextureRec(view.texture, (Rectangle){0.0f, 0.0f, (float)cellSize, (float)cellSize},
+                       (Vector2){(float)(i * cellSize), 0.0f}, WHITE);
+        EndTextureMode();
+    }
+    UnloadRenderTexture(view);
+
+    TreeImpostorUnload(impostor);
+    impostor->atlas = atlas;
+    impostor->views = views;
+    impostor->cellSize = cellSize;
+    impostor->size = size;
+    impostor->centerHeight = center.y - origin.y;
+    impostor->height = bounds.max.y - origin.y;
+    return true;
+}
+
+// View whose angle is nearest the direction from position to viewer
+static inline int TreeImpostorSelectView(const TreeImpostor *impostor, Vector3 position, Vector3 viewer) {
+    float angle = atan2f(viewer.x - position.x, viewer.z - position.z);
+    int view = (int)floorf(angle / (2.0f * PI) * impostor->views + 0.5f);
+    view %= impostor->views;
+    return view < 0 ? view + impostor->views : view;
+}
+
+// Draw a copy of the object standing at origin, `scale` times the baked
+// size, as one quad facing viewer. Wrap runs of these in
+// TreeImpostorBegin/TreeImpostorEnd; quads sharing an atlas batch together.
+static inline void TreeImpostorDraw(const TreeImpostor *impostor, Vector3 viewer, Vector3 origin,
+                                    float scale, Color tint) {
+    if (!impostor || impostor->views == 0) return;
+
+    Vector3 center = {origin.x, origin.y + impostor->centerHeight * scale, origin.z};
+    int view = TreeImpostorSelectView(impostor, center, viewer);
+    float cell = (float)impostor->cellSize;
+    float size = impostor->size * scale;
+
+    // Only the facing of the camera matters: its right vector spans the quad
+    Camera3D facing = {0};
+    facing.position = viewer;
+    facing.target = center;
+    facing.up = (Vector3){0.0f, 1.0f, 0.0f};
+
+    DrawBillboardPro(facing, impostor->atlas.texture, (Rectangle){view * cell, 0.0f, cell, cell},
+                     center, (Vector3){0.0f, 1.0f, 0.0f}, (Vector2){size, size},
+                     (Vector2){0.5f * size, 0.5f * size}, 0.0f, tint);
+}
+
+static inline void TreeImpostorBegin(void) {
+    BeginShaderMode(TreeImpostorShader());
+}
+
+static inline void TreeImpostorEnd(void) {
+    EndShaderMode();
+}
+
+// Fraction of a view's texels the object covers, read back from the GPU.
+// A view of 0 means nothing was rendered into it, so a baked atlas can be
+// checked without a display (e.g. on a software renderer).
+static inline float TreeImpostorViewCoverage(const TreeImpostor *impostor, int view) {
+    if (!impostor || view < 0 || view >= impostor->views) return 0.0f;
+
+    Image image = LoadImageFromTexture(impostor->atlas.texture);
+    if (!image.data) return 0.0f;
+
+    int covered = 0;
+    for (int y = 0; y < impostor->cellSize; y++) {
+        for (int x = 0; x < impostor->cellSize; x++) {
+            if (GetImageColor(image, view * impostor->cellSize + x, y).a > 0) covered++;
+        }
+    }
+    UnloadImage(image);
+    return covered / (float)(impostor->cellSize * impostor->cellSize);
+}
+
+#endif // TREEIMPOSTOR_H
@@ -0,0 +1,820 @@
+#ifndef TREEPACK_H
+#define TREEPACK_H
+
+#include "forest3d.h"
+#include "tree2d.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Define TREEPACK_IMPLEMENTATION (together with the forest3d.h
+// implementations) in ONE source file to include the implementation
+
+// Forest packs: grown Tree3D, Tree and Bush3D data saved once and mapped
+// back in on later runs. Every array sits in the file exactly as it sits in
+// memory and is referenced by its offset from the start of the pack, so a
+// loaded Tree3D points straight into the mapping and nothing is parsed,
+// regrown or copied until the tree changes.
+//
+// Packs are little-endian and record the sizes of the structures and the
+// storage limits they were written with; a pack from a build with a
+// different layout, MAX_ROWS or TREE3D_TRIG_RESOLUTION is refused rather
+// than converted.
+
+// Configuration Macros
+// Arrays start on multiples of this many bytes from the start of the pack
+#ifndef TREEPACK_ALIGN
+#define TREEPACK_ALIGN 32
+#endif
+
+// Packs are mapped with mmap where available; define TREEPACK_NO_MMAP to
+// read them into memory instead
+#if !defined(TREEPACK_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define TREEPACK_MMAP
+#endif
+
+// "TPAK" as a little-endian uint32; reads back differently on a big-endian host
+#define TREEPACK_MAGIC 0x4B415054u
+#define TREEPACK_VERSION 2
+#define TREEPACK_LAYOUT_FIELDS 12
+
+// Pre-declare structures
+typedef struct TreePackHeader TreePackHeader;
+typedef struct TreePackTree3D TreePackTree3D;
+typedef struct TreePackTree TreePackTree;
+typedef struct TreePack TreePack;
+
+// File header at offset 0. Offsets are bytes from the start of the pack.
+struct TreePackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t layout[TREEPACK_LAYOUT_FIELDS];    // Structure sizes and limits, see TreePackLayout
+    uint32_t tree3dCount;
+    uint32_t treeCount;
+    uint32_t bushCount;
+    uint32_t reserved;
+    uint64_t tree3ds;       // TreePackTree3D[tree3dCount]
+    uint64_t trees;         // TreePackTree[treeCount]
+    uint64_t bushes;        // Bush3D[bushCount], impostor pointers cleared
+    uint64_t size;          // Whole pack, to catch truncated files
+};
+
+// One grown Tree3D: its generation fields and where each of its arrays is.
+// Offsets are 0 for empty arrays.
+struct TreePackTree3D {
+    uint64_t seed;
+    uint64_t rngState;
+    uint64_t growKey;
+    float leafChance, scale, width, height;
+    float x, y, z;
+    int32_t maxRow;
+    int32_t currentRow;
+    int32_t generateRow;        // Row still to fast-forward to, see Tree3DLoadBegin
+    int32_t splitChance;
+    int32_t splitAngle[2];
+    int32_t growTimer;
+    int32_t growTime;
+    uint8_t csBranch[6];
+    uint8_t csLeaf[6];
+    int32_t rows;               // Entries in the row tables (AllocatedRows)
+    int32_t branchCount;        // Branch pool entries
+    int32_t leafCount;
+    int32_t depthOrderCount;
+    int32_t canopyCount;
+    int32_t canopyLeaves;
+    int32_t bvhNodeCount;
+    int32_t bvhRows;            // Rows with a hierarchy (builtRows)
+    int32_t bakedVertexCount;
+    int32_t bakedRows;
+    int32_t bakedLeaves;
+    int32_t droppedBranches;
+    int32_t droppedLeaves;
+    BoundingBox bounds;
+    uint64_t rowOffsets;        // int32[rows]
+    uint64_t branchCounts;      // int32[rows]
+    uint64_t x1, y1, z1;        // float[branchCount] each, as Tree3DBranchStreams
+    uint64_t x2, y2, z2;
+    uint64_t branchWidths;
+    uint64_t branchNodes;       // Tree3DBranchNode[branchCount]
+    uint64_t leaves;            // Tree3DLeaf[leafCount]
+    uint64_t depthOrder;        // uint32[depthOrderCount]
+    uint64_t canopy;            // Tree3DCanopyBlob[canopyCount]
+    uint64_t bvhNodes;          // Tree3DBVHNode[bvhNodeCount]
+    uint64_t bvhRowBranchRoot;  // int32[bvhRows]
+    uint64_t bvhRowLeafRoot;    // int32[bvhRows]
+    uint64_t bvhRowBounds;      // BoundingBox[bvhRows]
+    uint64_t bakedVertices;     // float[bakedVertexCount * 3]
+    uint64_t bakedColors;       // uint8[bakedVertexCount * 4]
+};
+
+// One grown Tree. Tree keeps every row at its full MAX_BRANCHES_PER_ROW
+// width, so the pack stores only the branches in use, rows one after
+// another, and TreePackLoadTree copies them out.
+struct TreePackTree {
+    uint64_t seed;
+    uint64_t rngState;
+    float leafChance, width, height;
+    float x, y;
+    float leftX, rightX;
+    int32_t maxRow;
+    int32_t currentRow;
+    int32_t splitChance;
+    int32_t splitAngle[2];
+    int32_t growTimer;
+    int32_t growTime;
+    uint8_t csBranch[6];
+    uint8_t csLeaf[6];
+    uint8_t randomRow;
+    int32_t rows;               // Rows stored, CurrentRow + 1
+    int32_t leafCount;
+    int32_t droppedBranches;
+    int32_t droppedLeaves;
+    uint64_t branchCounts;      // int32[rows]
+    uint64_t branches;          // TreeBranch, sum of branchCounts
+    uint64_t leaves;            // TreeLeaf[leafCount]
+};
+
+// An open pack. Trees loaded from it keep pointing into `data`, so it must
+// outlive them. They allocate through `allocator`: anything grown after
+// loading is copied out of the pack on its first resize, and Tree3DFree
+// skips storage that is still in the pack.
+struct TreePack {
+    unsigned char *data;
+    size_t size;
+    bool mapped;                // data is an mmap view rather than a heap copy
+    const TreePackHeader *header;
+    Tree3DAllocator allocator;
+};
+
+// Function Declarations
+bool TreePackSave(const char *path, const Tree3D *tree3ds, int tree3dCount,
+                  const Tree *trees, int treeCount, const Bush3D *bushes, int bushCount);
+TreePack* TreePackOpen(const char *path);
+void TreePackClose(TreePack *pack);
+int TreePackTree3DCount(const TreePack *pack);
+int TreePackTreeCount(const TreePack *pack);
+int TreePackBushCount(const TreePack *pack);
+bool TreePackLoadTree3D(TreePack *pack, int index, Tree3D *tree);
+bool TreePackLoadTree(const TreePack *pack, int index, Tree *tree);
+Bush3D* TreePackGetBush(TreePack *pack, int index);
+int TreePackAddToForest(TreePack *pack, Tree3DForest *forest);
+
+#ifdef TREEPACK_IMPLEMENTATION
+
+#include <string.h>
+#ifdef TREEPACK_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Everything that changes the meaning of the stored bytes
+static void TreePackLayout(uint32_t layout[TREEPACK_LAYOUT_FIELDS]) {
+    const uint32_t values[TREEPACK_LAYOUT_FIELDS] = {
+        (uint32_t)sizeof(TreePackTree3D),
+        (uint32_t)sizeof(TreePackTree),
+        (uint32_t)sizeof(Tree3DBranchNode),
+        (uint32_t)sizeof(Tree3DLeaf),
+        (uint32_t)sizeof(Tree3DCanopyBlob),
+        (uint32_t)sizeof(Tree3DBVHNode),
+        (uint32_t)sizeof(TreeBranch),
+        (uint32_t)sizeof(TreeLeaf),
+        (uint32_t)sizeof(Bush3D),
+        (uint32_t)MAX_ROWS,
+        (uint32_t)MAX_BRANCHES_PER_ROW,
+        (uint32_t)TREE3D_TRIG_RESOLUTION
+    };
+    memcpy(layout, values, sizeof(values));
+}
+
+static bool TreePackIsLittleEndian(void) {
+    const uint16_t probe = 1;
+    return *(const unsigned char*)&probe == 1;
+}
+
+// Saving
+// Packs are laid out twice with the same calls: once to measure and fill
+// the entry tables, once to write them followed by the arrays.
+typedef struct {
+    FILE *file;         // NULL while measuring
+    uint64_t size;      // Bytes laid out so far
+    bool failed;
+} TreePackWriter;
+
+static uint64_t TreePackAlignOffset(uint64_t offset) {
+    return (offset + TREEPACK_ALIGN - 1) & ~(uint64_t)(TREEPACK_ALIGN - 1);
+}
+
+// Pad to the next aligned offset and return it
+static uint64_t TreePackAlign(TreePackWriter *w) {
+    static const unsigned char padding[TREEPACK_ALIGN] = {0};
+    uint64_t offset = TreePackAlignOffset(w->size);
+    size_t pad = (size_t)(offset - w->size);
+    if (w->file && !w->failed && fwrite(padding, 1, pad, w->file) != pad) w->failed = true;
+    w->size = offset;
+    return offset;
+}
+
+static void TreePackWrite(TreePackWriter *w, const void *data, size_t bytes) {
+    if (w->file && !w->failed && fwrite(data, 1, bytes, w->file) != bytes) w->failed = true;
+    w->size += bytes;
+}
+
+// Place `bytes` of data at the next aligned offset and return it, 0 for nothing
+static uint64_t TreePackPlace(TreePackWriter *w, const void *data, size_t bytes) {
+    if (!data || bytes == 0) return 0;
+
+    uint64_t offset = TreePackAlign(w);
+    TreePackWrite(w, data, bytes);
+    return offset;
+}
+
+static void TreePackPlaceTree3D(TreePackWriter *w, const Tree3D *tree, TreePackTree3D *e) {
+    memset(e, 0, sizeof(*e));
+    e->seed = tree->Seed;
+    e->rngState = tree->rngState;
+    e->growKey = tree->growKey;
+    e->leafChance = tree->LeafChance;
+    e->scale = tree->Scale;
+    e->width = tree->Width;
+    e->height = tree->Height;
+    e->x = tree->X;
+    e->y = tree->Y;
+    e->z = tree->Z;
+    e->maxRow = tree->MaxRow;
+    e->currentRow = tree->CurrentRow;
+    e->generateRow = tree->generateRow;
+    e->splitChance = tree->SplitChance;
+    e->splitAngle[0] = tree->SplitAngle[0];
+    e->splitAngle[1] = tree->SplitAngle[1];
+    e->growTimer = tree->GrowTimer;
+    e->growTime = tree->GrowTime;
+    memcpy(e->csBranch, tree->CsBranch, sizeof(e->csBranch));
+    memcpy(e->csLeaf, tree->CsLeaf, sizeof(e->csLeaf));
+    e->rows = tree->AllocatedRows;
+    e->branchCount = (int32_t)tree->memPool.branchPoolIndex;
+    e->leafCount = tree->LeafCount;
+    e->depthOrderCount = tree->depthOrderCount;
+    e->canopyCount = tree->canopyCount;
+    e->canopyLeaves = tree->canopyLeaves;
+    e->bvhNodeCount = tree->bvh.nodeCount;
+    e->bvhRows = tree->bvh.builtRows;
+    e->bakedVertexCount = tree->baked.vertexCount;
+    e->bakedRows = tree->baked.bakedRows;
+    e->bakedLeaves = tree->baked.bakedLeaves;
+    e->droppedBranches = tree->droppedBranches;
+    e->droppedLeaves = tree->droppedLeaves;
+
+    // The bounds are settled here so the loaded tree never recomputes them
+    Tree3D settled = *tree;
+    Tree3DUpdateBounds(&settled);
+    e->bounds = settled.bounds;
+
+    size_t rows = (size_t)e->rows;
+    size_t branches = (size_t)e->branchCount;
+    const Tree3DBranchStreams *s = &tree->memPool.branches;
+    e->rowOffsets = TreePackPlace(w, tree->RowOffsets, rows * sizeof(int));
+    e->branchCounts = TreePackPlace(w, tree->BranchCount, rows * sizeof(int));
+    e->x1 = TreePackPlace(w, s->x1, branches * sizeof(float));
+    e->y1 = TreePackPlace(w, s->y1, branches * sizeof(float));
+    e->z1 = TreePackPlace(w, s->z1, branches * sizeof(float));
+    e->x2 = TreePackPlace(w, s->x2, branches * sizeof(float));
+    e->y2 = TreePackPlace(w, s->y2, branches * sizeof(float));
+    e->z2 = TreePackPlace(w, s->z2, branches * sizeof(float));
+    e->branchWidths = TreePackPlace(w, s->width, branches * sizeof(float));
+    e->branchNodes = TreePackPlace(w, s->nodes, branches * sizeof(Tree3DBranchNode));
+    e->leaves = TreePackPlace(w, tree->memPool.leafPool, (size_t)e->leafCount * sizeof(Tree3DLeaf));
+    e->depthOrder = TreePackPlace(w, tree->depthOrder, (size_t)e->depthOrderCount * sizeof(uint32_t));
+    e->canopy = TreePackPlace(w, tree->canopy, (size_t)e->canopyCount * sizeof(Tree3DCanopyBlob));
+    e->bvhNodes = TreePackPlace(w, tree->bvh.nodes, (size_t)e->bvhNodeCount * sizeof(Tree3DBVHNode));
+    e->bvhRowBranchRoot = TreePackPlace(w, tree->bvh.rowBranchRoot, (size_t)e->bvhRows * sizeof(int));
+    e->bvhRowLeafRoot = TreePackPlace(w, tree->bvh.rowLeafRoot, (size_t)e->bvhRows * sizeof(int));
+    e->bvhRowBounds = TreePackPlace(w, tree->bvh.rowBounds, (size_t)e->bvhRows * sizeof(BoundingBox));
+    e->bakedVertices = TreePackPlace(w, tree->baked.vertices, (size_t)e->bakedVertexCount * 3 * sizeof(float));
+    e->bakedColors = TreePackPlace(w, tree->baked.colors, (size_t)e->bakedVertexCount * 4);
+}
+
+static void TreePackPlaceTree(TreePackWriter *w, const Tree *tree, TreePackTree *e) {
+    memset(e, 0, sizeof(*e));
+    e->seed = tree->Seed;
+    e->rngState = tree->rngState;
+    e->leafChance = tree->LeafChance;
+    e->width = tree->Width;
+    e->height = tree->Height;
+    e->x = tree->X;
+    e->y = tree->Y;
+    e->leftX = tree->LeftX;
+    e->rightX = tree->RightX;
+    e->maxRow = tree->MaxRow;
+    e->currentRow = tree->CurrentRow;
+    e->splitChance = tree->SplitChance;
+    e->splitAngle[0] = tree->SplitAngle[0];
+    e->splitAngle[1] = tree->SplitAngle[1];
+    e->growTimer = tree->GrowTimer;
+    e->growTime = tree->GrowTime;
+    memcpy(e->csBranch, tree->CsBranch, sizeof(e->csBranch));
+    memcpy(e->csLeaf, tree->CsLeaf, sizeof(e->csLeaf));
+    e->randomRow = tree->RandomRow;
+    e->rows = tree->CurrentRow + 1 < MAX_ROWS ? tree->CurrentRow + 1 : MAX_ROWS;
+    e->leafCount = tree->LeafCount;
+    e->droppedBranches = tree->droppedBranches;
+    e->droppedLeaves = tree->droppedLeaves;
+
+    e->branchCounts = TreePackPlace(w, tree->BranchCount, (size_t)e->rows * sizeof(int));
+    for (int i = 0; i < e->rows; i++) {
+        uint64_t offset = TreePackPlace(w, tree->Branches[i], (size_t)tree->BranchCount[i] * sizeof(TreeBranch));
+        if (!e->branches) e->branches = offset;
+    }
+    e->leaves = TreePackPlace(w, tree->Leaves, (size_t)e->leafCount * sizeof(TreeLeaf));
+}
+
+// Bushes are stored whole and back to back so the pack can hand them out in place
+static uint64_t TreePackPlaceBushes(TreePackWriter *w, const Bush3D *bushes, int count) {
+    if (count <= 0) return 0;
+
+    uint64_t offset = TreePackAlign(w);
+    for (int i = 0; i < count; i++) {
+        Bush3D bush = bushes[i];
+        bush.impostor = NULL;
+        TreePackWrite(w, &bush, sizeof(Bush3D));
+    }
+    return offset;
+}
+
+static void TreePackLayOut(TreePackWriter *w, TreePackHeader *header, TreePackTree3D *entries3d,
+                           const Tree3D *tree3ds, TreePackTree *entries, const Tree *trees,
+                           const Bush3D *bushes) {
+    TreePackPlace(w, header, sizeof(*header));
+    header->tree3ds = TreePackPlace(w, entries3d, header->tree3dCount * sizeof(TreePackTree3D));
+    header->trees = TreePackPlace(w, entries, header->treeCount * sizeof(TreePackTree));
+    for (uint32_t i = 0; i < header->tree3dCount; i++) TreePackPlaceTree3D(w, &tree3ds[i], &entries3d[i]);
+    for (uint32_t i = 0; i < header->treeCount; i++) TreePackPlaceTree(w, &trees[i], &entries[i]);
+    header->bushes = TreePackPlaceBushes(w, bushes, (int)header->bushCount);
+}
+
+// Write grown trees and bushes to a pack at `path`. Trees are stored as they
+// are, partly grown ones included. Returns false if the file could not be
+// written.
+bool TreePackSave(const char *path, const Tree3D *tree3ds, int tree3dCount,
+                  const Tree *trees, int treeCount, const Bush3D *bushes, int bushCount) {
+    if (!TreePackIsLittleEndian()) {
+        fprintf(stderr, "Tree packs are little-endian only\n");
+        return false;
+    }
+
+    TreePackHeader header = {0};
+    header.magic = TREEPACK_MAGIC;
+    header.version = TREEPACK_VERSION;
+    TreePackLayout(header.layout);
+    header.tree3dCount = tree3dCount > 0 ? (uint32_t)tree3dCount : 0;
+    header.treeCount = treeCount > 0 ? (uint32_t)treeCount : 0;
+    header.bushCount = bushCount > 0 ? (uint32_t)bushCount : 0;
+
+    TreePackTree3D *entries3d = (TreePackTree3D*)TREE3D_MALLOC((header.tree3dCount + 1) * sizeof(TreePackTree3D));
+    TreePackTree *entries = (TreePackTree*)TREE3D_MALLOC((header.treeCount + 1) * sizeof(TreePackTree));
+    if (!entries3d || !entries) {
+        fprintf(stderr, "Failed to allocate tree pack entries\n");
+        exit(1);
+    }
+
+    // Measure, then write the finished tables and everything behind them
+    TreePackWriter measure = {0};
+    TreePackLayOut(&measure, &header, entries3d, tree3ds, entries, trees, bushes);
+    header.size = measure.size;
+
+    FILE *file = fopen(path, "wb");
+    bool ok = file != NULL;
+    if (file) {
+        TreePackWriter w = {file, 0, false};
+        TreePackLayOut(&w, &header, entries3d, tree3ds, entries, trees, bushes);
+        ok = !w.failed && w.size == header.size;
+        ok = fclose(file) == 0 && ok;
+    }
+    if (!ok) fprintf(stderr, "Failed to write tree pack %s\n", path);
+
+    TREE3D_FREE(entries3d);
+    TREE3D_FREE(entries);
+    return ok;
+}
+
+// Loading
+static bool TreePackOwns(const TreePack *pack, const void *ptr) {
+    const unsigned char *p = (const unsigned char*)ptr;
+    return p && p >= pack->data && p < pack->data + pack->size;
+}
+
+static void* TreePackAllocate(void *user, size_t size) {
+    (void)user;
+    return TREE3D_MALLOC(size);
+}
+
+// Storage still in the pack is copied out on its first resize
+static void* TreePackReallocate(void *user, void *ptr, size_t oldSize, size_t newSize) {
+    const TreePack *pack = (const TreePack*)user;
+    if (!TreePackOwns(pack, ptr)) return TREE3D_REALLOC(ptr, newSize);
+
+    void *copy = TREE3D_MALLOC(newSize > 0 ? newSize : 1);
+    if (copy) memcpy(copy, ptr, oldSize < newSize ? oldSize : newSize);
+    return copy;
+}
+
+static void TreePackDeallocate(void *user, void *ptr) {
+    const TreePack *pack = (const TreePack*)user;
+    if (!TreePackOwns(pack, ptr)) TREE3D_FREE(ptr);
+}
+
+// Pointer to `bytes` at `offset`, NULL if empty or outside the pack
+static void* TreePackAt(const TreePack *pack, uint64_t offset, size_t bytes) {
+    if (offset == 0 || bytes == 0) return NULL;
+    if (offset % TREEPACK_ALIGN != 0 || offset > pack->size || bytes > pack->size - offset) return NULL;
+    return pack->data + offset;
+}
+
+// An array is valid when present exactly if it is non-empty
+#define TREEPACK_ARRAY(pack, ptr, offset, count, type, ok) do { \
+        size_t bytes_ = (size_t)(count) * sizeof(type); \
+        (ptr) = (type*)TreePackAt(pack, offset, bytes_); \
+        if ((count) < 0 || ((ptr) == NULL) != (bytes_ == 0)) (ok) = false; \
+    } while (0)
+
+static bool TreePackCheckHeader(const TreePackHeader *header, size_t size) {
+    uint32_t layout[TREEPACK_LAYOUT_FIELDS];
+    TreePackLayout(layout);
+
+    if (header->magic != TREEPACK_MAGIC) return false;
+    if (header->version != TREEPACK_VERSION) return false;
+    if (memcmp(header->layout, layout, sizeof(layout)) != 0) return false;
+    if (header->size != size) return false;
+
+    uint64_t tables[3][2] = {
+        {header->tree3ds, header->tree3dCount * (uint64_t)sizeof(TreePackTree3D)},
+        {header->trees, header->treeCount * (uint64_t)sizeof(TreePackTree)},
+        {header->bushes, header->bushCount * (uint64_t)sizeof(Bush3D)}
+    };
+    for (int i = 0; i < 3; i++) {
+        if (tables[i][1] == 0) continue;
+        if (tables[i][0] % TREEPACK_ALIGN != 0 || tables[i][0] > size || tables[i][1] > size - tables[i][0]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Map (or read) the pack at `path` and check its header. Returns NULL, with
+// a message on stderr, if it cannot be opened or was written by a build
+// with another layout.
+TreePack* TreePackOpen(const char *path) {
+    TreePack *pack = (TreePack*)TREE3D_MALLOC(sizeof(TreePack));
+    if (!pack) {
+        fprintf(stderr, "Failed to allocate tree pack\n");
+        exit(1);
+    }
+    memset(pack, 0, sizeof(*pack));
+
+#ifdef TREEPACK_MMAP
+    // A private writable mapping: trees edited in place get their own copy
+    // of the touched pages and the file is never written
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(TreePackHeader)) {
+        void *data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            pack->data = (unsigned char*)data;
+            pack->size = (size_t)st.st_size;
+            pack->mapped = true;
+        }
+    }
+    if (fd >= 0) close(fd);
+#else
+    FILE *file = fopen(path, "rb");
+    if (file) {
+        long size = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+        if (size >= (long)sizeof(TreePackHeader) && fseek(file, 0, SEEK_SET) == 0) {
+            pack->data = (unsigned char*)TREE3D_MALLOC((size_t)size);
+            if (pack->data && fread(pack->data, 1, (size_t)size, file) == (size_t)size) {
+                pack->size = (size_t)size;
+            } else {
+                TREE3D_FREE(pack->data);
+                pack->data = NULL;
+            }
+        }
+        fclose(file);
+    }
+#endif
+
+    if (!pack->data) {
+        fprintf(stderr, "Failed to open tree pack %s\n", path);
+        TREE3D_FREE(pack);
+        return NULL;
+    }
+
+    pack->header = (const TreePackHeader*)pack->data;
+    if (!TreePackIsLittleEndian() || !TreePackCheckHeader(pack->header, pack->size)) {
+        fprintf(stderr, "Tree pack %s was written with another version or layout\n", path);
+        TreePackClose(pack);
+        return NULL;
+    }
+
+    pack->allocator = (Tree3DAllocator){
+        TreePackAllocate, TreePackReallocate, TreePackDeallocate, pack
+    };
+    return pack;
+}
+
+// Release the pack. Trees loaded from it must be freed first.
+void TreePackClose(TreePack *pack) {
+    if (!pack) return;
+
+#ifdef TREEPACK_MMAP
+    if (pack->data) munmap(pack->data, pack->size);
+#else
+    TREE3D_FREE(pack->data);
+#endif
+    TREE3D_FREE(pack);
+}
+
+int TreePackTree3DCount(const TreePack *pack) {
+    return pack ? (int)pack->header->tree3dCount : 0;
+}
+
+int TreePackTreeCount(const TreePack *pack) {
+    return pack ? (int)pack->header->treeCount : 0;
+}
+
+int TreePackBushCount(const TreePack *pack) {
+    return pack ? (int)pack->header->bushCount : 0;
+}
+
+// Bounds every index the draw and query code follows, so a corrupted pack
+// is refused instead of read past its arrays. A BVH child always sits after
+// its parent, which keeps one pass over the nodes enough to give each node
+// the row it covers.
+static bool TreePackCheckTree3D(const TreePackTree3D *e, const int *rowOffsets, const int *branchCounts,
+                                const Tree3DBranchNode *nodes, const uint32_t *depthOrder,
+                                const Tree3DBVHNode *bvh, const int *rowBranchRoot, const int *rowLeafRoot) {
+    int rows = e->rows, branches = e->branchCount, leaves = e->leafCount, nodeCount = e->bvhNodeCount;
+    if (e->currentRow < 0 || e->currentRow >= rows) return false;
+    if (e->bakedRows < 0 || e->bakedRows > rows || e->bakedLeaves < 0 || e->bakedLeaves > leaves) return false;
+
+    if (e->bvhRows > e->currentRow + 1) return false;
+
+    // Grown rows sit back to back in the pool; rows past CurrentRow are
+    // written before they are read
+    int end = 0;
+    for (int i = 0; i <= e->currentRow; i++) {
+        if (branchCounts[i] < 0 || rowOffsets[i] < end || rowOffsets[i] > branches) return false;
+        if (branchCounts[i] > branches - rowOffsets[i]) return false;
+        end = rowOffsets[i] + branchCounts[i];
+    }
+
+    // Branches form a forest of trees: children come after their parent and
+    // name it, and every branch with a parent is one of its children, as
+    // Tree3DBuildDepthOrder relies on
+    int children = 0, roots = 0;
+    for (int i = 0; i < branches; i++) {
+        const Tree3DBranchNode *n = &nodes[i];
+        if (n->parent == TREE3D_NO_PARENT) roots++;
+        else if (n->parent >= (uint32_t)i) return false;
+        if (n->childCount > 0 && (n->firstChild <= (uint32_t)i || n->firstChild > (uint32_t)branches ||
+                                  n->childCount > (uint32_t)branches - n->firstChild)) return false;
+        for (uint32_t c = 0; c < n->childCount; c++) {
+            if (nodes[n->firstChild + c].parent != (uint32_t)i) return false;
+        }
+        children += n->childCount;
+        if (n->row >= rows) return false;
+        if (e->depthOrderCount > 0 && (n->order >= (uint32_t)e->depthOrderCount ||
+                                       n->subtreeSize > (uint32_t)e->depthOrderCount - n->order)) return false;
+    }
+    if (children + roots != branches) return false;
+    for (int i = 0; i < e->depthOrderCount; i++) {
+        if (depthOrder[i] >= (uint32_t)branches) return false;
+    }
+
+    if (nodeCount == 0) {
+        for (int r = 0; r < e->bvhRows; r++) {
+            if (rowBranchRoot[r] != -1 || rowLeafRoot[r] != -1) return false;
+        }
+        return true;
+    }
+
+    // Row r's branch hierarchy is owner r + 1, its leaf hierarchy rows + r + 1
+    int *owner = (int*)TREE3D_MALLOC((size_t)nodeCount * sizeof(int));
+    if (!owner) {
+        fprintf(stderr, "Failed to allocate pack check\n");
+        exit(1);
+    }
+    memset(owner, 0, (size_t)nodeCount * sizeof(int));
+
+    bool ok = true;
+    for (int r = 0; r < e->bvhRows && ok; r++) {
+        int roots[2] = {rowBranchRoot[r], rowLeafRoot[r]};
+        for (int k = 0; k < 2; k++) {
+            if (roots[k] == -1) continue;
+            if (roots[k] < 0 || roots[k] >= nodeCount || owner[roots[k]] != 0) ok = false;
+            else owner[roots[k]] = k * rows + r + 1;
+        }
+    }
+
+    for (int i = 0; i < nodeCount && ok; i++) {
+        const Tree3DBVHNode *n = &bvh[i];
+        if ((n->left < 0) != (n->right < 0)) ok = false;
+        else if (n->left >= 0 && (n->left <= i || n->left >= nodeCount ||
+                                  n->right <= i || n->right >= nodeCount)) ok = false;
+        if (!ok || owner[i] == 0) continue;
+
+        // Items are indices into the row for branches, the leaf pool for leaves
+        int limit = owner[i] > rows ? leaves : branchCounts[owner[i] - 1];
+        if (n->first < 0 || n->count < 0 || n->first > limit || n->count > limit - n->first) ok = false;
+        if (n->left < 0) continue;
+        for (int k = 0; k < 2 && ok; k++) {
+            int child = k == 0 ? n->left : n->right;
+            if (owner[child] != 0 && owner[child] != owner[i]) ok = false;
+            owner[child] = owner[i];
+        }
+    }
+
+    TREE3D_FREE(owner);
+    return ok;
+}
+
+// Like Tree3DLoad, but the grown tree comes from the pack. `tree` is
+// configured and not yet loaded (e.g. from Tree3DNewTree); its generation
+// fields and storage are replaced by the stored tree, which it then reads
+// in place. Drawing settings such as the LOD tables and impostor are kept.
+bool TreePackLoadTree3D(TreePack *pack, int index, Tree3D *tree) {
+    if (!pack || !tree || index < 0 || index >= (int)pack->header->tree3dCount) return false;
+
+    const TreePackTree3D *e = (const TreePackTree3D*)(pack->data + pack->header->tree3ds) + index;
+    if (e->rows < 1 || e->rows > MAX_ROWS || e->bvhRows < 0 || e->bvhRows > e->rows) return false;
+
+    Tree3D loaded = *tree;
+    Tree3DBranchStreams s;
+    bool ok = true;
+    TREEPACK_ARRAY(pack, loaded.RowOffsets, e->rowOffsets, e->rows, int, ok);
+    TREEPACK_ARRAY(pack, loaded.BranchCount, e->branchCounts, e->rows, int, ok);
+    TREEPACK_ARRAY(pack, s.x1, e->x1, e->branchCount, float, ok);
+    TREEPACK_ARRAY(pack, s.y1, e->y1, e->branchCount, float, ok);
+    TREEPACK_ARRAY(pack, s.z1, e->z1, e->branchCount, float, ok);
+    TREEPACK_ARRAY(pack, s.x2, e->x2, e->branchCount, float, ok);
+    TREEPACK_ARRAY(pack, s.y2, e->y2, e->branchCount, float, ok);
+    TREEPACK_ARRAY(pack, s.z2, e->z2, e->branchCount, float, ok);
+    TREEPACK_ARRAY(pack, s.width, e->branchWidths, e->branchCount, float, ok);
+    TREEPACK_ARRAY(pack, s.nodes, e->branchNodes, e->branchCount, Tree3DBranchNode, ok);
+    TREEPACK_ARRAY(pack, loaded.memPool.leafPool, e->leaves, e->leafCount, Tree3DLeaf, ok);
+    TREEPACK_ARRAY(pack, loaded.depthOrder, e->depthOrder, e->depthOrderCount, uint32_t, ok);
+    TREEPACK_ARRAY(pack, loaded.canopy, e->canopy, e->canopyCount, Tree3DCanopyBlob, ok);
+    TREEPACK_ARRAY(pack, loaded.bvh.nodes, e->bvhNodes, e->bvhNodeCount, Tree3DBVHNode, ok);
+    TREEPACK_ARRAY(pack, loaded.baked.vertices, e->bakedVertices, e->bakedVertexCount * 3, float, ok);
+    TREEPACK_ARRAY(pack, loaded.baked.colors, e->bakedColors, e->bakedVertexCount * 4, unsigned char, ok);
+
+    const int *rowBranchRoot, *rowLeafRoot;
+    const BoundingBox *rowBounds;
+    TREEPACK_ARRAY(pack, rowBranchRoot, e->bvhRowBranchRoot, e->bvhRows, const int, ok);
+    TREEPACK_ARRAY(pack, rowLeafRoot, e->bvhRowLeafRoot, e->bvhRows, const int, ok);
+    TREEPACK_ARRAY(pack, rowBounds, e->bvhRowBounds, e->bvhRows, const BoundingBox, ok);
+    if (!ok) return false;
+    if (!TreePackCheckTree3D(e, loaded.RowOffsets, loaded.BranchCount, s.nodes, loaded.depthOrder,
+                             loaded.bvh.nodes, rowBranchRoot, rowLeafRoot)) return false;
+
+    loaded.allocator = &pack->allocator;
+    loaded.Seed = e->seed;
+    loaded.rngState = e->rngState;
+    loaded.growKey = e->growKey;
+    loaded.LeafChance = e->leafChance;
+    loaded.Scale = e->scale;
+    loaded.Width = e->width;
+    loaded.Height = e->height;
+    loaded.X = e->x;
+    loaded.Y = e->y;
+    loaded.Z = e->z;
+    loaded.MaxRow = e->maxRow;
+    loaded.CurrentRow = e->currentRow;
+    loaded.generateRow = e->generateRow;
+    loaded.SplitChance = e->splitChance;
+    loaded.SplitAngle[0] = e->splitAngle[0];
+    loaded.SplitAngle[1] = e->splitAngle[1];
+    loaded.GrowTimer = e->growTimer;
+    loaded.GrowTime = e->growTime;
+    memcpy(loaded.CsBranch, e->csBranch, sizeof(loaded.CsBranch));
+    memcpy(loaded.CsLeaf, e->csLeaf, sizeof(loaded.CsLeaf));
+    loaded.droppedBranches = e->droppedBranches;
+    loaded.droppedLeaves = e->droppedLeaves;
+
+    // Pools are exactly full, so the next branch or leaf copies them out
+    loaded.memPool.branches = s;
+    loaded.memPool.branchPoolIndex = loaded.memPool.branchCapacity = (size_t)e->branchCount;
+    loaded.memPool.leafPoolIndex = loaded.memPool.leafCapacity = (size_t)e->leafCount;
+    loaded.AllocatedRows = e->rows;
+    loaded.AllocatedBranches = e->branchCount;
+    loaded.AllocatedLeaves = e->leafCount;
+    loaded.LeafCount = e->leafCount;
+    loaded.depthOrderCount = loaded.depthOrderCapacity = e->depthOrderCount;
+    loaded.canopyCount = loaded.canopyCapacity = e->canopyCount;
+    loaded.canopyLeaves = e->canopyLeaves;
+
+    loaded.bvh.nodeCount = loaded.bvh.nodeCapacity = e->bvhNodeCount;
+    loaded.bvh.builtRows = e->bvhRows;
+    if (e->bvhRows > 0) {
+        memcpy(loaded.bvh.rowBranchRoot, rowBranchRoot, (size_t)e->bvhRows * sizeof(int));
+        memcpy(loaded.bvh.rowLeafRoot, rowLeafRoot, (size_t)e->bvhRows * sizeof(int));
+        memcpy(loaded.bvh.rowBounds, rowBounds, (size_t)e->bvhRows * sizeof(BoundingBox));
+    }
+
+    loaded.baked.vertexCount = loaded.baked.capacity = e->bakedVertexCount;
+    loaded.baked.bakedRows = e->bakedRows;
+    loaded.baked.bakedLeaves = e->bakedLeaves;
+    loaded.baked.dirty = true;
+    loaded.baked.mesh = (Mesh){0};
+
+    loaded.bounds = e->bounds;
+    loaded.MinX = e->bounds.min.x;
+    loaded.MaxX = e->bounds.max.x;
+    loaded.MinZ = e->bounds.min.z;
+    loaded.MaxZ = e->bounds.max.z;
+    loaded.needsBoundsUpdate = false;
+
+    Tree3DInitTrigTables();
+    *tree = loaded;
+    return true;
+}
+
+// Fill `tree` with a stored Tree. Tree's storage is fixed-size, so its
+// branches and leaves are copied rather than used in place.
+bool TreePackLoadTree(const TreePack *pack, int index, Tree *tree) {
+    if (!pack || !tree || index < 0 || index >= (int)pack->header->treeCount) return false;
+
+    const TreePackTree *e = (const TreePackTree*)(pack->data + pack->header->trees) + index;
+    if (e->rows < 1 || e->rows > MAX_ROWS || e->leafCount < 0 || e->leafCount > MAX_LEAVES) return false;
+
+    const int *counts;
+    const TreeLeaf *leaves;
+    bool ok = true;
+    TREEPACK_ARRAY(pack, counts, e->branchCounts, e->rows, const int, ok);
+    TREEPACK_ARRAY(pack, leaves, e->leaves, e->leafCount, const TreeLeaf, ok);
+    if (!ok) return false;
+
+    // Rows follow one another, each on an aligned offset
+    uint64_t offset = e->branches;
+    for (int i = 0; i < e->rows; i++) {
+        if (counts[i] < 0 || counts[i] > MAX_BRANCHES_PER_ROW) return false;
+        const TreeBranch *row = (const TreeBranch*)TreePackAt(pack, offset, (size_t)counts[i] * sizeof(TreeBranch));
+        if (counts[i] > 0 && !row) return false;
+        if (counts[i] > 0) {
+            memcpy(tree->Branches[i], row, (size_t)counts[i] * sizeof(TreeBranch));
+            offset = TreePackAlignOffset(offset + (uint64_t)counts[i] * sizeof(TreeBranch));
+        }
+        tree->BranchCount[i] = counts[i];
+    }
+    for (int i = e->rows; i < MAX_ROWS; i++) tree->BranchCount[i] = 0;
+    if (e->leafCount > 0) memcpy(tree->Leaves, leaves, (size_t)e->leafCount * sizeof(TreeLeaf));
+
+    tree->Seed = e->seed;
+    tree->rngState = e->rngState;
+    tree->LeafChance = e->leafChance;
+    tree->Width = e->width;
+    tree->Height = e->height;
+    tree->X = e->x;
+    tree->Y = e->y;
+    tree->LeftX = e->leftX;
+    tree->RightX = e->rightX;
+    tree->MaxRow = e->maxRow;
+    tree->CurrentRow = e->currentRow;
+    tree->SplitChance = e->splitChance;
+    tree->SplitAngle[0] = e->splitAngle[0];
+    tree->SplitAngle[1] = e->splitAngle[1];
+    tree->GrowTimer = e->growTimer;
+    tree->GrowTime = e->growTime;
+    memcpy(tree->CsBranch, e->csBranch, sizeof(tree->CsBranch));
+    memcpy(tree->CsLeaf, e->csLeaf, sizeof(tree->CsLeaf));
+    tree->RandomRow = e->randomRow != 0;
+    tree->LeafCount = e->leafCount;
+    tree->droppedBranches = e->droppedBranches;
+    tree->droppedLeaves = e->droppedLeaves;
+    return true;
+}
+
+// A stored bush, used in place. It can be updated and drawn like any other;
+// changes stay in memory.
+Bush3D* TreePackGetBush(TreePack *pack, int index) {
+    if (!pack || index < 0 || index >= (int)pack->header->bushCount) return NULL;
+    return (Bush3D*)(pack->data + pack->header->bushes) + index;
+}
+
+// Add every stored Tree3D (with Tree3DNewTree's drawing settings) and bush
+// to a forest without growing anything. Returns the index of the first tree.
+int TreePackAddToForest(TreePack *pack, Tree3DForest *forest) {
+    int first = forest->treeCount;
+    for (int i = 0; i < TreePackTree3DCount(pack); i++) {
+        Tree3D tree = Tree3DNewTree();
+        if (TreePackLoadTree3D(pack, i, &tree)) Tree3DForestAddLoadedTree(forest, tree);
+    }
+    for (int i = 0; i < TreePackBushCount(pack); i++) {
+        Tree3DForestAddBush(forest, *TreePackGetBush(pack, i));
+    }
+    return first;
+}
+
+#undef TREEPACK_ARRAY
+
+#endif // TREEPACK_IMPLEMENTATION
+#endif // TREEPACK_H
@@ -0,0 +1,163 @@
+#ifndef TREESPECIES_H
+#define TREESPECIES_H
+
+#include "treecache.h"
+
+// Define TREESPECIES_IMPLEMENTATION (together with TREECACHE_IMPLEMENTATION
+// and TREE3D_IMPLEMENTATION) in ONE source file to include the implementation
+
+// Species registry. A species holds everything trees of a kind have in
+// common (growth parameters, color ranges, detail tiers, render settings
+// and impostor) once, read-only. A placed tree is a small handle: species,
+// seed, position, yaw and whether it has been grown. Handles are grown on
+// demand through the registry's cache, so two handles of the same species
+// and seed share one grown tree.
+
+// Configuration Macros
+#ifndef TREE3D_SPECIES_NAME_SIZE
+#define TREE3D_SPECIES_NAME_SIZE 32
+#endif
+
+// Pre-declare structures
+typedef struct Tree3DTemplate Tree3DTemplate;
+typedef struct Tree3DRegistry Tree3DRegistry;
+typedef struct Tree3DHandle Tree3DHandle;
+
+typedef enum {
+    TREE3D_HANDLE_DORMANT = 0,      // Placed only; nothing grown
+    TREE3D_HANDLE_GROWN             // Points at its shared grown tree
+} Tree3DHandleState;
+
+// One species. `params` is a configured tree that is never loaded: its
+// Seed and position are ignored, everything else applies to every tree
+// of the species.
+struct Tree3DTemplate {
+    char name[TREE3D_SPECIES_NAME_SIZE];
+    Tree3D params;
+};
+
+struct Tree3DRegistry {
+    Tree3DTemplate *species;
+    int count;
+    int capacity;
+    Tree3DCache cache;          // Grown trees by species parameters and seed
+};
+
+// A placed tree
+struct Tree3DHandle {
+    Tree3D *tree;               // Shared grown tree, NULL while dormant
+    uint64_t seed;
+    Vector3 position;
+    float yaw;                  // Degrees about the vertical axis
+    uint16_t species;
+    uint8_t state;              // Tree3DHandleState
+};
+
+// Function Declarations
+Tree3DRegistry Tree3DRegistryNew(void);
+int Tree3DRegistryAdd(Tree3DRegistry *registry, const char *name, const Tree3D *params);
+int Tree3DRegistryFind(const Tree3DRegistry *registry, const char *name);
+const Tree3DTemplate* Tree3DRegistryGet(const Tree3DRegistry *registry, int species);
+Tree3DHandle Tree3DRegistryPlace(const Tree3DRegistry *registry, int species, uint64_t seed,
+                                 Vector3 position, float yaw);
+Tree3D* Tree3DRegistryWake(Tree3DRegistry *registry, Tree3DHandle *handle);
+void Tree3DRegistrySleep(Tree3DHandle *handle);
+void Tree3DRegistryDraw(Tree3DRegistry *registry, Tree3DHandle *handle, Camera3D camera);
+void Tree3DRegistryFree(Tree3DRegistry *registry);
+
+#ifdef TREESPECIES_IMPLEMENTATION
+
+Tree3DRegistry Tree3DRegistryNew(void) {
+    Tree3DRegistry registry = {0};
+    registry.cache = Tree3DCacheNew();
+    return registry;
+}
+
+// Register a species from a configured, not yet loaded tree such as
+// Tree3DNewJungleTree's. Returns its id, or -1 if the name is taken or the
+// registry is full.
+int Tree3DRegistryAdd(Tree3DRegistry *registry, const char *name, const Tree3D *params) {
+    if (Tree3DRegistryFind(registry, name) >= 0 || registry->count > UINT16_MAX) return -1;
+
+    if (registry->count >= registry->capacity) {
+        int newCapacity = registry->capacity > 0 ? registry->capacity * 2 : 8;
+        Tree3DTemplate *species = (Tree3DTemplate*)TREE3D_REALLOC(registry->species,
+                                                                  newCapacity * sizeof(Tree3DTemplate));
+        if (!species) {
+            fprintf(stderr, "Failed to allocate species registry\n");
+            exit(1);
+        }
+        registry->species = species;
+        registry->capacity = newCapacity;
+    }
+
+    Tree3DTemplate *t = &registry->species[registry->count];
+    memset(t->name, 0, sizeof(t->name));
+    strncpy(t->name, name, sizeof(t->name) - 1);
+    t->params = *params;
+    t->params.X = t->params.Y = t->params.Z = 0.0f;
+    t->params.Seed = 0;
+    t->params.RandomRow = false;
+    return registry->count++;
+}
+
+int Tree3DRegistryFind(const Tree3DRegistry *registry, const char *name) {
+    for (int i = 0; i < registry->count; i++) {
+        if (strncmp(registry->species[i].name, name, TREE3D_SPECIES_NAME_SIZE - 1) == 0) return i;
+    }
+    return -1;
+}
+
+const Tree3DTemplate* Tree3DRegistryGet(const Tree3DRegistry *registry, int species) {
+    if (species < 0 || species >= registry->count) return NULL;
+    return &registry->species[species];
+}
+
+// A dormant tree of a species; nothing is grown until it is woken or drawn
+Tree3DHandle Tree3DRegistryPlace(const Tree3DRegistry *registry, int species, uint64_t seed,
+                                 Vector3 position, float yaw) {
+    (void)registry;
+    Tree3DHandle handle = {0};
+    handle.species = (uint16_t)species;
+    handle.seed = seed;
+    handle.position = position;
+    handle.yaw = yaw;
+    handle.state = TREE3D_HANDLE_DORMANT;
+    return handle;
+}
+
+// Grow the handle's tree, or share one already grown for its species and
+// seed. Returns the shared tree, NULL for an unknown species.
+Tree3D* Tree3DRegistryWake(Tree3DRegistry *registry, Tree3DHandle *handle) {
+    if (handle->state == TREE3D_HANDLE_GROWN) return handle->tree;
+    if (handle->species >= registry->count) return NULL;
+
+    handle->tree = Tree3DCacheGetSeeded(&registry->cache, &registry->species[handle->species].params,
+                                        handle->seed);
+    handle->state = TREE3D_HANDLE_GROWN;
+    return handle->tree;
+}
+
+// Drop the handle's reference to its grown tree. The tree stays in the
+// cache, and waking the handle again returns the same tree.
+void Tree3DRegistrySleep(Tree3DHandle *handle) {
+    handle->tree = NULL;
+    handle->state = TREE3D_HANDLE_DORMANT;
+}
+
+// Draw the handle's tree, waking it first if needed
+void Tree3DRegistryDraw(Tree3DRegistry *registry, Tree3DHandle *handle, Camera3D camera) {
+    Tree3D *tree = Tree3DRegistryWake(registry, handle);
+    if (tree) Tree3DCacheDrawAt(tree, handle->position, handle->yaw, camera);
+}
+
+void Tree3DRegistryFree(Tree3DRegistry *registry) {
+    if (!registry) return;
+
+    Tree3DCacheFree(&registry->cache);
+    TREE3D_FREE(registry->species);
+    *registry = (Tree3DRegistry){0};
+}
+
+#endif // TREESPECIES_IMPLEMENTATION
+#endif // TREESPECIES_H
@@ -0,0 +1,80 @@
+#ifndef TREESTATS_H
+#define TREESTATS_H
+
+#include <raylib.h>
+#include <string.h>
+
+// Frame statistics and profiler zones shared by tree2d.h, tree3d.h and
+// bush3d.h. Define TREE_STATS before including them to compile the
+// instrumentation in; without it the counters, timers and zone callbacks
+// expand to nothing and the Set... functions only store their argument.
+
+// Configuration Macros
+#ifndef TREE_STATS_LOD_BUCKETS
+#define TREE_STATS_LOD_BUCKETS 8
+#endif
+
+// lodHistogram bucket that trees and bushes both count impostors in; the
+// buckets below it are detail tiers
+#define TREE_STATS_LOD_IMPOSTOR 3
+#if TREE_STATS_LOD_IMPOSTOR >= TREE_STATS_LOD_BUCKETS
+#error "TREE_STATS_LOD_BUCKETS must cover the impostor bucket"
+#endif
+
+// Frame Statistics
+// Accumulated by every draw while set with Tree3DSetFrameStats,
+// TreeSetFrameStats or Bush3DSetFrameStats; one struct may be shared by all
+// three. Reset it once per frame with TreeResetFrameStats.
+typedef struct TreeFrameStats {
+    long branchesConsidered;    // Branches of every tree handed to a draw
+    long branchesCulled;        // Of those, rejected by frustum culling
+    long branchesDrawn;
+    long leavesDrawn;           // Leaf spheres (berries included) or circles
+    long drawCalls;
+    long lodHistogram[TREE_STATS_LOD_BUCKETS];  // Trees and bushes drawn per LOD tier
+    double cullUs;              // Frustum tests
+    double batchUs;             // Filling batches and instance buffers
+    double submitUs;            // raylib draw calls and uploads
+} TreeFrameStats;
+
+// Profiler Zones
+// begin and end are called with the same static name around Tree3DGrow,
+// Tree3DBatchDraw and Bush3DDraw. Tree3DGrow also runs on forest generation
+// threads, so the callbacks must be thread-safe when those are used.
+typedef void (*TreeZoneCallback)(const char *name, void *user);
+
+typedef struct TreeProfileZones {
+    TreeZoneCallback begin;
+    TreeZoneCallback end;
+    void *user;
+} TreeProfileZones;
+
+static inline void TreeResetFrameStats(TreeFrameStats *stats) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+}
+
+// Instrumentation used by the libraries. `stats` may be NULL; a timer is
+// started once and each lap adds the time since the last mark to a field.
+#ifdef TREE_STATS
+#define TREE_STATS_ADD(stats, field, n) do { if (stats) (stats)->field += (n); } while (0)
+#define TREE_STATS_TIMER(timer) double timer = 0.0
+#define TREE_STATS_START(stats, timer) do { if (stats) (timer) = GetTime(); } while (0)
+#define TREE_STATS_LAP(stats, timer, field) do { \
+        if (stats) { \
+            double now_ = GetTime(); \
+            (stats)->field += (now_ - (timer)) * 1e6; \
+            (timer) = now_; \
+        } \
+    } while (0)
+#define TREE_ZONE_BEGIN(zones, name) do { if ((zones).begin) (zones).begin(name, (zones).user); } while (0)
+#define TREE_ZONE_END(zones, name) do { if ((zones).end) (zones).end(name, (zones).user); } while (0)
+#else
+#define TREE_STATS_ADD(stats, field, n) ((void)0)
+#define TREE_STATS_TIMER(timer)
+#define TREE_STATS_START(stats, timer) ((void)0)
+#define TREE_STATS_LAP(stats, timer, field) ((void)0)
+#define TREE_ZONE_BEGIN(zones, name) ((void)0)
+#define TREE_ZONE_END(zones, name) ((void)0)
+#endif
+
+#endif // TREESTATS_H
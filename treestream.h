@@ -0,0 +1,583 @@
+#ifndef TREESTREAM_H
+#define TREESTREAM_H
+
+#include "treespecies.h"
+
+// Define TREESTREAM_IMPLEMENTATION (together with TREESPECIES_IMPLEMENTATION,
+// TREECACHE_IMPLEMENTATION and TREE3D_IMPLEMENTATION) in ONE source file to
+// include the implementation
+
+// Streamed trees for worlds too large to keep grown. Every placed tree is
+// kept only as its species, seed and position, bucketed into square chunks.
+// Chunks that come within loadRadius of the viewer are grown on a background
+// worker; grown chunks stay resident in least-recently-used order until
+// their memory exceeds memoryBudget, then the stalest chunk out of range is
+// freed back to its placements. Growth is deterministic, so a chunk grown
+// again has exactly the trees it had before.
+
+// Configuration Macros
+#ifndef TREESTREAM_CHUNK_SIZE
+#define TREESTREAM_CHUNK_SIZE 64.0f
+#endif
+
+#ifndef TREESTREAM_LOAD_RADIUS
+#define TREESTREAM_LOAD_RADIUS 256.0f
+#endif
+
+#ifndef TREESTREAM_MEMORY_BUDGET
+#define TREESTREAM_MEMORY_BUDGET ((size_t)256 * 1024 * 1024)
+#endif
+
+// Chunks queued or growing at once. Kept small so the queue follows the
+// viewer instead of working through chunks it has already left.
+#ifndef TREESTREAM_MAX_PENDING
+#define TREESTREAM_MAX_PENDING 4
+#endif
+
+#ifndef TREESTREAM_ARENA_BLOCK_SIZE
+#define TREESTREAM_ARENA_BLOCK_SIZE (256 * 1024)
+#endif
+
+// Chunks grow on a pthread worker; define TREESTREAM_NO_THREADS to grow them
+// during Tree3DStreamUpdate on the calling thread instead
+#if !defined(TREESTREAM_NO_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define TREESTREAM_THREADS
+#endif
+
+// Pre-declare structures
+typedef struct Tree3DStreamTree Tree3DStreamTree;
+typedef struct Tree3DStreamChunk Tree3DStreamChunk;
+typedef struct Tree3DStreamJobs Tree3DStreamJobs;
+typedef struct Tree3DStream Tree3DStream;
+
+typedef enum {
+    TREE3D_CHUNK_EVICTED = 0,       // Placements only; nothing grown
+    TREE3D_CHUNK_QUEUED,            // Handed to the worker, not yet collected
+    TREE3D_CHUNK_RESIDENT           // Grown and drawn
+} Tree3DChunkState;
+
+// A placed tree: all that is kept of it while its chunk is evicted
+struct Tree3DStreamTree {
+    Vector3 position;
+    uint64_t seed;
+    uint16_t species;
+};
+
+struct Tree3DStreamChunk {
+    Tree3DStreamTree *placed;
+    int count;
+    int capacity;
+
+    // Grown trees in placement order, NULL unless resident. Their storage
+    // lives in the chunk's arena and goes with it on eviction. Written by
+    // the worker while queued, read by the main thread once resident.
+    Tree3D *trees;
+    Tree3DArena *arena;
+    size_t bytes;               // Arena and tree structures
+    BoundingBox bounds;         // Union of the grown trees' bounds
+
+    uint64_t lastUsed;          // Last update that found the chunk in range
+    int state;                  // Tree3DChunkState, main thread only
+};
+
+struct Tree3DStream {
+    const Tree3DRegistry *registry;     // Species must not be added while streaming
+
+    // Uniform grid of chunks over the XZ plane
+    Tree3DStreamChunk *chunks;
+    int chunksX, chunksZ;
+    float chunkSize;
+    float originX, originZ;
+
+    float loadRadius;           // Chunks closer than this to the viewer are grown
+    size_t memoryBudget;        // Resident bytes past which chunks out of range are evicted
+
+    size_t residentBytes;
+    int residentChunks;
+    uint64_t frame;             // Tree3DStreamUpdate calls
+    int grown;                  // Chunks grown, counting regrowth after eviction
+    int evicted;
+
+    Tree3DStreamJobs *jobs;     // Worker queue and thread state
+    int *candidates;            // Scratch for chunks to queue, nearest first
+    Tree3DInstanceData instanceData;
+};
+
+// Function Declarations
+Tree3DStream Tree3DStreamNew(const Tree3DRegistry *registry, float minX, float minZ, float maxX, float maxZ,
+                             float chunkSize);
+bool Tree3DStreamAdd(Tree3DStream *stream, int species, uint64_t seed, Vector3 position);
+void Tree3DStreamUpdate(Tree3DStream *stream, Vector3 viewer);
+void Tree3DStreamWait(Tree3DStream *stream);
+Tree3D* Tree3DStreamGetTrees(Tree3DStream *stream, float x, float z, int *count);
+void Tree3DStreamDraw(Tree3DStream *stream, Camera3D camera);
+void Tree3DStreamFree(Tree3DStream *stream);
+
+#ifdef TREESTREAM_IMPLEMENTATION
+
+#ifdef TREESTREAM_THREADS
+#include <pthread.h>
+#endif
+
+struct Tree3DStreamJobs {
+    const Tree3DRegistry *registry;
+    Tree3DStreamChunk *chunks;
+    int queue[TREESTREAM_MAX_PENDING];  // Chunk indices, nearest first
+    int queued;
+    int growing;                        // Chunk the worker is growing, -1 for none
+    int *ready;                         // Grown chunks awaiting collection
+    int readyCount;
+#ifdef TREESTREAM_THREADS
+    pthread_t worker;
+    bool started;
+    bool quit;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;                // Work queued or quit
+    pthread_cond_t done;                // A chunk finished growing
+#endif
+};
+
+static void Tree3DStreamLock(Tree3DStreamJobs *jobs) {
+#ifdef TREESTREAM_THREADS
+    pthread_mutex_lock(&jobs->lock);
+#else
+    (void)jobs;
+#endif
+}
+
+static void Tree3DStreamUnlock(Tree3DStreamJobs *jobs) {
+#ifdef TREESTREAM_THREADS
+    pthread_mutex_unlock(&jobs->lock);
+#else
+    (void)jobs;
+#endif
+}
+
+static int Tree3DStreamChunkCoord(float value, float origin, float chunkSize, int chunks) {
+    int c = (int)floorf((value - origin) / chunkSize);
+    if (c < 0) c = 0;
+    if (c >= chunks) c = chunks - 1;
+    return c;
+}
+
+// Squared XZ distance from a point to a chunk's square
+static float Tree3DStreamChunkDistanceSq(const Tree3DStream *stream, int cx, int cz, Vector3 p) {
+    float x0 = stream->originX + cx * stream->chunkSize;
+    float z0 = stream->originZ + cz * stream->chunkSize;
+    float dx = p.x - Clamp(p.x, x0, x0 + stream->chunkSize);
+    float dz = p.z - Clamp(p.z, z0, z0 + stream->chunkSize);
+    return dx * dx + dz * dz;
+}
+
+// Grow every placed tree of a chunk on the heap, then move it into a fresh
+// arena once it has settled; the arena cannot reclaim the pools a growing
+// tree outgrows. Runs on the worker; touches nothing but the chunk and the
+// read-only species templates.
+static void Tree3DStreamGrowChunk(const Tree3DRegistry *registry, Tree3DStreamChunk *chunk) {
+    chunk->arena = Tree3DArenaCreate(TREESTREAM_ARENA_BLOCK_SIZE);
+    chunk->trees = (Tree3D*)TREE3D_MALLOC(chunk->count * sizeof(Tree3D));
+    if (!chunk->trees) {
+        fprintf(stderr, "Failed to allocate streamed trees\n");
+        exit(1);
+    }
+
+    BoundingBox bounds = {{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+    for (int i = 0; i < chunk->count; i++) {
+        const Tree3DStreamTree *placed = &chunk->placed[i];
+        Tree3D *tree = &chunk->trees[i];
+        *tree = registry->species[placed->species].params;
+        tree->X = placed->position.x;
+        tree->Y = placed->position.y;
+        tree->Z = placed->position.z;
+        tree->Seed = placed->seed;
+        tree->RandomRow = false;
+        tree->allocator = NULL;
+
+        Tree3DLoad(tree);
+        while (tree->CurrentRow < tree->MaxRow) Tree3DGrow(tree);
+        tree->GrowTimer = 0;
+        if (tree->useBakedMesh) Tree3DBakeRows(tree, tree->CurrentRow + 1);
+        if (tree->canopyLeaves != tree->LeafCount) Tree3DBuildCanopy(tree);
+        Tree3DUpdateBounds(tree);
+        Tree3DMoveStorage(tree, &chunk->arena->allocator);
+
+        bounds.min = Vector3Min(bounds.min, tree->bounds.min);
+        bounds.max = Vector3Max(bounds.max, tree->bounds.max);
+    }
+
+    chunk->bounds = bounds;
+    chunk->bytes = chunk->arena->bytesReserved + chunk->count * sizeof(Tree3D);
+}
+
+// Take the nearest queued chunk and grow it. Called with the lock held;
+// returns false when the queue is empty.
+static bool Tree3DStreamRunJob(Tree3DStreamJobs *jobs) {
+    if (jobs->queued == 0) return false;
+
+    int index = jobs->queue[0];
+    jobs->queued--;
+    memmove(jobs->queue, jobs->queue + 1, jobs->queued * sizeof(int));
+
+    jobs->growing = index;
+    Tree3DStreamUnlock(jobs);
+
+    Tree3DStreamGrowChunk(jobs->registry, &jobs->chunks[index]);
+
+    Tree3DStreamLock(jobs);
+    jobs->ready[jobs->readyCount++] = index;
+    jobs->growing = -1;
+#ifdef TREESTREAM_THREADS
+    pthread_cond_broadcast(&jobs->done);
+#endif
+    return true;
+}
+
+#ifdef TREESTREAM_THREADS
+static void* Tree3DStreamWorkerRun(void *arg) {
+    Tree3DStreamJobs *jobs = (Tree3DStreamJobs*)arg;
+
+    pthread_mutex_lock(&jobs->lock);
+    while (!jobs->quit) {
+        if (!Tree3DStreamRunJob(jobs)) pthread_cond_wait(&jobs->wake, &jobs->lock);
+    }
+    pthread_mutex_unlock(&jobs->lock);
+    return NULL;
+}
+#endif
+
+// Move chunks the worker has finished into the resident set
+static void Tree3DStreamCollect(Tree3DStream *stream) {
+    Tree3DStreamJobs *jobs = stream->jobs;
+
+    Tree3DStreamLock(jobs);
+    for (int i = 0; i < jobs->readyCount; i++) {
+        Tree3DStreamChunk *chunk = &stream->chunks[jobs->ready[i]];
+        chunk->state = TREE3D_CHUNK_RESIDENT;
+        stream->residentBytes += chunk->bytes;
+        stream->residentChunks++;
+        stream->grown++;
+    }
+    jobs->readyCount = 0;
+    Tree3DStreamUnlock(jobs);
+}
+
+// Free a resident chunk's trees; its placements stay
+static void Tree3DStreamEvict(Tree3DStream *stream, Tree3DStreamChunk *chunk) {
+    for (int i = 0; i < chunk->count; i++) {
+        Tree3DFree(&chunk->trees[i]);
+    }
+    TREE3D_FREE(chunk->trees);
+    Tree3DArenaDestroy(chunk->arena);
+    chunk->trees = NULL;
+    chunk->arena = NULL;
+
+    stream->residentBytes -= chunk->bytes;
+    stream->residentChunks--;
+    stream->evicted++;
+    chunk->bytes = 0;
+    chunk->state = TREE3D_CHUNK_EVICTED;
+}
+
+// Take a queued chunk back from the worker so its placements can change.
+// Leaves it evicted, or resident if the worker already grew it; waits if it
+// is growing.
+static void Tree3DStreamSettle(Tree3DStream *stream, Tree3DStreamChunk *chunk) {
+    if (chunk->state != TREE3D_CHUNK_QUEUED) return;
+
+    Tree3DStreamJobs *jobs = stream->jobs;
+    int index = (int)(chunk - stream->chunks);
+
+    Tree3DStreamLock(jobs);
+    for (int i = 0; i < jobs->queued; i++) {
+        if (jobs->queue[i] != index) continue;
+        jobs->queued--;
+        memmove(jobs->queue + i, jobs->queue + i + 1, (jobs->queued - i) * sizeof(int));
+        chunk->state = TREE3D_CHUNK_EVICTED;
+        break;
+    }
+#ifdef TREESTREAM_THREADS
+    while (jobs->growing == index) {
+        pthread_cond_wait(&jobs->done, &jobs->lock);
+    }
+#endif
+    Tree3DStreamUnlock(jobs);
+
+    // Not in the queue any more, so it is grown and waiting to be collected
+    if (chunk->state == TREE3D_CHUNK_QUEUED) Tree3DStreamCollect(stream);
+}
+
+static float Tree3DStreamIndexDistanceSq(const Tree3DStream *stream, int index, Vector3 p) {
+    return Tree3DStreamChunkDistanceSq(stream, index % stream->chunksX, index / stream->chunksX, p);
+}
+
+// Move the nearest `keep` candidates to the front, nearest first. Only a
+// handful are queued per update, so a partial selection beats a full sort.
+static void Tree3DStreamSelectNearest(const Tree3DStream *stream, int *candidates, int count, int keep,
+                                      Vector3 viewer) {
+    if (keep > count) keep = count;
+    for (int i = 0; i < keep; i++) {
+        int nearest = i;
+        float best = Tree3DStreamIndexDistanceSq(stream, candidates[i], viewer);
+        for (int j = i + 1; j < count; j++) {
+            float d = Tree3DStreamIndexDistanceSq(stream, candidates[j], viewer);
+            if (d < best) {
+                best = d;
+                nearest = j;
+            }
+        }
+        int swap = candidates[i];
+        candidates[i] = candidates[nearest];
+        candidates[nearest] = swap;
+    }
+}
+
+Tree3DStream Tree3DStreamNew(const Tree3DRegistry *registry, float minX, float minZ, float maxX, float maxZ,
+                             float chunkSize) {
+    Tree3DStream stream = {0};
+    stream.registry = registry;
+
+    if (chunkSize <= 0.0f) chunkSize = TREESTREAM_CHUNK_SIZE;
+    stream.chunkSize = chunkSize;
+    stream.originX = minX;
+    stream.originZ = minZ;
+    stream.chunksX = (int)ceilf((maxX - minX) / chunkSize);
+    stream.chunksZ = (int)ceilf((maxZ - minZ) / chunkSize);
+    if (stream.chunksX < 1) stream.chunksX = 1;
+    if (stream.chunksZ < 1) stream.chunksZ = 1;
+    stream.loadRadius = TREESTREAM_LOAD_RADIUS;
+    stream.memoryBudget = TREESTREAM_MEMORY_BUDGET;
+
+    int chunkCount = stream.chunksX * stream.chunksZ;
+    stream.chunks = (Tree3DStreamChunk*)TREE3D_MALLOC(chunkCount * sizeof(Tree3DStreamChunk));
+    stream.candidates = (int*)TREE3D_MALLOC(chunkCount * sizeof(int));
+    stream.jobs = (Tree3DStreamJobs*)TREE3D_MALLOC(sizeof(Tree3DStreamJobs));
+    int *ready = (int*)TREE3D_MALLOC(chunkCount * sizeof(int));
+    if (!stream.chunks || !stream.candidates || !stream.jobs || !ready) {
+        fprintf(stderr, "Failed to allocate tree stream\n");
+        exit(1);
+    }
+    memset(stream.chunks, 0, chunkCount * sizeof(Tree3DStreamChunk));
+    memset(stream.jobs, 0, sizeof(Tree3DStreamJobs));
+    stream.jobs->registry = registry;
+    stream.jobs->chunks = stream.chunks;
+    stream.jobs->ready = ready;
+    stream.jobs->growing = -1;
+    Tree3DInitInstanceData(&stream.instanceData);
+
+    // Shared lazily built state must exist before the worker starts
+    Tree3DInitTrigTables();
+
+#ifdef TREESTREAM_THREADS
+    Tree3DStreamJobs *jobs = stream.jobs;
+    pthread_mutex_init(&jobs->lock, NULL);
+    pthread_cond_init(&jobs->wake, NULL);
+    pthread_cond_init(&jobs->done, NULL);
+    // Without a worker, updates grow queued chunks themselves
+    jobs->started = pthread_create(&jobs->worker, NULL, Tree3DStreamWorkerRun, jobs) == 0;
+#endif
+    return stream;
+}
+
+// Place a tree of a registered species. Nothing is grown until its chunk
+// comes within range; a chunk already grown is grown again with the new
+// tree. Returns false for an unknown species.
+bool Tree3DStreamAdd(Tree3DStream *stream, int species, uint64_t seed, Vector3 position) {
+    if (!Tree3DRegistryGet(stream->registry, species)) return false;
+
+    int cx = Tree3DStreamChunkCoord(position.x, stream->originX, stream->chunkSize, stream->chunksX);
+    int cz = Tree3DStreamChunkCoord(position.z, stream->originZ, stream->chunkSize, stream->chunksZ);
+    Tree3DStreamChunk *chunk = &stream->chunks[cz * stream->chunksX + cx];
+
+    Tree3DStreamSettle(stream, chunk);
+    if (chunk->state == TREE3D_CHUNK_RESIDENT) Tree3DStreamEvict(stream, chunk);
+
+    if (chunk->count >= chunk->capacity) {
+        int newCapacity = chunk->capacity > 0 ? chunk->capacity * 2 : 16;
+        Tree3DStreamTree *placed = (Tree3DStreamTree*)TREE3D_REALLOC(chunk->placed,
+                                                                     newCapacity * sizeof(Tree3DStreamTree));
+        if (!placed) {
+            fprintf(stderr, "Failed to allocate streamed placements\n");
+            exit(1);
+        }
+        chunk->placed = placed;
+        chunk->capacity = newCapacity;
+    }
+
+    Tree3DStreamTree *placed = &chunk->placed[chunk->count++];
+    placed->position = position;
+    placed->seed = seed;
+    placed->species = (uint16_t)species;
+    return true;
+}
+
+// Call once per frame with the viewer's position. Collects chunks the worker
+// has grown, evicts the least recently used chunks out of range while over
+// budget, and queues the nearest chunks in range that are not grown. Grows
+// the queued chunks on the calling thread when there is no worker.
+void Tree3DStreamUpdate(Tree3DStream *stream, Vector3 viewer) {
+    Tree3DStreamJobs *jobs = stream->jobs;
+    stream->frame++;
+    Tree3DStreamCollect(stream);
+
+    float radius = stream->loadRadius;
+    int x0 = Tree3DStreamChunkCoord(viewer.x - radius, stream->originX, stream->chunkSize, stream->chunksX);
+    int x1 = Tree3DStreamChunkCoord(viewer.x + radius, stream->originX, stream->chunkSize, stream->chunksX);
+    int z0 = Tree3DStreamChunkCoord(viewer.z - radius, stream->originZ, stream->chunkSize, stream->chunksZ);
+    int z1 = Tree3DStreamChunkCoord(viewer.z + radius, stream->originZ, stream->chunkSize, stream->chunksZ);
+
+    int candidateCount = 0;
+    for (int cz = z0; cz <= z1; cz++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            if (Tree3DStreamChunkDistanceSq(stream, cx, cz, viewer) > radius * radius) continue;
+            int index = cz * stream->chunksX + cx;
+            Tree3DStreamChunk *chunk = &stream->chunks[index];
+            chunk->lastUsed = stream->frame;
+            if (chunk->count > 0 && chunk->state == TREE3D_CHUNK_EVICTED) {
+                stream->candidates[candidateCount++] = index;
+            }
+        }
+    }
+
+    // Evict the stalest chunks out of range until back under budget
+    while (stream->residentBytes > stream->memoryBudget) {
+        Tree3DStreamChunk *stalest = NULL;
+        int chunkCount = stream->chunksX * stream->chunksZ;
+        for (int i = 0; i < chunkCount; i++) {
+            Tree3DStreamChunk *chunk = &stream->chunks[i];
+            if (chunk->state != TREE3D_CHUNK_RESIDENT || chunk->lastUsed == stream->frame) continue;
+            if (!stalest || chunk->lastUsed < stalest->lastUsed) stalest = chunk;
+        }
+        if (!stalest) break;
+        Tree3DStreamEvict(stream, stalest);
+    }
+
+    Tree3DStreamLock(jobs);
+
+    // Drop queued chunks that left range before the worker got to them
+    for (int i = 0; i < jobs->queued; i++) {
+        Tree3DStreamChunk *chunk = &stream->chunks[jobs->queue[i]];
+        if (chunk->lastUsed == stream->frame) continue;
+        chunk->state = TREE3D_CHUNK_EVICTED;
+        jobs->queued--;
+        memmove(jobs->queue + i, jobs->queue + i + 1, (jobs->queued - i) * sizeof(int));
+        i--;
+    }
+
+    // Queue the nearest chunks in range while there is room in the budget.
+    // Chunks in range are never evicted, so resident memory stays within the
+    // budget plus the chunks in flight; a budget too small for loadRadius
+    // leaves the farthest chunks in range ungrown.
+    int pending = jobs->queued + (jobs->growing >= 0) + jobs->readyCount;
+    Tree3DStreamSelectNearest(stream, stream->candidates, candidateCount, TREESTREAM_MAX_PENDING - pending, viewer);
+    for (int i = 0; i < candidateCount && pending < TREESTREAM_MAX_PENDING; i++) {
+        if (stream->residentBytes >= stream->memoryBudget) break;
+        stream->chunks[stream->candidates[i]].state = TREE3D_CHUNK_QUEUED;
+        jobs->queue[jobs->queued++] = stream->candidates[i];
+        pending++;
+    }
+
+#ifdef TREESTREAM_THREADS
+    if (jobs->started) {
+        if (jobs->queued > 0) pthread_cond_signal(&jobs->wake);
+        Tree3DStreamUnlock(jobs);
+        return;
+    }
+#endif
+    while (Tree3DStreamRunJob(jobs)) {}
+    Tree3DStreamUnlock(jobs);
+    Tree3DStreamCollect(stream);
+}
+
+// Block until every queued chunk has grown and collect them, e.g. behind a
+// loading screen or before comparing regrown trees
+void Tree3DStreamWait(Tree3DStream *stream) {
+#ifdef TREESTREAM_THREADS
+    Tree3DStreamJobs *jobs = stream->jobs;
+    pthread_mutex_lock(&jobs->lock);
+    while (jobs->started && (jobs->queued > 0 || jobs->growing >= 0)) {
+        pthread_cond_wait(&jobs->done, &jobs->lock);
+    }
+    pthread_mutex_unlock(&jobs->lock);
+#endif
+    Tree3DStreamCollect(stream);
+}
+
+// The grown trees of the chunk holding (x, z), or NULL with *count 0 while
+// it is not resident. Valid until the next update or add.
+Tree3D* Tree3DStreamGetTrees(Tree3DStream *stream, float x, float z, int *count) {
+    int cx = Tree3DStreamChunkCoord(x, stream->originX, stream->chunkSize, stream->chunksX);
+    int cz = Tree3DStreamChunkCoord(z, stream->originZ, stream->chunkSize, stream->chunksZ);
+    Tree3DStreamChunk *chunk = &stream->chunks[cz * stream->chunksX + cx];
+
+    if (chunk->state != TREE3D_CHUNK_RESIDENT) {
+        if (count) *count = 0;
+        return NULL;
+    }
+    if (count) *count = chunk->count;
+    return chunk->trees;
+}
+
+// Draw the resident chunks within loadRadius of the camera whose bounds
+// pass the frustum, batched into two instanced calls
+void Tree3DStreamDraw(Tree3DStream *stream, Camera3D camera) {
+    float radius = stream->loadRadius;
+    Tree3DFrustum frustum = Tree3DGetCameraFrustum(camera, Tree3DGetScreenAspect(), radius);
+
+    int x0 = Tree3DStreamChunkCoord(camera.position.x - radius, stream->originX, stream->chunkSize, stream->chunksX);
+    int x1 = Tree3DStreamChunkCoord(camera.position.x + radius, stream->originX, stream->chunkSize, stream->chunksX);
+    int z0 = Tree3DStreamChunkCoord(camera.position.z - radius, stream->originZ, stream->chunkSize, stream->chunksZ);
+    int z1 = Tree3DStreamChunkCoord(camera.position.z + radius, stream->originZ, stream->chunkSize, stream->chunksZ);
+
+    Tree3DClearInstanceData(&stream->instanceData);
+    for (int cz = z0; cz <= z1; cz++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            Tree3DStreamChunk *chunk = &stream->chunks[cz * stream->chunksX + cx];
+            if (chunk->state != TREE3D_CHUNK_RESIDENT) continue;
+            if (!Tree3DFrustumContainsBox(&frustum, chunk->bounds)) continue;
+
+            for (int i = 0; i < chunk->count; i++) {
+                Tree3DDrawFrustum(&chunk->trees[i], camera, &frustum, -1, &stream->instanceData);
+            }
+        }
+    }
+    Tree3DDrawInstances(&stream->instanceData);
+}
+
+void Tree3DStreamFree(Tree3DStream *stream) {
+    if (!stream || !stream->jobs) return;
+
+    Tree3DStreamJobs *jobs = stream->jobs;
+#ifdef TREESTREAM_THREADS
+    if (jobs->started) {
+        pthread_mutex_lock(&jobs->lock);
+        jobs->quit = true;
+        pthread_cond_signal(&jobs->wake);
+        pthread_mutex_unlock(&jobs->lock);
+        pthread_join(jobs->worker, NULL);
+    }
+#endif
+
+    // The worker is gone; whatever it finished is resident from here
+    Tree3DStreamCollect(stream);
+#ifdef TREESTREAM_THREADS
+    pthread_mutex_destroy(&jobs->lock);
+    pthread_cond_destroy(&jobs->wake);
+    pthread_cond_destroy(&jobs->done);
+#endif
+    int chunkCount = stream->chunksX * stream->chunksZ;
+    for (int i = 0; i < chunkCount; i++) {
+        Tree3DStreamChunk *chunk = &stream->chunks[i];
+        if (chunk->state == TREE3D_CHUNK_RESIDENT) Tree3DStreamEvict(stream, chunk);
+        TREE3D_FREE(chunk->placed);
+    }
+
+    Tree3DFreeInstanceData(&stream->instanceData);
+    TREE3D_FREE(jobs->ready);
+    TREE3D_FREE(jobs);
+    TREE3D_FREE(stream->candidates);
+    TREE3D_FREE(stream->chunks);
+    *stream = (Tree3DStream){0};
+}
+
+#endif // TREESTREAM_IMPLEMENTATION
+#endif // TREESTREAM_H